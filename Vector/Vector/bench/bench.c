@@ -0,0 +1,425 @@
+// Benchmarks of every vector operation, with the same operations on std::vector as a baseline. Linux only, so they
+// are not part of Vector.vcxproj, which builds the library and the tests. Build from the Vector/Vector directory with:
+//   gcc -O2 -DNDEBUG -std=gnu11 -Iinclude -c src/vector/*.c bench/bench.c bench/vec_bench.c bench/counters.c
+//   g++ -O2 -DNDEBUG -std=c++11 -Iinclude -c bench/std_bench.cpp
+//   g++ *.o -o vec_bench -pthread -lm
+//
+// Each case (operation, access pattern, element size, vector size) runs some warmup repetitions and then measured
+// repetitions, which are timed in batches of operations. The median, 99th percentile and minimum time per operation
+// of the batches are reported. Options:
+//   --suite NAME        Only runs the suite "vector" or "std::vector"
+//   --op NAME           Only runs the operations whose name contains NAME
+//   --data-sizes LIST   Comma separated element sizes, in bytes. Default: 1,2,4,8,16,32,64,128,256
+//   --sizes LIST        Comma separated vector sizes. Default: 16,256,4096,65536,1048576,16777216,100000000
+//   --quick             Vector sizes up to 65536
+//   --reps N            Measured repetitions of each case. Default: 15
+//   --warmup N          Repetitions run before measuring. Default: 2
+//   --max-time SECONDS  Stops repeating a case after this time, once 3 repetitions are measured. Default: 1
+//   --max-bytes N       Skips vectors of more than N bytes. Default: 512 MB
+//   --json PATH         Also writes the results as JSON, to track them over time
+//   --counters          Also reports hardware counters per operation (see counters.h). They are skipped if they are
+//                       not available. Counts include the two clock reads of each batch
+#include "bench.h"
+#include "counters.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+// Bytes touched by the operations of a repetition of BENCH_LINEAR operations
+#define LINEAR_BYTES (64U << 20)
+// Operations timed together for BENCH_CONSTANT operations
+#define CONSTANT_BATCH 64
+
+typedef struct bench_options
+{
+	const char* suite;
+	const char* op;
+	vector* data_sizes;
+	vector* sizes;
+	uint reps;
+	uint warmup;
+	double max_time;
+	unsigned long long max_bytes;
+	const char* json;
+	bench_counters* counters; // NULL if counters are not reported
+} bench_options;
+
+typedef struct bench_result
+{
+	const char* suite;
+	const char* op;
+	bench_pattern pattern;
+	uint data_size;
+	uint size;
+	uint ops;
+	uint samples;
+	double median; // ns per operation
+	double p99;
+	double min;
+	double counters[BENCH_COUNTER_COUNT]; // Events per operation, or -1 if not counted
+} bench_result;
+
+static const char* pattern_names[BENCH_PATTERN_COUNT] = { "-", "front", "back", "random", "interleaved" };
+
+static double now_ns()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+
+	return t.tv_sec* 1e9 + t.tv_nsec;
+}
+
+static int cmp_double(const void* a, const void* b)
+{
+	const double x = *(const double*)a;
+	const double y = *(const double*)b;
+
+	return (x > y) - (x < y);
+}
+
+// Returns the number of operations of each repetition, or 0 if the case is skipped
+static uint case_ops(const bench_op* op, uint size, uint data_size)
+{
+	const unsigned long long bytes = (unsigned long long)size* data_size;
+	unsigned long long ops;
+
+	switch(op->cost)
+	{
+	case BENCH_CONSTANT:
+		ops = BENCH_POSITIONS;
+		break;
+	case BENCH_LINEAR:
+		ops = bytes >= LINEAR_BYTES ? 1 : LINEAR_BYTES / bytes;
+		ops = ops > BENCH_POSITIONS ? BENCH_POSITIONS : ops;
+		break;
+	case BENCH_FILL:
+		ops = size;
+		break;
+	default:
+		ops = 1;
+	}
+
+	if(op->removes != 0 && ops > size / op->removes)
+		ops = size / op->removes;
+
+	return (uint)ops;
+}
+
+static uint case_batch(const bench_op* op, uint ops)
+{
+	switch(op->cost)
+	{
+	case BENCH_CONSTANT:
+		return CONSTANT_BATCH;
+	case BENCH_FILL:
+		return ops;
+	default:
+		return 1;
+	}
+}
+
+// Runs a case and adds its result to results. Returns 0 if the suite does not support it
+static int measure(const bench_suite* suite, const bench_op* op, const bench_case* c, const bench_options* options,
+	vector* results)
+{
+	void* state = op->setup(c);
+
+	if(state == NULL)
+		return 0;
+
+	vector* samples = vecd_create();
+	const uint batch = case_batch(op, c->ops);
+	const uint min_reps = options->reps < 3 ? options->reps : 3;
+	bench_counters* counters = options->counters;
+	double elapsed = 0;
+	double measured_ops = 0;
+
+	if(counters != NULL)
+		bench_counters_reset(counters);
+
+	for(uint rep = 0;rep < options->warmup + options->reps;++rep)
+	{
+		for(uint first = 0;first < c->ops;first += batch)
+		{
+			const uint count = c->ops - first < batch ? c->ops - first : batch;
+			const int measured = rep >= options->warmup;
+
+			if(measured && counters != NULL)
+				bench_counters_start(counters);
+
+			const double start = now_ns();
+			op->run(state, c, first, count);
+			const double time = now_ns() - start;
+
+			if(measured && counters != NULL)
+				bench_counters_stop(counters);
+
+			elapsed += time;
+
+			if(measured)
+			{
+				vecd_push_back(samples, time / count);
+				measured_ops += count;
+			}
+		}
+
+		if(op->reset != NULL)
+			op->reset(state, c);
+
+		if(rep + 1 >= options->warmup + min_reps && elapsed > options->max_time* 1e9)
+			break;
+	}
+
+	op->teardown(state);
+
+	double* times = (double*)samples->buffer;
+	const uint count = samples->size;
+	qsort(times, count, sizeof(double), cmp_double);
+
+	bench_result result;
+	result.suite = suite->name;
+	result.op = op->name;
+	result.pattern = c->pattern;
+	result.data_size = c->data_size;
+	result.size = c->size;
+	result.ops = c->ops;
+	result.samples = count;
+	result.median = times[count / 2];
+	result.p99 = times[(uint)((count - 1)* 0.99)];
+	result.min = times[0];
+
+	for(int i = 0;i < BENCH_COUNTER_COUNT;++i)
+	{
+		const int counted = counters != NULL && bench_counters_has(counters, i);
+		result.counters[i] = counted ? counters->totals[i] / measured_ops : -1;
+	}
+
+	printf("%-12s %-20s %-12s %5u %10u %8u %12.2f %12.2f %12.2f", result.suite, result.op,
+		pattern_names[result.pattern], result.data_size, result.size, result.ops, result.median, result.p99, result.min);
+
+	for(int i = 0;counters != NULL && i < BENCH_COUNTER_COUNT;++i)
+	{
+		if(result.counters[i] < 0)
+			printf(" %13s", "-");
+		else
+			printf(" %13.2f", result.counters[i]);
+	}
+
+	printf("\n");
+	fflush(stdout);
+
+	vec_push_back(results, &result);
+	vec_free(samples);
+
+	return 1;
+}
+
+static void run_suite(const bench_suite* suite, const bench_options* options, const uint* positions, vector* results)
+{
+	for(uint i = 0;i < suite->count;++i)
+	{
+		const bench_op* op = &suite->ops[i];
+
+		if(options->op != NULL && strstr(op->name, options->op) == NULL)
+			continue;
+
+		for(uint d = 0;d < options->data_sizes->size;++d)
+		{
+			const uint data_size = vecui_at_cp(options->data_sizes, d);
+
+			if(op->data_size != 0 && op->data_size != data_size)
+				continue;
+
+			void* element = malloc(data_size);
+			bench_value(element, data_size, 1);
+
+			for(uint s = 0;s < options->sizes->size;++s)
+			{
+				const uint size = vecui_at_cp(options->sizes, s);
+				const uint ops = case_ops(op, size, data_size);
+
+				// Growing and pairs of vectors need up to twice the bytes of the elements
+				if(ops == 0 || (unsigned long long)size* data_size* 2 > options->max_bytes)
+					continue;
+
+				for(int pattern = 0;pattern < BENCH_PATTERN_COUNT;++pattern)
+				{
+					const int supported = op->patterns == 0 ? pattern == BENCH_NONE : (op->patterns >> pattern) & 1;
+
+					if(!supported)
+						continue;
+
+					const bench_case c = { data_size, size, ops, (bench_pattern)pattern, positions, element };
+
+					if(!measure(suite, op, &c, options, results))
+						break;
+				}
+			}
+
+			free(element);
+		}
+	}
+}
+
+static void write_json(const char* path, const bench_options* options, vector* results)
+{
+	FILE* file = fopen(path, "w");
+
+	if(file == NULL)
+	{
+		perror(path);
+		return;
+	}
+
+	fprintf(file, "{\n  \"timestamp\": %lld,\n  \"reps\": %u,\n  \"results\": [\n", (long long)time(NULL), options->reps);
+
+	for(uint i = 0;i < results->size;++i)
+	{
+		const bench_result* r = (const bench_result*)vec_get(results, i);
+
+		fprintf(file, "    {\"suite\": \"%s\", \"op\": \"%s\", \"pattern\": \"%s\", \"data_size\": %u, \"size\": %u, "
+			"\"ops\": %u, \"samples\": %u, \"median_ns\": %.3f, \"p99_ns\": %.3f, \"min_ns\": %.3f",
+			r->suite, r->op, pattern_names[r->pattern], r->data_size, r->size, r->ops, r->samples, r->median, r->p99,
+			r->min);
+
+		// Per operation, null if not counted
+		if(options->counters != NULL)
+		{
+			fprintf(file, ", \"counters\": {");
+
+			for(int j = 0;j < BENCH_COUNTER_COUNT;++j)
+			{
+				fprintf(file, j == 0 ? "\"%s\": " : ", \"%s\": ", bench_counter_names[j]);
+
+				if(r->counters[j] < 0)
+					fprintf(file, "null");
+				else
+					fprintf(file, "%.3f", r->counters[j]);
+			}
+
+			fprintf(file, "}");
+		}
+
+		fprintf(file, "}%s\n", i + 1 < results->size ? "," : "");
+	}
+
+	fprintf(file, "  ]\n}\n");
+	fclose(file);
+}
+
+static void parse_list(vector* list, const char* text)
+{
+	char* end;
+
+	vec_clear(list);
+
+	while(*text != '\0')
+	{
+		vecui_push_back(list, (uint)strtoul(text, &end, 10));
+		text = *end == ',' ? end + 1 : end + strlen(end);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bench_options options = { NULL, NULL, vecui_create(), vecui_create(), 15, 2, 1.0, 512ULL << 20, NULL, NULL };
+	bench_counters counters;
+
+	parse_list(options.data_sizes, "1,2,4,8,16,32,64,128,256");
+	parse_list(options.sizes, "16,256,4096,65536,1048576,16777216,100000000");
+
+	for(int i = 1;i < argc;++i)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i+1] : "";
+
+		if(strcmp(arg, "--quick") == 0)
+		{
+			parse_list(options.sizes, "16,256,4096,65536");
+			continue;
+		}
+
+		if(strcmp(arg, "--counters") == 0)
+		{
+			if(bench_counters_open(&counters) != 0)
+				options.counters = &counters;
+			else
+				fprintf(stderr, "Hardware counters are not available (%s), skipping them\n", strerror(errno));
+
+			continue;
+		}
+
+		if(strcmp(arg, "--suite") == 0)
+			options.suite = value;
+		else if(strcmp(arg, "--op") == 0)
+			options.op = value;
+		else if(strcmp(arg, "--data-sizes") == 0)
+			parse_list(options.data_sizes, value);
+		else if(strcmp(arg, "--sizes") == 0)
+			parse_list(options.sizes, value);
+		else if(strcmp(arg, "--reps") == 0)
+			options.reps = (uint)strtoul(value, NULL, 10);
+		else if(strcmp(arg, "--warmup") == 0)
+			options.warmup = (uint)strtoul(value, NULL, 10);
+		else if(strcmp(arg, "--max-time") == 0)
+			options.max_time = strtod(value, NULL);
+		else if(strcmp(arg, "--max-bytes") == 0)
+			options.max_bytes = strtoull(value, NULL, 10);
+		else if(strcmp(arg, "--json") == 0)
+			options.json = value;
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", arg);
+			return 1;
+		}
+
+		++i;
+	}
+
+	if(options.reps == 0)
+		options.reps = 1;
+
+	// Same positions in every run, so that results can be compared
+	uint positions[BENCH_POSITIONS];
+	uint seed = 2463534242U;
+	for(uint i = 0;i < BENCH_POSITIONS;++i)
+	{
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		positions[i] = seed;
+	}
+
+	const bench_suite* suites[] = { &vec_suite, &std_suite };
+	vector* results = vec_create(sizeof(bench_result));
+
+	printf("%-12s %-20s %-12s %5s %10s %8s %12s %12s %12s", "suite", "op", "pattern", "bytes", "size", "ops",
+		"median ns", "p99 ns", "min ns");
+
+	for(int i = 0;options.counters != NULL && i < BENCH_COUNTER_COUNT;++i)
+	{
+		printf(" %13s", bench_counter_names[i]);
+	}
+
+	printf("\n");
+
+	for(uint i = 0;i < sizeof(suites) / sizeof(suites[0]);++i)
+	{
+		if(options.suite == NULL || strcmp(options.suite, suites[i]->name) == 0)
+			run_suite(suites[i], &options, positions, results);
+	}
+
+	if(options.json != NULL)
+		write_json(options.json, &options, results);
+
+	if(options.counters != NULL)
+		bench_counters_close(options.counters);
+
+	vec_free(results);
+	vec_free(options.sizes);
+	vec_free(options.data_sizes);
+
+	return 0;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "vector/vector.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of precomputed random positions, and maximum number of operations of a repetition of constant time operations
+#define BENCH_POSITIONS 4096
+
+// Positions of the elements accessed by an operation
+typedef enum bench_pattern
+{
+	BENCH_NONE, // The operation has no position
+	BENCH_FRONT, // First element
+	BENCH_BACK, // Last element
+	BENCH_RANDOM, // Uniformly random element
+	BENCH_INTERLEAVED, // Alternates between the front and the back, moving towards the middle
+	BENCH_PATTERN_COUNT
+} bench_pattern;
+
+// Bit mask of every pattern except BENCH_NONE
+#define BENCH_ALL_PATTERNS ((1 << BENCH_FRONT) | (1 << BENCH_BACK) | (1 << BENCH_RANDOM) | (1 << BENCH_INTERLEAVED))
+
+// How many operations make a repetition, and how they are timed
+typedef enum bench_cost
+{
+	BENCH_CONSTANT, // O(1) operations: BENCH_POSITIONS per repetition, timed in batches
+	BENCH_LINEAR, // O(size) operations: as many as fit in a fixed amount of bytes, timed one by one
+	BENCH_FILL, // One operation per element of the vector (e.g. push_back from empty), timed together
+	BENCH_SINGLE // One O(size) operation that needs a reset after it (e.g. shrink_to_fit)
+} bench_cost;
+
+// Parameters of a measured case
+typedef struct bench_case
+{
+	uint data_size; // Size of each element, in bytes
+	uint size; // Number of elements of the vector before each repetition
+	uint ops; // Number of operations of each repetition
+	bench_pattern pattern;
+	const uint* positions; // BENCH_POSITIONS random numbers
+	const void* element; // data_size bytes used as the value of inserted elements
+} bench_case;
+
+typedef struct bench_op
+{
+	const char* name;
+	bench_cost cost;
+	int patterns; // Bit mask of the supported patterns, 0 for BENCH_NONE only
+	uint removes; // Elements removed by each operation, which limits the operations of a repetition to size / removes
+	uint data_size; // Only element size supported, or 0 for any
+	// Creates the state of a case, outside of the measured region. Returns NULL if the case is not supported
+	void* (*setup)(const bench_case* c);
+	// Measured region: runs the operations [first, first + count) of a repetition
+	void (*run)(void* state, const bench_case* c, uint first, uint count);
+	// Restores the state after a repetition, outside of the measured region. May be NULL
+	void (*reset)(void* state, const bench_case* c);
+	void (*teardown)(void* state);
+} bench_op;
+
+// Operations of an implementation
+typedef struct bench_suite
+{
+	const char* name;
+	const bench_op* ops;
+	uint count;
+} bench_suite;
+
+// vector and typed vector operations, from vec_bench.c
+extern const bench_suite vec_suite;
+// std::vector baseline, from std_bench.cpp. Supports power of 2 element sizes up to 256 bytes
+extern const bench_suite std_suite;
+
+// Position of the i-th operation of a repetition in a vector of size elements (size > 0)
+static inline uint bench_pos(const bench_case* c, uint i, uint size)
+{
+	uint k;
+
+	switch(c->pattern)
+	{
+	case BENCH_BACK:
+		return size - 1;
+	case BENCH_RANDOM:
+		return c->positions[i % BENCH_POSITIONS] % size;
+	case BENCH_INTERLEAVED:
+		k = (i / 2) % size;
+		return i % 2 ? size - 1 - k : k;
+	default:
+		return 0;
+	}
+}
+
+// Writes the value of the element at pos of a filled vector: pos in its first bytes, and zeros
+static inline void bench_value(void* element, uint data_size, uint pos)
+{
+	unsigned char* bytes = (unsigned char*)element;
+
+	for(uint i = 0;i < data_size;++i)
+	{
+		bytes[i] = i < sizeof(uint) ? (unsigned char)(pos >> (i* 8)) : 0;
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
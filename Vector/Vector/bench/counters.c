@@ -0,0 +1,157 @@
+#include "counters.h"
+#include <string.h>
+#include <errno.h>
+
+const char* bench_counter_names[BENCH_COUNTER_COUNT] =
+{
+	"cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "dtlb_misses"
+};
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define CACHE_EVENT(cache, op, result) ((cache) | ((op) << 8) | ((result) << 16))
+
+static const struct
+{
+	uint type;
+	unsigned long long config;
+} events[BENCH_COUNTER_COUNT] =
+{
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_TYPE_HW_CACHE, CACHE_EVENT(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	{ PERF_TYPE_HW_CACHE, CACHE_EVENT(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) }
+};
+
+// Layout of a read with PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING
+typedef struct counter_read
+{
+	unsigned long long value;
+	unsigned long long time_enabled;
+	unsigned long long time_running;
+} counter_read;
+
+uint bench_counters_open(bench_counters* counters)
+{
+	int error = 0;
+
+	memset(counters, 0, sizeof(bench_counters));
+
+	for(int i = 0;i < BENCH_COUNTER_COUNT;++i)
+	{
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = events[i].type;
+		attr.config = events[i].config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		counters->fds[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+
+		if(counters->fds[i] >= 0)
+			++counters->count;
+		else if(error == 0)
+			error = errno;
+	}
+
+	if(counters->count == 0)
+		errno = error;
+
+	return counters->count;
+}
+
+void bench_counters_close(bench_counters* counters)
+{
+	for(int i = 0;i < BENCH_COUNTER_COUNT;++i)
+	{
+		if(counters->fds[i] >= 0)
+			close(counters->fds[i]);
+
+		counters->fds[i] = -1;
+	}
+
+	counters->count = 0;
+}
+
+void bench_counters_start(bench_counters* counters)
+{
+	for(int i = 0;i < BENCH_COUNTER_COUNT;++i)
+	{
+		if(counters->fds[i] >= 0)
+		{
+			ioctl(counters->fds[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(counters->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+}
+
+void bench_counters_stop(bench_counters* counters)
+{
+	for(int i = 0;i < BENCH_COUNTER_COUNT;++i)
+	{
+		if(counters->fds[i] >= 0)
+			ioctl(counters->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+	}
+
+	for(int i = 0;i < BENCH_COUNTER_COUNT;++i)
+	{
+		counter_read counter;
+
+		if(counters->fds[i] < 0 || read(counters->fds[i], &counter, sizeof(counter)) != sizeof(counter))
+			continue;
+
+		if(counter.time_running == counter.time_enabled)
+			counters->totals[i] += counter.value;
+		else if(counter.time_running != 0)
+			counters->totals[i] += (unsigned long long)((double)counter.value* counter.time_enabled / counter.time_running);
+	}
+}
+
+#else
+
+uint bench_counters_open(bench_counters* counters)
+{
+	memset(counters, 0, sizeof(bench_counters));
+
+	for(int i = 0;i < BENCH_COUNTER_COUNT;++i)
+	{
+		counters->fds[i] = -1;
+	}
+
+	errno = ENOSYS;
+
+	return 0;
+}
+
+void bench_counters_close(bench_counters* counters)
+{
+}
+
+void bench_counters_start(bench_counters* counters)
+{
+}
+
+void bench_counters_stop(bench_counters* counters)
+{
+}
+
+#endif
+
+void bench_counters_reset(bench_counters* counters)
+{
+	memset(counters->totals, 0, sizeof(counters->totals));
+}
+
+int bench_counters_has(const bench_counters* counters, bench_counter counter)
+{
+	return counters->fds[counter] >= 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "vector/vector.h"
+
+// Hardware performance counters read with perf_event_open
+typedef enum bench_counter
+{
+	BENCH_CYCLES,
+	BENCH_INSTRUCTIONS,
+	BENCH_L1D_MISSES, // L1 data cache read misses
+	BENCH_LLC_MISSES, // Last level cache misses
+	BENCH_BRANCH_MISSES,
+	BENCH_DTLB_MISSES, // Data TLB read misses
+	BENCH_COUNTER_COUNT
+} bench_counter;
+
+extern const char* bench_counter_names[BENCH_COUNTER_COUNT];
+
+// Counters of the calling thread, in user space only. Counters the CPU or the kernel do not support are left out.
+// Counters are not grouped, so that the CPU can time-share them when there are not enough registers: counts are then
+// scaled by the fraction of time each counter was counting
+typedef struct bench_counters
+{
+	int fds[BENCH_COUNTER_COUNT]; // -1 for the counters that could not be opened
+	uint count; // Number of opened counters
+	unsigned long long totals[BENCH_COUNTER_COUNT]; // Scaled counts since the last reset
+} bench_counters;
+
+// Opens the counters. Returns the number of opened counters, 0 if they are not available (e.g. in containers or
+// with a restrictive perf_event_paranoid), in which case errno tells why
+uint bench_counters_open(bench_counters* counters);
+void bench_counters_close(bench_counters* counters);
+// Sets the totals to 0
+void bench_counters_reset(bench_counters* counters);
+// Counts the events between start and stop, and adds them to the totals
+void bench_counters_start(bench_counters* counters);
+void bench_counters_stop(bench_counters* counters);
+// Returns 0 if the counter is not open
+int bench_counters_has(const bench_counters* counters, bench_counter counter);
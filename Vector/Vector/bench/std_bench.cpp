@@ -0,0 +1,324 @@
+#include "bench.h"
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cstring>
+
+// std::vector baseline of the operations of vec_bench.c with the same names. Elements are arrays of data_size
+// bytes compared with memcmp, like the default equal_func of vectors
+
+namespace
+{
+	enum op_id
+	{
+		CREATE_FREE, INIT_DESTROY, RESERVE, RESIZE, RESIZE_VAL, SHRINK_TO_FIT, CLEAR, EMPTY, MAX_SIZE, FIND,
+		FIND_LAST, AT, FRONT, BACK, PUSH_BACK, PUSH_BACK_RESERVED, POP_BACK, INSERT, REPLACE, ERASE, ERASE_RANGE,
+		CMP, CPY, DUP_WRITE, SWAP, MOVE
+	};
+
+	// Elements removed by each erase_range
+	const uint erase_range = 16;
+
+	volatile unsigned char sink;
+
+	template<size_t N> struct element
+	{
+		unsigned char bytes[N];
+
+		bool operator==(const element& other) const
+		{
+			return std::memcmp(bytes, other.bytes, N) == 0;
+		}
+	};
+
+	struct state
+	{
+		virtual ~state() {}
+		virtual void run(op_id op, const bench_case* c, uint first, uint count) = 0;
+		virtual void reset(op_id op, const bench_case* c) = 0;
+	};
+
+	template<size_t N> struct typed_state : state
+	{
+		typedef element<N> T;
+
+		std::vector<T> vec;
+		std::vector<T> other;
+		T value;
+
+		typed_state(op_id op, const bench_case* c)
+		{
+			std::memcpy(value.bytes, c->element, N);
+
+			switch(op)
+			{
+			case CREATE_FREE:
+			case INIT_DESTROY:
+			case RESERVE:
+			case RESIZE:
+			case RESIZE_VAL:
+			case PUSH_BACK:
+				break;
+			case PUSH_BACK_RESERVED:
+				vec.reserve(c->size);
+				break;
+			case SHRINK_TO_FIT:
+				fill(vec, c->size);
+				vec.reserve(c->size* 2);
+				break;
+			case CMP:
+			case CPY:
+			case SWAP:
+				fill(vec, c->size);
+				fill(other, c->size);
+				break;
+			default:
+				fill(vec, c->size);
+			}
+		}
+
+		static void fill(std::vector<T>& v, uint size)
+		{
+			v.resize(size);
+
+			for(uint i = 0;i < size;++i)
+			{
+				bench_value(v[i].bytes, N, i);
+			}
+		}
+
+		void run(op_id op, const bench_case* c, uint first, uint count) override
+		{
+			const uint last = first + count;
+			T target;
+
+			switch(op)
+			{
+			case CREATE_FREE:
+				for(uint i = first;i < last;++i)
+					delete new std::vector<T>();
+				break;
+			case INIT_DESTROY:
+				for(uint i = first;i < last;++i)
+				{
+					std::vector<T> v;
+					sink = (unsigned char)v.empty();
+				}
+				break;
+			case RESERVE:
+				for(uint i = first;i < last;++i)
+				{
+					std::vector<T> v;
+					v.reserve(c->size);
+				}
+				break;
+			case RESIZE:
+				vec.resize(vec.size() + count);
+				break;
+			case RESIZE_VAL:
+				vec.resize(vec.size() + count, value);
+				break;
+			case SHRINK_TO_FIT:
+				vec.shrink_to_fit();
+				break;
+			case CLEAR:
+				vec.clear();
+				break;
+			case EMPTY:
+				for(uint i = first;i < last;++i)
+					sink = (unsigned char)vec.empty();
+				break;
+			case MAX_SIZE:
+				for(uint i = first;i < last;++i)
+					sink = (unsigned char)vec.capacity();
+				break;
+			case FIND:
+				for(uint i = first;i < last;++i)
+				{
+					bench_value(target.bytes, N, bench_pos(c, i, c->size));
+					sink = (unsigned char)(std::find(vec.begin(), vec.end(), target) - vec.begin());
+				}
+				break;
+			case FIND_LAST:
+				for(uint i = first;i < last;++i)
+				{
+					bench_value(target.bytes, N, bench_pos(c, i, c->size));
+					sink = (unsigned char)(std::find(vec.rbegin(), vec.rend(), target) - vec.rbegin());
+				}
+				break;
+			case AT:
+				for(uint i = first;i < last;++i)
+					sink = vec[bench_pos(c, i, c->size)].bytes[0];
+				break;
+			case FRONT:
+				for(uint i = first;i < last;++i)
+					sink = vec.front().bytes[0];
+				break;
+			case BACK:
+				for(uint i = first;i < last;++i)
+					sink = vec.back().bytes[0];
+				break;
+			case PUSH_BACK:
+			case PUSH_BACK_RESERVED:
+				for(uint i = first;i < last;++i)
+					vec.push_back(value);
+				break;
+			case POP_BACK:
+				for(uint i = first;i < last;++i)
+					vec.pop_back();
+				break;
+			case INSERT:
+				for(uint i = first;i < last;++i)
+					vec.insert(vec.begin() + bench_pos(c, i, (uint)vec.size() + 1), value);
+				break;
+			case REPLACE:
+				for(uint i = first;i < last;++i)
+					vec[bench_pos(c, i, c->size)] = value;
+				break;
+			case ERASE:
+				for(uint i = first;i < last;++i)
+					vec.erase(vec.begin() + bench_pos(c, i, (uint)vec.size()));
+				break;
+			case ERASE_RANGE:
+				for(uint i = first;i < last;++i)
+				{
+					const uint pos = bench_pos(c, i, (uint)vec.size() - erase_range + 1);
+					vec.erase(vec.begin() + pos, vec.begin() + pos + erase_range);
+				}
+				break;
+			case CMP:
+				for(uint i = first;i < last;++i)
+					sink = (unsigned char)(vec == other);
+				break;
+			case CPY:
+				for(uint i = first;i < last;++i)
+					std::copy(vec.begin(), vec.end(), other.begin());
+				break;
+			case DUP_WRITE:
+				for(uint i = first;i < last;++i)
+				{
+					std::vector<T> dup(vec);
+					sink = dup[0].bytes[0];
+				}
+				break;
+			case SWAP:
+				for(uint i = first;i < last;++i)
+					vec.swap(other);
+				break;
+			case MOVE:
+				for(uint i = first;i < last;++i)
+				{
+					if(i % 2 == 0)
+						other = std::move(vec);
+					else
+						vec = std::move(other);
+				}
+				break;
+			}
+		}
+
+		void reset(op_id op, const bench_case* c) override
+		{
+			switch(op)
+			{
+			case RESIZE:
+			case RESIZE_VAL:
+			case PUSH_BACK:
+				std::vector<T>().swap(vec);
+				break;
+			case PUSH_BACK_RESERVED:
+				vec.clear();
+				break;
+			case SHRINK_TO_FIT:
+				vec.resize(c->size);
+				vec.reserve(c->size* 2);
+				break;
+			case CLEAR:
+			case POP_BACK:
+			case INSERT:
+			case ERASE:
+			case ERASE_RANGE:
+				vec.resize(c->size);
+				break;
+			case MOVE:
+				if(vec.empty())
+					vec = std::move(other);
+				break;
+			default:
+				break;
+			}
+		}
+	};
+
+	state* create_state(op_id op, const bench_case* c)
+	{
+		switch(c->data_size)
+		{
+		case 1: return new typed_state<1>(op, c);
+		case 2: return new typed_state<2>(op, c);
+		case 4: return new typed_state<4>(op, c);
+		case 8: return new typed_state<8>(op, c);
+		case 16: return new typed_state<16>(op, c);
+		case 32: return new typed_state<32>(op, c);
+		case 64: return new typed_state<64>(op, c);
+		case 128: return new typed_state<128>(op, c);
+		case 256: return new typed_state<256>(op, c);
+		default: return nullptr;
+		}
+	}
+
+	template<op_id op> void* setup(const bench_case* c)
+	{
+		return create_state(op, c);
+	}
+
+	template<op_id op> void run(void* s, const bench_case* c, uint first, uint count)
+	{
+		static_cast<state*>(s)->run(op, c, first, count);
+	}
+
+	template<op_id op> void reset(void* s, const bench_case* c)
+	{
+		static_cast<state*>(s)->reset(op, c);
+	}
+
+	void teardown(void* s)
+	{
+		delete static_cast<state*>(s);
+	}
+
+#define ENTRY(name, op, cost, patterns, removes) \
+	{ name, cost, patterns, removes, 0, setup<op>, run<op>, reset<op>, teardown }
+
+	const bench_op ops[] =
+	{
+		ENTRY("create_free", CREATE_FREE, BENCH_CONSTANT, 0, 0),
+		ENTRY("init_destroy", INIT_DESTROY, BENCH_CONSTANT, 0, 0),
+		ENTRY("reserve", RESERVE, BENCH_CONSTANT, 0, 0),
+		ENTRY("resize", RESIZE, BENCH_FILL, 0, 0),
+		ENTRY("resize_val", RESIZE_VAL, BENCH_FILL, 0, 0),
+		ENTRY("shrink_to_fit", SHRINK_TO_FIT, BENCH_SINGLE, 0, 0),
+		ENTRY("clear", CLEAR, BENCH_SINGLE, 0, 0),
+		ENTRY("empty", EMPTY, BENCH_CONSTANT, 0, 0),
+		ENTRY("max_size", MAX_SIZE, BENCH_CONSTANT, 0, 0),
+		ENTRY("find", FIND, BENCH_LINEAR, BENCH_ALL_PATTERNS, 0),
+		ENTRY("find_last", FIND_LAST, BENCH_LINEAR, BENCH_ALL_PATTERNS, 0),
+		ENTRY("at", AT, BENCH_CONSTANT, BENCH_ALL_PATTERNS, 0),
+		ENTRY("front", FRONT, BENCH_CONSTANT, 0, 0),
+		ENTRY("back", BACK, BENCH_CONSTANT, 0, 0),
+		ENTRY("push_back", PUSH_BACK, BENCH_FILL, 0, 0),
+		ENTRY("push_back_reserved", PUSH_BACK_RESERVED, BENCH_FILL, 0, 0),
+		ENTRY("pop_back", POP_BACK, BENCH_CONSTANT, 0, 1),
+		ENTRY("insert", INSERT, BENCH_LINEAR, BENCH_ALL_PATTERNS, 0),
+		ENTRY("replace", REPLACE, BENCH_CONSTANT, BENCH_ALL_PATTERNS, 0),
+		ENTRY("erase", ERASE, BENCH_LINEAR, BENCH_ALL_PATTERNS, 1),
+		ENTRY("erase_range", ERASE_RANGE, BENCH_LINEAR, BENCH_ALL_PATTERNS, erase_range),
+		ENTRY("cmp", CMP, BENCH_LINEAR, 0, 0),
+		ENTRY("cpy", CPY, BENCH_LINEAR, 0, 0),
+		ENTRY("dup_write", DUP_WRITE, BENCH_LINEAR, 0, 0),
+		ENTRY("swap", SWAP, BENCH_CONSTANT, 0, 0),
+		ENTRY("move", MOVE, BENCH_CONSTANT, 0, 0)
+	};
+}
+
+extern "C" const bench_suite std_suite = { "std::vector", ops, sizeof(ops) / sizeof(ops[0]) };
@@ -0,0 +1,648 @@
+#include "bench.h"
+#include <stdlib.h>
+#include <memory.h>
+
+// Operations on vectors of any element size, and on the typed vectors. The values of the elements are their positions
+// (see bench_value), so vectors of 1 byte elements repeat values every 256 elements and find stops earlier
+
+// Elements removed by each erase_range
+#define ERASE_RANGE 16
+
+typedef struct vec_state
+{
+	vector vec;
+	vector other; // Second vector of cmp, cpy, swap and move
+	void* element; // Scratch element
+} vec_state;
+
+// Read by the operations that return elements, so that they are not optimized away
+static volatile unsigned char sink;
+
+static vec_state* create_state(const bench_case* c)
+{
+	vec_state* state = (vec_state*)malloc(sizeof(vec_state));
+
+	vec_init(&state->vec, c->data_size);
+	vec_init(&state->other, c->data_size);
+	state->element = malloc(c->data_size);
+
+	return state;
+}
+
+static void fill(vector* vec, uint size)
+{
+	vec_resize(vec, size);
+
+	for(uint i = 0;i < size;++i)
+	{
+		bench_value((char*)vec->buffer + i* vec->data_size, vec->data_size, i);
+	}
+}
+
+static void* setup_empty(const bench_case* c)
+{
+	return create_state(c);
+}
+
+static void* setup_filled(const bench_case* c)
+{
+	vec_state* state = create_state(c);
+
+	fill(&state->vec, c->size);
+
+	return state;
+}
+
+static void* setup_pair(const bench_case* c)
+{
+	vec_state* state = setup_filled(c);
+
+	fill(&state->other, c->size);
+
+	return state;
+}
+
+static void* setup_reserved(const bench_case* c)
+{
+	vec_state* state = create_state(c);
+
+	vec_reserve(&state->vec, c->size);
+
+	return state;
+}
+
+static void* setup_oversized(const bench_case* c)
+{
+	vec_state* state = setup_filled(c);
+
+	vec_reserve(&state->vec, c->size* 2);
+
+	return state;
+}
+
+static void reset_empty(void* s, const bench_case* c)
+{
+	vec_state* state = s;
+
+	vec_destroy(&state->vec);
+	vec_init(&state->vec, c->data_size);
+}
+
+static void reset_clear(void* s, const bench_case* c)
+{
+	vec_clear(&((vec_state*)s)->vec);
+}
+
+// Elements restored by growing keep the values they had before being removed
+static void reset_size(void* s, const bench_case* c)
+{
+	vec_resize(&((vec_state*)s)->vec, c->size);
+}
+
+static void reset_oversized(void* s, const bench_case* c)
+{
+	vec_state* state = s;
+
+	vec_resize(&state->vec, c->size);
+	vec_reserve(&state->vec, c->size* 2);
+}
+
+static void teardown(void* s)
+{
+	vec_state* state = s;
+
+	vec_destroy(&state->vec);
+	vec_destroy(&state->other);
+	free(state->element);
+	free(state);
+}
+
+// =========================== OPERATIONS =========================
+
+static void run_create_free(void* s, const bench_case* c, uint first, uint count)
+{
+	for(uint i = 0;i < count;++i)
+	{
+		vec_free(vec_create(c->data_size));
+	}
+}
+
+static void run_init_destroy(void* s, const bench_case* c, uint first, uint count)
+{
+	vector vec;
+
+	for(uint i = 0;i < count;++i)
+	{
+		vec_init(&vec, c->data_size);
+		vec_destroy(&vec);
+	}
+}
+
+static void run_reserve(void* s, const bench_case* c, uint first, uint count)
+{
+	vector vec;
+
+	for(uint i = 0;i < count;++i)
+	{
+		vec_init(&vec, c->data_size);
+		vec_reserve(&vec, c->size);
+		vec_destroy(&vec);
+	}
+}
+
+static void run_resize(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	vec_resize(vec, vec->size + count);
+}
+
+static void run_resize_val(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	vec_resize_val(vec, vec->size + count, c->element);
+}
+
+static void run_shrink_to_fit(void* s, const bench_case* c, uint first, uint count)
+{
+	vec_shrink_to_fit(&((vec_state*)s)->vec);
+}
+
+static void run_clear(void* s, const bench_case* c, uint first, uint count)
+{
+	vec_clear(&((vec_state*)s)->vec);
+}
+
+static void run_empty(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = 0;i < count;++i)
+	{
+		sink = (unsigned char)vec_empty(vec);
+	}
+}
+
+static void run_max_size(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = 0;i < count;++i)
+	{
+		sink = (unsigned char)vec_max_size(vec);
+	}
+}
+
+static void run_find(void* s, const bench_case* c, uint first, uint count)
+{
+	vec_state* state = s;
+
+	for(uint i = first;i < first + count;++i)
+	{
+		bench_value(state->element, c->data_size, bench_pos(c, i, c->size));
+		sink = (unsigned char)vec_find(&state->vec, state->element, 0);
+	}
+}
+
+static void run_find_last(void* s, const bench_case* c, uint first, uint count)
+{
+	vec_state* state = s;
+
+	for(uint i = first;i < first + count;++i)
+	{
+		bench_value(state->element, c->data_size, bench_pos(c, i, c->size));
+		sink = (unsigned char)vec_find_last(&state->vec, state->element, 0);
+	}
+}
+
+static void run_has(void* s, const bench_case* c, uint first, uint count)
+{
+	vec_state* state = s;
+
+	for(uint i = first;i < first + count;++i)
+	{
+		bench_value(state->element, c->data_size, bench_pos(c, i, c->size));
+		sink = (unsigned char)vec_has(&state->vec, state->element);
+	}
+}
+
+static void run_at(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = first;i < first + count;++i)
+	{
+		sink = *(unsigned char*)vec_at(vec, bench_pos(c, i, c->size));
+	}
+}
+
+static void run_get(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = first;i < first + count;++i)
+	{
+		sink = *(const unsigned char*)vec_get(vec, bench_pos(c, i, c->size));
+	}
+}
+
+static void run_at_cp(void* s, const bench_case* c, uint first, uint count)
+{
+	vec_state* state = s;
+
+	for(uint i = first;i < first + count;++i)
+	{
+		vec_at_cp(&state->vec, bench_pos(c, i, c->size), state->element);
+		sink = *(unsigned char*)state->element;
+	}
+}
+
+static void run_front(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = 0;i < count;++i)
+	{
+		sink = *(unsigned char*)vec_front(vec);
+	}
+}
+
+static void run_front_cp(void* s, const bench_case* c, uint first, uint count)
+{
+	vec_state* state = s;
+
+	for(uint i = 0;i < count;++i)
+	{
+		vec_front_cp(&state->vec, state->element);
+		sink = *(unsigned char*)state->element;
+	}
+}
+
+static void run_back(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = 0;i < count;++i)
+	{
+		sink = *(unsigned char*)vec_back(vec);
+	}
+}
+
+static void run_back_cp(void* s, const bench_case* c, uint first, uint count)
+{
+	vec_state* state = s;
+
+	for(uint i = 0;i < count;++i)
+	{
+		vec_back_cp(&state->vec, state->element);
+		sink = *(unsigned char*)state->element;
+	}
+}
+
+static void run_push_back(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = 0;i < count;++i)
+	{
+		vec_push_back(vec, (void*)c->element);
+	}
+}
+
+static void run_pop_back(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = 0;i < count;++i)
+	{
+		vec_pop_back(vec);
+	}
+}
+
+static void run_insert(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = first;i < first + count;++i)
+	{
+		vec_insert(vec, bench_pos(c, i, vec->size + 1), (void*)c->element);
+	}
+}
+
+static void run_replace(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = first;i < first + count;++i)
+	{
+		vec_replace(vec, bench_pos(c, i, c->size), (void*)c->element);
+	}
+}
+
+static void run_erase(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = first;i < first + count;++i)
+	{
+		vec_erase(vec, bench_pos(c, i, vec->size));
+	}
+}
+
+static void run_erase_range(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = first;i < first + count;++i)
+	{
+		const uint pos = bench_pos(c, i, vec->size - ERASE_RANGE + 1);
+		vec_erase_range(vec, pos, pos + ERASE_RANGE);
+	}
+}
+
+static void run_cmp(void* s, const bench_case* c, uint first, uint count)
+{
+	vec_state* state = s;
+
+	for(uint i = 0;i < count;++i)
+	{
+		sink = (unsigned char)vec_cmp(&state->vec, &state->other);
+	}
+}
+
+static void run_cpy(void* s, const bench_case* c, uint first, uint count)
+{
+	vec_state* state = s;
+
+	for(uint i = 0;i < count;++i)
+	{
+		vec_cpy(&state->vec, &state->other, 0, c->size, 0);
+	}
+}
+
+// Duplicates share the elements until one of them is modified
+static void run_dup(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = 0;i < count;++i)
+	{
+		vec_free(vec_dup(vec, 0, c->size));
+	}
+}
+
+static void run_dup_write(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = 0;i < count;++i)
+	{
+		vector* dup = vec_dup(vec, 0, c->size);
+		sink = *(unsigned char*)vec_at(dup, 0);
+		vec_free(dup);
+	}
+}
+
+static void run_swap(void* s, const bench_case* c, uint first, uint count)
+{
+	vec_state* state = s;
+
+	for(uint i = 0;i < count;++i)
+	{
+		vec_swap(&state->vec, &state->other);
+	}
+}
+
+// Moves back and forth, so that the vector always has its elements after a repetition
+static void run_move(void* s, const bench_case* c, uint first, uint count)
+{
+	vec_state* state = s;
+
+	for(uint i = first;i < first + count;++i)
+	{
+		if(i % 2 == 0)
+			vec_move(&state->other, &state->vec);
+		else
+			vec_move(&state->vec, &state->other);
+	}
+}
+
+static void reset_move(void* s, const bench_case* c)
+{
+	vec_state* state = s;
+
+	if(state->vec.size == 0)
+		vec_move(&state->vec, &state->other);
+}
+
+static void run_release_adopt(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = 0;i < count;++i)
+	{
+		const uint capacity = vec->capacity / vec->data_size;
+		uint size;
+		void* buffer = vec_release(vec, &size);
+		vec_adopt(vec, buffer, size, capacity, free_buffer);
+	}
+}
+
+static void run_slice(void* s, const bench_case* c, uint first, uint count)
+{
+	vector* vec = &((vec_state*)s)->vec;
+
+	for(uint i = first;i < first + count;++i)
+	{
+		const uint pos = bench_pos(c, i, c->size);
+		sink = (unsigned char)vec_slice(vec, pos, c->size - pos).size;
+	}
+}
+
+static void run_view_at(void* s, const bench_case* c, uint first, uint count)
+{
+	const vec_view view = vec_slice(&((vec_state*)s)->vec, 0, c->size);
+
+	for(uint i = first;i < first + count;++i)
+	{
+		sink = *(const unsigned char*)vec_view_at(view, bench_pos(c, i, c->size));
+	}
+}
+
+static void run_view_find(void* s, const bench_case* c, uint first, uint count)
+{
+	vec_state* state = s;
+	const vec_view view = vec_slice(&state->vec, 0, c->size);
+
+	for(uint i = first;i < first + count;++i)
+	{
+		bench_value(state->element, c->data_size, bench_pos(c, i, c->size));
+		sink = (unsigned char)vec_view_find(view, state->element, 0);
+	}
+}
+
+static void run_view_cmp(void* s, const bench_case* c, uint first, uint count)
+{
+	vec_state* state = s;
+	const vec_view v1 = vec_slice(&state->vec, 0, c->size);
+	const vec_view v2 = vec_slice(&state->other, 0, c->size);
+
+	for(uint i = 0;i < count;++i)
+	{
+		sink = (unsigned char)vec_view_cmp(v1, v2);
+	}
+}
+
+static void run_view_dup(void* s, const bench_case* c, uint first, uint count)
+{
+	const vec_view view = vec_slice(&((vec_state*)s)->vec, 0, c->size);
+
+	for(uint i = 0;i < count;++i)
+	{
+		vec_free(vec_view_dup(view));
+	}
+}
+
+// =========================== TYPED VECTORS =========================
+
+// Operations of the typed vector vecT of elements of type, whose values are converted from bench_value
+#define TYPED_OPS(T, type) \
+static void run_##T##_push_back(void* s, const bench_case* c, uint first, uint count) \
+{ \
+	vector* vec = &((vec_state*)s)->vec; \
+	type value; \
+	bench_value(&value, sizeof(type), 1); \
+	for(uint i = 0;i < count;++i) \
+	{ \
+		T##_push_back(vec, value); \
+	} \
+} \
+static void run_##T##_resize_val(void* s, const bench_case* c, uint first, uint count) \
+{ \
+	vector* vec = &((vec_state*)s)->vec; \
+	type value; \
+	bench_value(&value, sizeof(type), 1); \
+	T##_resize_val(vec, vec->size + count, value); \
+} \
+static void run_##T##_at(void* s, const bench_case* c, uint first, uint count) \
+{ \
+	vector* vec = &((vec_state*)s)->vec; \
+	for(uint i = first;i < first + count;++i) \
+	{ \
+		sink = (unsigned char)*T##_at(vec, bench_pos(c, i, c->size)); \
+	} \
+} \
+static void run_##T##_at_cp(void* s, const bench_case* c, uint first, uint count) \
+{ \
+	vector* vec = &((vec_state*)s)->vec; \
+	for(uint i = first;i < first + count;++i) \
+	{ \
+		sink = (unsigned char)T##_at_cp(vec, bench_pos(c, i, c->size)); \
+	} \
+} \
+static void run_##T##_find(void* s, const bench_case* c, uint first, uint count) \
+{ \
+	vector* vec = &((vec_state*)s)->vec; \
+	type value; \
+	for(uint i = first;i < first + count;++i) \
+	{ \
+		bench_value(&value, sizeof(type), bench_pos(c, i, c->size)); \
+		sink = (unsigned char)T##_find(vec, value, 0); \
+	} \
+} \
+static void run_##T##_insert(void* s, const bench_case* c, uint first, uint count) \
+{ \
+	vector* vec = &((vec_state*)s)->vec; \
+	type value; \
+	bench_value(&value, sizeof(type), 1); \
+	for(uint i = first;i < first + count;++i) \
+	{ \
+		T##_insert(vec, bench_pos(c, i, vec->size + 1), value); \
+	} \
+} \
+static void run_##T##_replace(void* s, const bench_case* c, uint first, uint count) \
+{ \
+	vector* vec = &((vec_state*)s)->vec; \
+	type value; \
+	bench_value(&value, sizeof(type), 1); \
+	for(uint i = first;i < first + count;++i) \
+	{ \
+		T##_replace(vec, bench_pos(c, i, c->size), value); \
+	} \
+}
+
+TYPED_OPS(vecc, char)
+TYPED_OPS(vecuc, unsigned char)
+TYPED_OPS(vecs, short)
+TYPED_OPS(vecus, unsigned short)
+TYPED_OPS(veci, int)
+TYPED_OPS(vecui, unsigned int)
+TYPED_OPS(vecl, long)
+TYPED_OPS(vecul, unsigned long)
+TYPED_OPS(vecf, float)
+TYPED_OPS(vecd, double)
+
+#define TYPED_ENTRIES(T, type) \
+	{ #T "_push_back", BENCH_FILL, 0, 0, sizeof(type), setup_empty, run_##T##_push_back, reset_empty, teardown }, \
+	{ #T "_resize_val", BENCH_FILL, 0, 0, sizeof(type), setup_empty, run_##T##_resize_val, reset_empty, teardown }, \
+	{ #T "_at", BENCH_CONSTANT, BENCH_ALL_PATTERNS, 0, sizeof(type), setup_filled, run_##T##_at, NULL, teardown }, \
+	{ #T "_at_cp", BENCH_CONSTANT, BENCH_ALL_PATTERNS, 0, sizeof(type), setup_filled, run_##T##_at_cp, NULL, teardown }, \
+	{ #T "_find", BENCH_LINEAR, BENCH_ALL_PATTERNS, 0, sizeof(type), setup_filled, run_##T##_find, NULL, teardown }, \
+	{ #T "_insert", BENCH_LINEAR, BENCH_ALL_PATTERNS, 0, sizeof(type), setup_filled, run_##T##_insert, reset_size, teardown }, \
+	{ #T "_replace", BENCH_CONSTANT, BENCH_ALL_PATTERNS, 0, sizeof(type), setup_filled, run_##T##_replace, NULL, teardown }
+
+// name, cost, patterns, removes, data_size, setup, run, reset, teardown
+static const bench_op ops[] =
+{
+	{ "create_free", BENCH_CONSTANT, 0, 0, 0, setup_empty, run_create_free, NULL, teardown },
+	{ "init_destroy", BENCH_CONSTANT, 0, 0, 0, setup_empty, run_init_destroy, NULL, teardown },
+	{ "reserve", BENCH_CONSTANT, 0, 0, 0, setup_empty, run_reserve, NULL, teardown },
+	{ "resize", BENCH_FILL, 0, 0, 0, setup_empty, run_resize, reset_empty, teardown },
+	{ "resize_val", BENCH_FILL, 0, 0, 0, setup_empty, run_resize_val, reset_empty, teardown },
+	{ "shrink_to_fit", BENCH_SINGLE, 0, 0, 0, setup_oversized, run_shrink_to_fit, reset_oversized, teardown },
+	{ "clear", BENCH_SINGLE, 0, 0, 0, setup_filled, run_clear, reset_size, teardown },
+	{ "empty", BENCH_CONSTANT, 0, 0, 0, setup_filled, run_empty, NULL, teardown },
+	{ "max_size", BENCH_CONSTANT, 0, 0, 0, setup_filled, run_max_size, NULL, teardown },
+	{ "find", BENCH_LINEAR, BENCH_ALL_PATTERNS, 0, 0, setup_filled, run_find, NULL, teardown },
+	{ "find_last", BENCH_LINEAR, BENCH_ALL_PATTERNS, 0, 0, setup_filled, run_find_last, NULL, teardown },
+	{ "has", BENCH_LINEAR, BENCH_ALL_PATTERNS, 0, 0, setup_filled, run_has, NULL, teardown },
+	{ "at", BENCH_CONSTANT, BENCH_ALL_PATTERNS, 0, 0, setup_filled, run_at, NULL, teardown },
+	{ "get", BENCH_CONSTANT, BENCH_ALL_PATTERNS, 0, 0, setup_filled, run_get, NULL, teardown },
+	{ "at_cp", BENCH_CONSTANT, BENCH_ALL_PATTERNS, 0, 0, setup_filled, run_at_cp, NULL, teardown },
+	{ "front", BENCH_CONSTANT, 0, 0, 0, setup_filled, run_front, NULL, teardown },
+	{ "front_cp", BENCH_CONSTANT, 0, 0, 0, setup_filled, run_front_cp, NULL, teardown },
+	{ "back", BENCH_CONSTANT, 0, 0, 0, setup_filled, run_back, NULL, teardown },
+	{ "back_cp", BENCH_CONSTANT, 0, 0, 0, setup_filled, run_back_cp, NULL, teardown },
+	{ "push_back", BENCH_FILL, 0, 0, 0, setup_empty, run_push_back, reset_empty, teardown },
+	{ "push_back_reserved", BENCH_FILL, 0, 0, 0, setup_reserved, run_push_back, reset_clear, teardown },
+	{ "pop_back", BENCH_CONSTANT, 0, 1, 0, setup_filled, run_pop_back, reset_size, teardown },
+	{ "insert", BENCH_LINEAR, BENCH_ALL_PATTERNS, 0, 0, setup_filled, run_insert, reset_size, teardown },
+	{ "replace", BENCH_CONSTANT, BENCH_ALL_PATTERNS, 0, 0, setup_filled, run_replace, NULL, teardown },
+	{ "erase", BENCH_LINEAR, BENCH_ALL_PATTERNS, 1, 0, setup_filled, run_erase, reset_size, teardown },
+	{ "erase_range", BENCH_LINEAR, BENCH_ALL_PATTERNS, ERASE_RANGE, 0, setup_filled, run_erase_range, reset_size, teardown },
+	{ "cmp", BENCH_LINEAR, 0, 0, 0, setup_pair, run_cmp, NULL, teardown },
+	{ "cpy", BENCH_LINEAR, 0, 0, 0, setup_pair, run_cpy, NULL, teardown },
+	{ "dup", BENCH_CONSTANT, 0, 0, 0, setup_filled, run_dup, NULL, teardown },
+	{ "dup_write", BENCH_LINEAR, 0, 0, 0, setup_filled, run_dup_write, NULL, teardown },
+	{ "swap", BENCH_CONSTANT, 0, 0, 0, setup_pair, run_swap, NULL, teardown },
+	{ "move", BENCH_CONSTANT, 0, 0, 0, setup_filled, run_move, reset_move, teardown },
+	{ "release_adopt", BENCH_CONSTANT, 0, 0, 0, setup_filled, run_release_adopt, NULL, teardown },
+	{ "slice", BENCH_CONSTANT, BENCH_ALL_PATTERNS, 0, 0, setup_filled, run_slice, NULL, teardown },
+	{ "view_at", BENCH_CONSTANT, BENCH_ALL_PATTERNS, 0, 0, setup_filled, run_view_at, NULL, teardown },
+	{ "view_find", BENCH_LINEAR, BENCH_ALL_PATTERNS, 0, 0, setup_filled, run_view_find, NULL, teardown },
+	{ "view_cmp", BENCH_LINEAR, 0, 0, 0, setup_pair, run_view_cmp, NULL, teardown },
+	{ "view_dup", BENCH_LINEAR, 0, 0, 0, setup_filled, run_view_dup, NULL, teardown },
+	TYPED_ENTRIES(vecc, char),
+	TYPED_ENTRIES(vecuc, unsigned char),
+	TYPED_ENTRIES(vecs, short),
+	TYPED_ENTRIES(vecus, unsigned short),
+	TYPED_ENTRIES(veci, int),
+	TYPED_ENTRIES(vecui, unsigned int),
+	TYPED_ENTRIES(vecl, long),
+	TYPED_ENTRIES(vecul, unsigned long),
+	TYPED_ENTRIES(vecf, float),
+	TYPED_ENTRIES(vecd, double)
+};
+
+const bench_suite vec_suite = { "vector", ops, sizeof(ops) / sizeof(ops[0]) };
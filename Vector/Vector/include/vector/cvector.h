@@ -0,0 +1,79 @@
+#pragma once
+#include "vector.h"
+#include <stdatomic.h>
+
+// Maximum number of reader threads registered at the same time
+#define CVEC_MAX_READERS 64
+
+// Storage of a cvector. The elements follow the header
+typedef struct cvec_buffer
+{
+	uint capacity; // Number of elements the buffer can hold
+	uint retired_epoch; // Epoch in which the buffer was replaced by a bigger one
+	struct cvec_buffer* next; // Next retired buffer
+} cvec_buffer;
+
+// Vector for read-mostly data, with one writer and many concurrent readers. Readers never take a lock:
+// element reads are validated with a sequence counter and retried if the writer modified the vector
+// meanwhile. The writer prepares reallocations, and inserts and erases that shift elements, in a new buffer,
+// then publishes it in a short write section, so readers only wait for single element writes. Replaced buffers
+// are only freed once no reader can still be using them (epoch-based reclamation), so readers may keep scanning
+// an old buffer while the writer grows the vector.
+//
+// Only one thread may call the modifying functions at a time
+typedef struct cvector
+{
+	_Atomic(cvec_buffer*) current; // Buffer holding the elements
+	atomic_uint size; // Number of elements in the vector
+	atomic_uint seq; // Odd while the writer is modifying the elements
+	atomic_uint epoch; // Current epoch, increased each time a buffer is retired
+	atomic_uint readers[CVEC_MAX_READERS]; // Epoch in which each reader entered, or 0 if it is not reading
+	cvec_buffer* retired; // Replaced buffers that readers might still be using. Writer only
+	uint data_size; // Size of each element, in bytes
+	alloc_function alloc_func; // Function used to allocate buffers
+	free_function free_func; // Function used to free buffers
+	equal_function equal_func; // Function used to compare values of the vector
+} cvector;
+
+// Allocates a new concurrent vector dynamically and initializes it
+cvector* cvec_create(uint data_size);
+// Free the vector and its data storage. No thread may be using it
+void cvec_free(cvector* cv);
+// Initializes the vector with default parameters
+void cvec_init(cvector* cv, uint data_size);
+// Releases the data storage of a vector initialized with cvec_init. No thread may be using it
+void cvec_destroy(cvector* cv);
+
+// =========================== READERS ===================================
+//
+// Each reader thread uses its own slot, in [0, CVEC_MAX_READERS). Reads must happen between
+// cvec_read_begin and cvec_read_end, which are wait-free
+
+// Marks the reader as active, so buffers it may see are not freed
+void cvec_read_begin(cvector* cv, uint reader);
+// Marks the reader as idle
+void cvec_read_end(cvector* cv, uint reader);
+// Returns the number of elements in the vector
+uint cvec_size(cvector* cv);
+// Copies the element at pos into element. Returns 0 if pos is out of range
+int cvec_at_cp(cvector* cv, uint pos, void* element);
+// Returns the first position of the element in the vector, starting the search from offset.
+// If the element is not found, VEC_NPOS is returned
+uint cvec_find(cvector* cv, const void* element, uint offset);
+// Copies a consistent snapshot of all the elements to vec, replacing its contents, and returns vec
+vector* cvec_to_vec(cvector* cv, vector* vec);
+
+// =========================== WRITER ===================================
+
+// Requests that the vector capacity be at least enough to contain n elements
+void cvec_reserve(cvector* cv, uint new_size);
+// Add element at the end. The value is copied to the vector
+void cvec_push_back(cvector* cv, const void* element);
+// Inserts element before the element at pos
+void cvec_insert(cvector* cv, uint pos, const void* element);
+// Set the element given at pos
+void cvec_replace(cvector* cv, uint pos, const void* element);
+// Removes from the vector the element at pos
+void cvec_erase(cvector* cv, uint pos);
+// Frees the retired buffers no reader can be using anymore. Called automatically after reallocations
+void cvec_reclaim(cvector* cv);
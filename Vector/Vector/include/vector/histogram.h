@@ -0,0 +1,47 @@
+#pragma once
+#include "vector.h"
+#include <stdio.h>
+#include <stdatomic.h>
+
+// Linear sub-buckets of each power of 2, which bounds the relative error of the recorded values to 1/32
+#define VEC_HISTOGRAM_SUB_BITS 5
+#define VEC_HISTOGRAM_BUCKETS ((64 - VEC_HISTOGRAM_SUB_BITS + 1) << VEC_HISTOGRAM_SUB_BITS)
+
+// Lock-free histogram of 64 bit values (e.g. latencies in ns) with logarithmic buckets, like HdrHistogram.
+// Values can be recorded and read from any thread at the same time: reads are then a consistent
+// approximation that may miss the values being recorded
+typedef struct vec_histogram
+{
+	atomic_ullong buckets[VEC_HISTOGRAM_BUCKETS];
+	atomic_ullong count;
+	atomic_ullong sum;
+	atomic_ullong max;
+} vec_histogram;
+
+// Allocates a new histogram dynamically and initializes it
+vec_histogram* vec_histogram_create();
+// Frees the histogram allocated with vec_histogram_create
+void vec_histogram_free(vec_histogram* h);
+// Initializes the histogram, with no values
+void vec_histogram_init(vec_histogram* h);
+// Removes all the values. Values recorded at the same time may be lost or partially kept
+void vec_histogram_reset(vec_histogram* h);
+// Records a value
+void vec_histogram_record(vec_histogram* h, unsigned long long value);
+// Returns the number of recorded values
+unsigned long long vec_histogram_count(vec_histogram* h);
+// Returns the mean of the recorded values, or 0
+double vec_histogram_mean(vec_histogram* h);
+// Returns the largest recorded value
+unsigned long long vec_histogram_max(vec_histogram* h);
+// Returns the value below or equal to which are percentile% (0 to 100) of the recorded values, within the precision of
+// the buckets, or 0 if there are no values
+unsigned long long vec_histogram_percentile(vec_histogram* h, double percentile);
+// Writes the count, mean, percentiles 50, 90, 99, 99.9 and max of the histogram
+void vec_histogram_print(vec_histogram* h, FILE* file, const char* name);
+
+// realloc_hook_function that records the duration of each reallocation, in ns, in the histogram ctx
+void vec_histogram_realloc_hook(vector* vec, uint old_capacity, uint new_capacity, unsigned long long ns, void* ctx);
+// Starts recording the duration of the reallocations of every vector in a built-in histogram, which replaces any
+// other reallocation hook, and returns the histogram
+vec_histogram* vec_track_reallocs();
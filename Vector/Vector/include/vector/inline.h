@@ -0,0 +1,109 @@
+#pragma once
+#include "vector.h"
+#include <string.h>
+#include <assert.h>
+
+// Definitions of the accessors declared with VEC_INLINE. With VEC_HEADER_ONLY they are included by vector.h, so
+// they are static inline in every file. Otherwise they are only compiled in vector.c
+
+// Checks cond as the VEC_BOUNDS_CHECK policy says. With VEC_CHECK_ALWAYS the function reports the failure to the
+// check handler and returns error if cond is false
+#if VEC_BOUNDS_CHECK == VEC_CHECK_ALWAYS
+#define VEC_CHECK(cond, error) do { if(!(cond)) { vec_check_failed(#cond, __func__); return error; } } while(0)
+#elif VEC_BOUNDS_CHECK == VEC_CHECK_ASSERT
+#define VEC_CHECK(cond, error) assert(cond)
+#else
+#define VEC_CHECK(cond, error) ((void)0)
+#endif
+
+VEC_INLINE void* vec_at(vector* vec, uint pos)
+{
+	VEC_CHECK(vec != NULL, NULL);
+	VEC_CHECK(pos < vec->size, NULL);
+
+	if(vec->storage != NULL)
+	{
+		vec_own(vec);
+	}
+
+	return (char*)vec->buffer + pos* vec->data_size;
+}
+
+VEC_INLINE void* vec_front(vector* vec)
+{
+	return vec_at(vec, 0);
+}
+
+VEC_INLINE void* vec_back(vector* vec)
+{
+	VEC_CHECK(vec != NULL, NULL);
+
+	// An empty vector gives pos VEC_NPOS, which fails the check of vec_at
+	return vec_at(vec, vec->size-1);
+}
+
+VEC_INLINE void vec_push_back(vector* vec, void* element)
+{
+	VEC_CHECK(vec != NULL, );
+	VEC_CHECK(element != NULL, );
+
+	// The element fits in the capacity of a buffer owned by the vector, so there is nothing to allocate or copy
+	if(vec->storage == NULL && vec->capacity - vec->size* vec->data_size >= vec->data_size)
+	{
+		memcpy((char*)vec->buffer + vec->size* vec->data_size, element, vec->data_size);
+		++vec->size;
+		return;
+	}
+
+	vec_insert(vec, vec->size, element);
+}
+
+VEC_INLINE char* vecc_at(vector* vec, uint pos)
+{
+	return (char*)vec_at(vec, pos);
+}
+
+VEC_INLINE unsigned char* vecuc_at(vector* vec, uint pos)
+{
+	return (unsigned char*)vec_at(vec, pos);
+}
+
+VEC_INLINE short* vecs_at(vector* vec, uint pos)
+{
+	return (short*)vec_at(vec, pos);
+}
+
+VEC_INLINE unsigned short* vecus_at(vector* vec, uint pos)
+{
+	return (unsigned short*)vec_at(vec, pos);
+}
+
+VEC_INLINE int* veci_at(vector* vec, uint pos)
+{
+	return (int*)vec_at(vec, pos);
+}
+
+VEC_INLINE unsigned int* vecui_at(vector* vec, uint pos)
+{
+	return (unsigned int*)vec_at(vec, pos);
+}
+
+VEC_INLINE long* vecl_at(vector* vec, uint pos)
+{
+	return (long*)vec_at(vec, pos);
+}
+
+VEC_INLINE unsigned long* vecul_at(vector* vec, uint pos)
+{
+	return (unsigned long*)vec_at(vec, pos);
+}
+
+VEC_INLINE float* vecf_at(vector* vec, uint pos)
+{
+	return (float*)vec_at(vec, pos);
+}
+
+VEC_INLINE double* vecd_at(vector* vec, uint pos)
+{
+	return (double*)vec_at(vec, pos);
+}
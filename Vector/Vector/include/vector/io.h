@@ -0,0 +1,64 @@
+#pragma once
+#include "vector.h"
+#include <stdio.h>
+
+// "CVEC" as a little endian uint
+#define VEC_IO_MAGIC 0x43455643
+#define VEC_IO_VERSION 1
+// Written in the endianness field in the byte order of the writer
+#define VEC_IO_ENDIANNESS 0x01020304
+// Count of the header of a stream of chunks, whose total size is not known when the header is written
+#define VEC_IO_CHUNKED 0xFFFFFFFF
+
+// Result of the I/O functions
+typedef enum vec_io_result
+{
+	VEC_IO_OK = 0,
+	VEC_IO_ERROR = -1, // The read or write failed. errno tells why
+	VEC_IO_EOF = -2, // The data ended before the whole vector was read
+	VEC_IO_BAD_HEADER = -3, // Not a vector, unknown version, data_size different from the one of the vector, or too many elements
+	VEC_IO_BAD_CHECKSUM = -4 // The data is corrupted
+} vec_io_result;
+
+// Header written before the elements. It is followed either by count elements, or by a stream of chunks if
+// count is VEC_IO_CHUNKED. Each chunk is a vec_io_chunk followed by its elements, and a chunk of 0 elements ends the stream
+typedef struct vec_io_header
+{
+	uint magic; // VEC_IO_MAGIC
+	uint version; // VEC_IO_VERSION
+	uint endianness; // VEC_IO_ENDIANNESS
+	uint data_size; // Size of each element, in bytes
+	uint count; // Number of elements, or VEC_IO_CHUNKED
+	uint checksum; // Checksum of the elements
+} vec_io_header;
+
+typedef struct vec_io_chunk
+{
+	uint count; // Number of elements of the chunk
+	uint checksum; // Checksum of the elements of the chunk
+} vec_io_chunk;
+
+// Returns the checksum of bytes bytes of data, a Fletcher sum of 32-bit words. If swap is not 0, the words are
+// byte-swapped first, so that data written with the other endianness gives the checksum computed by its writer
+uint vec_io_checksum(const void* data, uint bytes, int swap);
+
+// Writes the header and the elements of the vector to file. The elements are written with a single fwrite
+vec_io_result vec_write(vector* vec, FILE* file);
+// Reads a vector written by vec_write or by a stream into vec, replacing its contents. When the file can tell how
+// many bytes it holds, vec is reserved exactly once and the elements are read straight into its buffer with a single
+// fread, and VEC_IO_EOF is returned without reading if the header counts more elements than the file holds. Otherwise
+// (pipes, streams of chunks) vec grows by doubling as the elements arrive. If the data was written with the other
+// endianness, elements of 2, 4 or 8 bytes are byte-swapped. Otherwise the header is rejected
+vec_io_result vec_read(vector* vec, FILE* file);
+// Same as vec_write, with a single writev system call for the header and the elements, unless it is interrupted
+vec_io_result vec_write_fd(vector* vec, int fd);
+// Same as vec_read, with a single read system call for the elements, unless it is interrupted or fd is a pipe or socket
+vec_io_result vec_read_fd(vector* vec, int fd);
+
+// Writes the header of a stream of chunks of elements of data_size bytes, for pipes or sockets where the number
+// of elements is not known yet
+vec_io_result vec_stream_begin(int fd, uint data_size);
+// Writes the elements of vec in the range [offset, offset+count) as a chunk of the stream
+vec_io_result vec_stream_write(int fd, vector* vec, uint offset, uint count);
+// Ends the stream
+vec_io_result vec_stream_end(int fd);
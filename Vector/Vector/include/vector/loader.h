@@ -0,0 +1,21 @@
+#pragma once
+#include "vector.h"
+#include "io.h"
+
+// Default size of the chunks read by the loader, in bytes
+#define VEC_LOAD_CHUNK (4U << 20)
+
+// Called by the loader for each chunk of count elements, while the next chunk is being read. The elements
+// are only valid during the call. If NULL, the loader appends the elements to vec
+typedef void (*vec_chunk_function)(vector* vec, const void* elements, uint count, void* ctx);
+
+// Loads the elements stored in the range [offset, offset+bytes) of fd into vec (bytes = 0 to read until the end).
+// A background thread reads chunks of chunk_bytes (rounded to whole elements) with pread into two alternating
+// buffers, so func processes a chunk while the next one is read. fd may also be a pipe or socket, in which case offset
+// is ignored. When func is NULL and the size is known, vec is reserved once before reading. When func is NULL,
+// VEC_IO_BAD_HEADER is returned if the elements would not fit in the vector
+vec_io_result vec_load_fd(vector* vec, int fd, long long offset, long long bytes, uint chunk_bytes,
+	vec_chunk_function func, void* ctx);
+// Loads a file written by vec_write into vec, appending its elements with vec_load_fd. The checksum is verified
+// when func is NULL. Streams of chunks and files written with the other endianness must be read with vec_read
+vec_io_result vec_load(vector* vec, const char* path, uint chunk_bytes, vec_chunk_function func, void* ctx);
@@ -0,0 +1,70 @@
+#pragma once
+#include "vector.h"
+#include "io.h"
+#include <stdatomic.h>
+
+// How a file is mapped by vec_open_mapped
+typedef enum vec_map_mode
+{
+	// The file must exist. Opening is O(1) and pages are loaded on first access. Modifications are private
+	// to the process and never reach the file, and growing the vector moves its elements to memory
+	VEC_MAP_READ,
+	// The file is created if it does not exist. Modifications are written to the file, which grows with
+	// the vector capacity, and vec_sync or vec_close_mapped store the size in its header
+	VEC_MAP_WRITE
+} vec_map_mode;
+
+// Returns a vector whose buffer is a mapping of the file at path, or NULL if the file can not be opened or
+// it is not a vector of data_size elements. The file uses the format of vec_write, so it can also be read with
+// vec_read, with the elements followed by the unused capacity. The checksum is not verified on opening, it is
+// computed by vec_sync. Mapped vectors must be closed with vec_close_mapped. If a mapped vector is duplicated with
+// vec_dup and then modified, it gets its own copy of the elements in memory, like any other shared vector.
+// Only available on POSIX systems: on Windows it always returns NULL
+vector* vec_open_mapped(const char* path, uint data_size, vec_map_mode mode);
+// Writes the header and flushes the modified pages of a VEC_MAP_WRITE vector to the file. If the file or the
+// shared memory object could not grow, the elements were moved to memory to keep the vector usable, the file keeps
+// the elements of the last sync and VEC_IO_ERROR is returned
+vec_io_result vec_sync(vector* vec);
+// Syncs the vector, truncates the file to its size and frees the vector
+vec_io_result vec_close_mapped(vector* vec);
+
+// realloc_function and free_function of mapped vectors. Buffers that are not mappings are handled like
+// realloc_buffer and free_buffer do
+void* vec_mapped_realloc(void* old_buffer, uint old_size, uint new_size);
+void vec_mapped_free(void* buffer);
+
+// =========================== SHARED MEMORY ===================================
+
+// "VSHM" as a little endian uint
+#define VEC_SHM_MAGIC 0x4D485356
+
+// Header of a shared memory vector, shared by all the processes that map it. The elements start at the next cache line
+typedef struct vec_shm_header
+{
+	uint magic; // VEC_SHM_MAGIC
+	uint data_size; // Size of each element, in bytes
+	atomic_uint size; // Number of elements published by the producer
+	atomic_uint capacity; // Size of the elements storage, in bytes
+	atomic_uint generation; // Incremented each time the producer grows the storage
+	char pad[VEC_CACHE_LINE - 5* sizeof(uint)];
+} vec_shm_header;
+
+// Creates a shared memory object with shm_open, replacing any object with the same name, and returns the vector of
+// its only producer. If name is NULL an anonymous object is created with memfd_create (Linux only), to be passed to
+// consumers through vec_shm_fd. Elements written by the producer are published to consumers by vec_sync, and the
+// producer closes the vector with vec_close_mapped. Returns NULL if the object can not be created
+vector* vec_shm_create(const char* name, uint data_size);
+// Maps the shared memory object name read-only, without copying the elements. The vector must not be modified.
+// Returns NULL if the object does not exist or it is not a vector of data_size elements. The vector is closed with
+// vec_close_mapped
+vector* vec_shm_attach(const char* name, uint data_size);
+// Same as vec_shm_attach, for an object passed as a file descriptor. fd is duplicated, so the caller may close it
+vector* vec_shm_attach_fd(int fd, uint data_size);
+// Returns the file descriptor of a shared memory vector, or -1
+int vec_shm_fd(vector* vec);
+// Updates the size of a consumer vector to the last size published by the producer, and remaps the elements if the
+// producer grew them since the last call. Returns 1 if the elements were remapped, so pointers to them are invalid
+int vec_shm_refresh(vector* vec);
+// Removes the name of a shared memory object. Processes that mapped it keep their mappings
+int vec_shm_unlink(const char* name);
+// Shared memory vectors are only available on POSIX systems: on Windows vec_shm_create and vec_shm_attach return NULL
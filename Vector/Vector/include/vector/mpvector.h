@@ -0,0 +1,50 @@
+#pragma once
+#include "vector.h"
+#include <stdatomic.h>
+
+// Number of elements of the first segment. Each segment doubles the size of the previous one
+#define MPVEC_FIRST_SEGMENT 64
+// Enough segments to hold 2^32 - MPVEC_FIRST_SEGMENT elements
+#define MPVEC_SEGMENTS 26
+
+// Multi-producer append-only vector. Pushers claim a slot with an atomic increment and write the
+// element into segmented storage, which never moves, so no pusher ever waits for a reallocation. Each segment is
+// allocated once, by the pusher of its first slot, and pushers that reach it before wait for the allocation.
+// Completed elements become visible to readers once mpvec_commit publishes them, in order
+typedef struct mpvector
+{
+	_Atomic(char*) segments[MPVEC_SEGMENTS]; // Each segment holds its ready flags followed by its elements
+	uint data_size; // Size of each element, in bytes
+	alloc_function alloc_func; // Function used to allocate the segments
+	free_function free_func; // Function used to free the segments
+	equal_function equal_func; // Function used to compare values of the vector
+	char pad0[VEC_CACHE_LINE];
+	atomic_uint reserved; // Number of slots claimed by pushers
+	char pad1[VEC_CACHE_LINE - sizeof(atomic_uint)];
+	atomic_uint published; // Number of elements visible to readers
+	char pad2[VEC_CACHE_LINE - sizeof(atomic_uint)];
+} mpvector;
+
+// Allocates a new multi-producer vector dynamically and initializes it
+mpvector* mpvec_create(uint data_size);
+// Free the vector and its data storage. No thread may be using it
+void mpvec_free(mpvector* mpv);
+// Initializes the vector with default parameters
+void mpvec_init(mpvector* mpv, uint data_size);
+// Releases the data storage of a vector initialized with mpvec_init. No thread may be using it
+void mpvec_destroy(mpvector* mpv);
+// Add element at the end and returns its position. Safe to call from any number of threads.
+// The element is not visible to readers until it is published by mpvec_commit. Returns VEC_NPOS if the segment of
+// the element can not be allocated, because alloc_func failed or its size in bytes does not fit in a uint
+uint mpvec_push_back(mpvector* mpv, const void* element);
+// Publishes the elements whose push has completed, up to the first one still being written.
+// Returns the number of published elements. Safe to call from any thread
+uint mpvec_commit(mpvector* mpv);
+// Returns the number of published elements
+uint mpvec_size(mpvector* mpv);
+// Returns a read-only pointer to the published element at pos
+const void* mpvec_at(mpvector* mpv, uint pos);
+// Returns a copy of the published element at pos. The copy is stored in element
+void* mpvec_at_cp(mpvector* mpv, uint pos, void* element);
+// Copies the published elements to vec, replacing its contents, and returns vec
+vector* mpvec_to_vec(mpvector* mpv, vector* vec);
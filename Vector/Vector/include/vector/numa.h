@@ -0,0 +1,32 @@
+#pragma once
+#include "vector.h"
+
+// Buffers of at least this many bytes are aligned and rounded up to huge pages, and get a placement policy
+#define VEC_HUGE_PAGE_SIZE (2U << 20)
+
+// Where the pages of big buffers are placed
+typedef enum vec_numa_policy
+{
+	VEC_NUMA_FIRST_TOUCH, // Default policy of the OS: each page goes to the node of the thread that first writes it
+	VEC_NUMA_LOCAL, // Pages go to the node of the thread that allocates the buffer
+	VEC_NUMA_NODE, // Pages go to the given node
+	VEC_NUMA_INTERLEAVE // Pages are spread round-robin among all the nodes
+} vec_numa_policy;
+
+// Allocator backend for big vectors. Buffers of at least VEC_HUGE_PAGE_SIZE bytes are aligned to huge pages,
+// advised to use transparent huge pages and placed with the current policy. Buffers are still released with
+// free, so these functions can be used as alloc_func/realloc_func of any vector. On systems without NUMA
+// support (or other than Linux) the policy is ignored and buffers are only aligned
+void* vec_numa_alloc(uint size, uint count);
+void* vec_numa_realloc(void* old_buffer, uint old_size, uint new_size);
+
+// Sets the policy used by vec_numa_alloc. node is only used by VEC_NUMA_NODE
+void vec_numa_set_policy(vec_numa_policy policy, uint node);
+// Returns the number of NUMA nodes
+uint vec_numa_nodes();
+// Sets the alloc and realloc functions of the vector to the NUMA backend
+void vec_numa_use(vector* vec);
+// Resizes the vector and zeroes the new elements in parallel with the default pool. The elements are split among
+// the workers exactly like vec_parallel_for does before any stealing, so that with VEC_NUMA_FIRST_TOUCH each page
+// is placed on the node of the worker that will process it
+void vec_numa_resize(vector* vec, uint new_size);
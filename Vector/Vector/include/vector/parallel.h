@@ -0,0 +1,99 @@
+#pragma once
+#include "vector.h"
+#include <stdatomic.h>
+#include <threads.h>
+
+// Default minimum number of elements processed by a task
+#define VEC_DEFAULT_GRAIN 4096
+// Copies and fills of at least this many bytes are split among the threads of the default pool
+#define VEC_PARALLEL_COPY_MIN (1U << 20)
+// Copies of at least this many bytes are worth non-temporal stores, as the destination would not fit in the cache
+// anyway, when it is not read right after. Callers choose them with the streaming argument of vec_bulk_copy
+#define VEC_STREAM_COPY_MIN (32U << 20)
+
+// Processes the elements in the range [first, last). worker is the index of the calling worker, in [0, pool size)
+typedef void (*vec_range_function)(uint first, uint last, uint worker, void* ctx);
+// Called for each element of the vector, with its position
+typedef void (*vec_for_function)(void* element, uint pos, void* ctx);
+// Stores in dst the result of transforming src
+typedef void (*vec_map_function)(const void* src, void* dst, void* ctx);
+// Accumulates element into acc
+typedef void (*vec_reduce_function)(void* acc, const void* element, void* ctx);
+// Accumulates other, a partial result, into acc
+typedef void (*vec_combine_function)(void* acc, const void* other, void* ctx);
+
+// Range of tasks owned by a worker, packed as (first << 32) | last so that it can be
+// shrunk from the front by its owner and split from the back by thieves with a single CAS
+typedef struct vec_pool_worker
+{
+	atomic_ullong tasks;
+	char pad[VEC_CACHE_LINE - sizeof(atomic_ullong)];
+} vec_pool_worker;
+
+// Persistent pool of threads running data-parallel jobs. A job is split in tasks of at least grain
+// elements, and each worker starts with a contiguous block of tasks: worker w gets the tasks
+// [w*ntasks/size, (w+1)*ntasks/size). Workers that run out of tasks steal half of the remaining
+// tasks of another worker. The thread calling vec_pool_run works as worker 0
+typedef struct vec_pool
+{
+	thrd_t* threads; // Worker threads, the caller is not included
+	vec_pool_worker* workers; // Tasks of each worker
+	uint size; // Number of workers, including the caller
+	uint grain; // Minimum number of elements per task
+	mtx_t run_mutex; // Serializes jobs
+	mtx_t mutex; // Protects the job state below
+	cnd_t start; // Signaled when a job starts or the pool stops
+	cnd_t done; // Signaled when the last thread finishes a job
+	uint generation; // Incremented on each job
+	uint running; // Threads still working on the current job
+	int stop; // Whether the threads must exit
+	vec_range_function func; // Current job
+	void* ctx;
+	uint count; // Number of elements of the current job
+	uint task_size; // Number of elements per task of the current job
+} vec_pool;
+
+// Returns the number of hardware threads
+uint vec_hardware_threads();
+// Allocates a new pool of size workers (0 for one per hardware thread), and starts its threads
+vec_pool* vec_pool_create(uint size, uint grain);
+// Stops the threads and frees the pool
+void vec_pool_free(vec_pool* pool);
+// Returns the pool used by the vec_parallel functions. It is created on first use with one worker
+// per hardware thread and VEC_DEFAULT_GRAIN
+vec_pool* vec_pool_default();
+// Sets the minimum number of elements processed by a task
+void vec_pool_set_grain(vec_pool* pool, uint grain);
+// Runs func over [0, count) in parallel and waits for it to finish. Tasks contain a multiple of align elements.
+// Must not be called from inside a job of the same pool
+void vec_pool_run(vec_pool* pool, uint count, uint align, vec_range_function func, void* ctx);
+// Returns the smallest number of elements of data_size bytes that fill a whole number of cache lines,
+// to be used as align so that tasks do not write to the same cache line. Task boundaries are multiples of align
+// from the start of the buffer, so they fall on cache lines when the buffer is aligned like vec_cache_alloc does
+uint vec_cache_align(uint data_size);
+// Allocates size bytes aligned to a cache line, so that padded structures really fill whole cache lines.
+// The memory must be released with vec_cache_free
+void* vec_cache_alloc(uint size);
+void vec_cache_free(void* buffer);
+
+// Calls func for each element of vec, in parallel. Tasks span whole cache lines of the buffer, see vec_cache_align
+void vec_parallel_for(vector* vec, vec_for_function func, void* ctx);
+// Resizes dst to the size of src and stores func(src[i]) in dst[i], in parallel
+void vec_parallel_map(vector* src, vector* dst, vec_map_function func, void* ctx);
+// Reduces the elements of vec into result, which holds result_size bytes and must be initialized with the
+// identity value. Each worker reduces into its own copy of the identity, then the copies are combined into result.
+// A worker reduces the ranges it takes, including those it steals, in no particular order, and the copies are
+// combined by worker, so reduce and combine must be associative and commutative (e.g. not floating point sums
+// that must be reproducible, or concatenations)
+void vec_parallel_reduce(vector* vec, void* result, uint result_size, vec_reduce_function reduce,
+	vec_combine_function combine, void* ctx);
+
+// Copies bytes from src to dst, which must not overlap. Big copies are split in cache line aligned chunks
+// among the threads of the default pool. If the pool is busy, including when this is called from inside one of
+// its jobs, the copy is done by the calling thread. If streaming is not 0, the destination is written with
+// non-temporal stores that bypass the cache, which is faster when dst will not be read soon
+void vec_bulk_copy(void* dst, const void* src, uint bytes, int streaming);
+// Fills the range [dst, dst + bytes) with copies of the pattern held by its first pattern_size bytes.
+// bytes must be a multiple of pattern_size. The copies are doubled until they are big enough to be
+// split among the threads of the default pool, which is used like in vec_bulk_copy
+void vec_bulk_fill(void* dst, uint pattern_size, uint bytes);
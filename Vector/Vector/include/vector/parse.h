@@ -0,0 +1,16 @@
+#pragma once
+#include "vector.h"
+
+// Texts of at least this many bytes are split in chunks of this size to be parsed in parallel
+#define VEC_PARSE_CHUNK (1U << 20)
+
+// Bulk parsers of numbers separated by spaces, tabs, newlines, commas or semicolons. The values are appended to
+// the vector, which is reserved once from an estimate of the number of values, in batches. Integers and most
+// decimal numbers are parsed by hand, other numbers (very long mantissas, big exponents, inf, nan) fall back to
+// strtod. If parallel is not 0 and text is big enough, it is split in chunks at separators that are parsed in parallel
+// with the default pool. Parsing stops at the first invalid number. Returns the number of bytes parsed, which is
+// length unless there was an invalid number, and only the values before it are appended
+uint vecf_parse(vector* vec, const char* text, uint length, int parallel);
+uint vecd_parse(vector* vec, const char* text, uint length, int parallel);
+uint veci_parse(vector* vec, const char* text, uint length, int parallel);
+uint vecul_parse(vector* vec, const char* text, uint length, int parallel);
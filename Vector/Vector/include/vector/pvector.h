@@ -0,0 +1,62 @@
+#pragma once
+#include "vector.h"
+
+#define PVEC_BITS 5
+#define PVEC_WIDTH (1 << PVEC_BITS)
+
+// Node of the trie. It is followed by PVEC_WIDTH child pointers, or PVEC_WIDTH elements for leaves
+typedef struct pvec_node
+{
+	uint refs; // Number of nodes and versions referencing this node
+	uint leaf; // Whether the node stores elements instead of children
+} pvec_node;
+
+// Persistent vector: a version of a vector that is never modified once created. Versions are 32-way
+// tries that share all their nodes but the path to the modified element, so push_back, replace and at
+// are O(log32 n) and old versions stay readable until they are freed.
+//
+// Transient versions are modified in place, copying only the nodes still shared with other versions.
+// They are meant for building a vector in batch, and are turned back into persistent ones with pvec_persistent.
+//
+// Reference counts are not atomic: versions can be read from any thread, but must be created and freed
+// from the same thread
+typedef struct pvector
+{
+	pvec_node* root; // Trie with all the elements but the tail, or NULL
+	pvec_node* tail; // Last leaf, which is not in the trie yet, or NULL
+	uint size; // Number of elements in the vector
+	uint shift; // Number of bits used by the levels of the trie above the leaves
+	uint data_size; // Size of each element, in bytes
+	uint transient; // Whether this version can be modified in place
+	equal_function equal_func; // Function used to compare values of the vector
+} pvector;
+
+// Allocates a new empty persistent vector
+pvector* pvec_create(uint data_size);
+// Free this version. Nodes shared with other versions are kept
+void pvec_free(pvector* pv);
+// Returns the number of elements in the vector
+uint pvec_size(pvector* pv);
+// Returns a read-only pointer to the element at pos in the vector
+const void* pvec_at(pvector* pv, uint pos);
+// Returns a copy of the element at pos in the vector. The copy is stored in element
+void* pvec_at_cp(pvector* pv, uint pos, void* element);
+// Returns the first position of the element in the vector, starting the search from offset.
+// If the element is not found, VEC_NPOS is returned
+uint pvec_find(pvector* pv, const void* element, uint offset);
+// Returns a new version with element added at the end
+pvector* pvec_push_back(pvector* pv, const void* element);
+// Returns a new version with the element at pos set to element
+pvector* pvec_replace(pvector* pv, uint pos, const void* element);
+// Returns a transient copy of the version, which can be modified in place
+pvector* pvec_transient(pvector* pv);
+// Add element at the end of a transient version
+void pvec_tpush_back(pvector* pv, const void* element);
+// Set the element at pos of a transient version
+void pvec_treplace(pvector* pv, uint pos, const void* element);
+// Turns a transient version into a persistent one, and returns it
+pvector* pvec_persistent(pvector* pv);
+// Allocates a new persistent vector with a copy of the elements of vec
+pvector* pvec_from_vec(vector* vec);
+// Copies all the elements to vec, replacing its contents, and returns vec
+vector* pvec_to_vec(pvector* pv, vector* vec);
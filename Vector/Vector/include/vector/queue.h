@@ -0,0 +1,86 @@
+#pragma once
+#include "vector.h"
+#include <stdatomic.h>
+
+// Bounded lock-free queues of elements of data_size bytes. Capacities are rounded up to a power of 2.
+// Indices written by different threads are kept in separate cache lines to avoid false sharing
+
+// =========================== SPSC QUEUE ===================================
+
+// Queue for exactly one producer thread and one consumer thread. Each side keeps a cached copy
+// of the other side index, and only reads the shared one when the cached copy says the queue is full/empty
+typedef struct spsc_queue
+{
+	char* buffer; // Data storage
+	uint data_size; // Size of each element, in bytes
+	uint mask; // Capacity - 1
+	alloc_function alloc_func; // Function used to allocate the buffer
+	free_function free_func; // Function used to free the buffer
+	char pad0[VEC_CACHE_LINE];
+	atomic_uint head; // Position of the next element to dequeue. Written by the consumer
+	uint cached_tail; // Last tail seen by the consumer
+	char pad1[VEC_CACHE_LINE - 2* sizeof(uint)];
+	atomic_uint tail; // Position of the next element to enqueue. Written by the producer
+	uint cached_head; // Last head seen by the producer
+	char pad2[VEC_CACHE_LINE - 2* sizeof(uint)];
+} spsc_queue;
+
+// Allocates a new queue dynamically and initializes it
+spsc_queue* spsc_create(uint data_size, uint capacity);
+// Free the queue and its data storage
+void spsc_free(spsc_queue* q);
+// Initializes the queue, with room for at least capacity elements
+void spsc_init(spsc_queue* q, uint data_size, uint capacity);
+// Same as spsc_init, with the buffer allocated by alloc_func and released by free_func
+void spsc_init_alloc(spsc_queue* q, uint data_size, uint capacity, alloc_function alloc_func, free_function free_func);
+// Releases the data storage of a queue initialized with spsc_init
+void spsc_destroy(spsc_queue* q);
+// Adds element at the end of the queue. Returns 0 if the queue is full. Producer only
+int spsc_enqueue(spsc_queue* q, const void* element);
+// Adds up to count elements at the end of the queue. Returns the number of elements added. Producer only
+uint spsc_enqueue_batch(spsc_queue* q, const void* elements, uint count);
+// Removes the first element of the queue and copies it into element. Returns 0 if the queue is empty. Consumer only
+int spsc_dequeue(spsc_queue* q, void* element);
+// Removes up to count elements and copies them into elements. Returns the number of elements removed. Consumer only
+uint spsc_dequeue_batch(spsc_queue* q, void* elements, uint count);
+// Returns the number of elements in the queue
+uint spsc_size(spsc_queue* q);
+
+// =========================== MPMC QUEUE ===================================
+
+// Queue for any number of producers and consumers. Each slot has a sequence number that tells
+// whether it is ready to be written or read in the current lap, so threads only contend on the
+// index they advance
+typedef struct mpmc_queue
+{
+	char* buffer; // Slots: sequence number followed by the element
+	uint data_size; // Size of each element, in bytes
+	uint slot_size; // Size of each slot, in bytes
+	uint mask; // Capacity - 1
+	alloc_function alloc_func; // Function used to allocate the buffer
+	free_function free_func; // Function used to free the buffer
+	char pad0[VEC_CACHE_LINE];
+	atomic_uint enqueue_pos; // Position of the next slot to write
+	char pad1[VEC_CACHE_LINE - sizeof(atomic_uint)];
+	atomic_uint dequeue_pos; // Position of the next slot to read
+	char pad2[VEC_CACHE_LINE - sizeof(atomic_uint)];
+} mpmc_queue;
+
+// Allocates a new queue dynamically and initializes it
+mpmc_queue* mpmc_create(uint data_size, uint capacity);
+// Free the queue and its data storage
+void mpmc_free(mpmc_queue* q);
+// Initializes the queue, with room for at least capacity elements
+void mpmc_init(mpmc_queue* q, uint data_size, uint capacity);
+// Same as mpmc_init, with the buffer allocated by alloc_func and released by free_func
+void mpmc_init_alloc(mpmc_queue* q, uint data_size, uint capacity, alloc_function alloc_func, free_function free_func);
+// Releases the data storage of a queue initialized with mpmc_init
+void mpmc_destroy(mpmc_queue* q);
+// Adds element at the end of the queue. Returns 0 if the queue is full
+int mpmc_enqueue(mpmc_queue* q, const void* element);
+// Adds up to count consecutive elements at the end of the queue. Returns the number of elements added
+uint mpmc_enqueue_batch(mpmc_queue* q, const void* elements, uint count);
+// Removes the first element of the queue and copies it into element. Returns 0 if the queue is empty
+int mpmc_dequeue(mpmc_queue* q, void* element);
+// Removes up to count consecutive elements and copies them into elements. Returns the number of elements removed
+uint mpmc_dequeue_batch(mpmc_queue* q, void* elements, uint count);
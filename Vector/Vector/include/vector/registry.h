@@ -0,0 +1,37 @@
+#pragma once
+#include "vector.h"
+#include <stdio.h>
+
+// Registry of the live vectors, only compiled in when VEC_REGISTRY is defined, which must be done for the library and
+// for every file that includes vector.h, since it changes the layout of vector. vec_init adds vectors to the registry
+// and vec_destroy removes them, with a lock taken only by those two functions, so the registry can be left on in
+// production. A vector must be destroyed before it is initialized again, and must not be copied by value: use vec_swap
+// and vec_move, which keep each vector in the registry. Without VEC_REGISTRY the functions do nothing
+
+typedef enum vec_report_format
+{
+	VEC_REPORT_TEXT,
+	VEC_REPORT_JSON
+} vec_report_format;
+
+// Tags the vector, so that its memory is accounted to tag. tag must outlive the vector, as it is not copied.
+// Vectors without a tag are reported as "untagged"
+void vec_set_tag(vector* vec, const char* tag);
+// Returns the tag of the vector, or NULL
+const char* vec_get_tag(vector* vec);
+// Returns the number of live vectors
+uint vec_registry_count();
+// Writes, for each tag, the number of live vectors and the bytes of their elements and capacity, followed by the
+// largest vectors by capacity. Vectors that share a storage after vec_dup are counted at their own capacity.
+// Sizes of vectors modified by other threads during the report are approximate
+void vec_report(FILE* file, vec_report_format format, uint largest);
+// Sets the maximum capacity, in bytes, of the vectors tagged with tag (0 for no budget). tag is not copied
+void vec_set_budget(const char* tag, unsigned long long bytes);
+// Shrinks to fit all the vectors of the tags whose capacity is over their budget. It must be called when no other
+// thread is modifying or destroying those vectors, since they are shrunk after the registry is unlocked.
+// Returns the number of bytes released
+unsigned long long vec_registry_enforce();
+
+// Used by vec_init and vec_destroy. Removing a vector that is not in the registry does nothing
+void vec_registry_add(vector* vec);
+void vec_registry_remove(vector* vec);
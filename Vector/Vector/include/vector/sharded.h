@@ -0,0 +1,40 @@
+#pragma once
+#include "vector.h"
+
+// Vector owned by a single thread, padded so that shards do not share cache lines
+typedef struct vec_shard
+{
+	vector vec;
+	char pad[VEC_CACHE_LINE - sizeof(vector) % VEC_CACHE_LINE];
+} vec_shard;
+
+// Vector split in shards, one per producer thread. Each thread appends to its own shard
+// with no synchronization, and vec_shard_merge gathers all the shards in a single vector
+typedef struct vec_sharded
+{
+	vec_shard* shards; // Data of each shard
+	uint count; // Number of shards
+	uint data_size; // Size of each element, in bytes
+} vec_sharded;
+
+// Allocates a new sharded vector dynamically and initializes it
+vec_sharded* vec_shard_create(uint data_size, uint count);
+// Free the sharded vector and the data storage of its shards
+void vec_shard_free(vec_sharded* sv);
+// Initializes the sharded vector with count shards (0 for one per hardware thread)
+void vec_shard_init(vec_sharded* sv, uint data_size, uint count);
+// Releases the shards of a vector initialized with vec_shard_init
+void vec_shard_destroy(vec_sharded* sv);
+// Returns the vector of a shard. It may only be used by the thread that owns the shard
+vector* vec_shard_get(vec_sharded* sv, uint shard);
+// Add element at the end of a shard. It may only be called by the thread that owns the shard
+void vec_shard_push_back(vec_sharded* sv, uint shard, void* element);
+// Returns the total number of elements of the shards
+uint vec_shard_size(vec_sharded* sv);
+// Removes all the elements of the shards, keeping their capacity
+void vec_shard_clear(vec_sharded* sv);
+// Replaces the contents of dst by the elements of all the shards and returns dst. dst is resized once to the exact
+// total size and the shards are copied in parallel. If ordered is not 0, the elements are stored by shard index,
+// keeping the order of each shard. Otherwise dst takes the buffer of the largest shard to avoid copying it, and the
+// other shards are appended after it. The shards are left empty. No thread may be appending while merging
+vector* vec_shard_merge(vec_sharded* sv, vector* dst, int ordered);
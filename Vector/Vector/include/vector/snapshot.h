@@ -0,0 +1,39 @@
+#pragma once
+#include "vector.h"
+#include "io.h"
+
+// "CVSN" as a little endian uint
+#define VEC_SNAPSHOT_MAGIC 0x4E535643
+#define VEC_SNAPSHOT_VERSION 1
+// Size of the uncompressed blocks, in bytes
+#define VEC_SNAPSHOT_BLOCK (64U << 10)
+
+// Header of a snapshot. It is followed by block_count vec_snapshot_block entries, then by the blocks
+typedef struct vec_snapshot_header
+{
+	uint magic; // VEC_SNAPSHOT_MAGIC
+	uint version; // VEC_SNAPSHOT_VERSION
+	uint endianness; // VEC_IO_ENDIANNESS
+	uint data_size; // Size of each element, in bytes
+	uint count; // Number of elements
+	uint block_elements; // Number of elements of each block, except the last one
+	uint block_count; // Number of blocks
+} vec_snapshot_header;
+
+// Each block holds the bytes of its elements shuffled by position inside the element (all the first bytes,
+// then all the second bytes...), compressed with a LZ77 codec, or stored as is if they do not compress
+typedef struct vec_snapshot_block
+{
+	unsigned long long offset; // Position of the block, from the end of the block table
+	uint size; // Size of the block, in bytes. Blocks stored as is have the size of their elements
+	uint checksum; // vec_io_checksum of the uncompressed elements, before shuffling
+} vec_snapshot_block;
+
+// Writes the vector as a snapshot. Blocks are shuffled and compressed in parallel with the default pool
+vec_io_result vec_snapshot_write(vector* vec, FILE* file);
+// Reads a snapshot into vec, replacing its contents. vec is reserved once, the blocks are read with a single fread
+// and decompressed in parallel straight into its buffer. Snapshots written with the other endianness are rejected
+vec_io_result vec_snapshot_read(vector* vec, FILE* file);
+// Reads the elements in the range [offset, offset+count) of a snapshot into vec, replacing its contents.
+// Only the blocks holding the range are read and decompressed. Returns VEC_IO_EOF if the snapshot does not hold the range
+vec_io_result vec_snapshot_read_range(vector* vec, FILE* file, uint offset, uint count);
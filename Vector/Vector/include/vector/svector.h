@@ -0,0 +1,79 @@
+#pragma once
+#include "vector.h"
+
+// Density (stored elements / size) above which a sparse vector switches to dense storage
+#define SVEC_DEFAULT_THRESHOLD 0.25f
+
+// Vector for mostly-default data. In sparse mode only the elements that are not equal to the
+// default value are stored, as sorted (index, value) pairs. When the density grows above the
+// threshold the vector switches to dense mode, where every element is stored like in a vector
+typedef struct svector
+{
+	vector indices; // Sorted positions of the stored elements (uint). Empty in dense mode
+	vector values; // Stored elements, in the same order as indices. All the elements in dense mode
+	void* default_value; // Value of the elements that are not stored
+	uint size; // Number of elements in the vector
+	uint nnz; // Number of elements not equal to the default value
+	uint data_size; // Size of each element, in bytes
+	uint dense; // Whether the vector is in dense mode
+	float threshold; // Density above which the vector switches to dense mode
+	equal_function equal_func; // Function used to compare values with the default value
+} svector;
+
+// Allocates a new sparse vector dynamically and initializes it
+svector* svec_create(uint data_size, const void* default_value);
+// Free the sparse vector and its data storage
+void svec_free(svector* sv);
+// Initializes the sparse vector. default_value is copied, NULL means all bits set to 0
+void svec_init(svector* sv, uint data_size, const void* default_value);
+// Releases the data storage of a sparse vector initialized with svec_init
+void svec_destroy(svector* sv);
+// Sets the density above which the vector switches to dense mode
+void svec_set_threshold(svector* sv, float threshold);
+// Switches to dense mode
+void svec_densify(svector* sv);
+// Switches to sparse mode
+void svec_sparsify(svector* sv);
+// Resizes the container so that it contains n elements. New elements have the default value.
+// This does not allocate in sparse mode, and may switch a dense vector back to sparse mode
+void svec_resize(svector* sv, uint new_size);
+// Returns a read-only pointer to the element at pos in the vector
+const void* svec_at(svector* sv, uint pos);
+// Returns a copy of the element at pos in the vector. The copy is stored in element
+void* svec_at_cp(svector* sv, uint pos, void* element);
+// Set the element given at pos
+void svec_replace(svector* sv, uint pos, const void* element);
+// Add element at the end. The value is copied to the vector
+void svec_push_back(svector* sv, const void* element);
+// Returns the first position, starting from pos, of an element not equal to the default value.
+// If there is none, VEC_NPOS is returned
+uint svec_next(svector* sv, uint pos);
+// Replaces the contents of sv with the elements of vec, choosing the mode from their density
+void svec_from_vec(svector* sv, vector* vec);
+// Stores all the elements in vec, replacing its contents, and returns vec
+vector* svec_to_vec(svector* sv, vector* vec);
+
+// =========================== VALUE-TYPE SPECIALIZATIONS ===================================
+//
+// float: svecf
+// double: svecd
+//
+// dot returns the dot product of the sparse vector x and the dense vector y.
+// axpy computes y = a*x + y, where x is the sparse vector and y the dense one
+//
+
+svector* svecf_create();
+void svecf_init(svector* sv);
+float svecf_at(svector* sv, uint pos);
+void svecf_replace(svector* sv, uint pos, float element);
+void svecf_push_back(svector* sv, float element);
+float svecf_dot(svector* x, vector* y);
+void svecf_axpy(float a, svector* x, vector* y);
+
+svector* svecd_create();
+void svecd_init(svector* sv);
+double svecd_at(svector* sv, uint pos);
+void svecd_replace(svector* sv, uint pos, double element);
+void svecd_push_back(svector* sv, double element);
+double svecd_dot(svector* x, vector* y);
+void svecd_axpy(double a, svector* x, vector* y);
@@ -1,11 +1,47 @@
 #pragma once
-#define VEC_NPOS -1
+#define VEC_NPOS ((unsigned int)-1)
+// Size of a cache line, used to keep data written by different threads apart
+#define VEC_CACHE_LINE 64
+
+// Bounds check policies of vec_at, vec_front, vec_back, vec_push_back and the typed vecX_at, chosen with
+// VEC_BOUNDS_CHECK: no checks, asserts (the default) or checks in every build that make them return NULL
+// (vec_push_back does nothing) on an invalid vector or position, after calling the handler set with
+// vec_set_check_handler
+#define VEC_CHECK_NONE 0
+#define VEC_CHECK_ASSERT 1
+#define VEC_CHECK_ALWAYS 2
+#ifndef VEC_BOUNDS_CHECK
+#define VEC_BOUNDS_CHECK VEC_CHECK_ASSERT
+#endif
+
+// With VEC_HEADER_ONLY, the accessors above are static inline functions defined in inline.h, so loops over them
+// can be optimized without LTO. The library is compiled the same way in both modes
+#ifdef VEC_HEADER_ONLY
+#define VEC_INLINE static inline
+#else
+#define VEC_INLINE
+#endif
 
 typedef unsigned int uint;
 
 typedef void* (*alloc_function)(uint size, uint count);
 typedef void* (*realloc_function)(void* old_buffer, uint old_size, uint new_size);
 typedef int (*equal_function)(void* a, void* b, uint data_size);
+typedef void (*free_function)(void* buffer);
+
+// Reference-counted data storage shared by vectors duplicated with vec_dup, defined in vector.c
+typedef struct vec_storage vec_storage;
+
+// Reallocation and data movement counters of a vector. They are only kept when VEC_STATS is defined, which must be
+// done for the library and for every file that includes this header, since it changes the layout of vector
+typedef struct vec_stats
+{
+	uint reallocs; // Calls to realloc_func, and moves of adopted buffers that can not be reallocated
+	unsigned long long realloc_bytes; // Sum of the new capacities of those calls, in bytes
+	unsigned long long moved_bytes; // Bytes shifted by vec_insert, vec_erase and vec_erase_range
+	uint peak_capacity; // Largest capacity the vector had, in bytes
+	uint slack; // Unused capacity when the statistics were read, in bytes
+} vec_stats;
 
 typedef struct vector
 {
@@ -15,11 +51,57 @@ typedef struct vector
 	uint capacity; // Size of the vector storage, in bytes
 	alloc_function alloc_func; // Function used to allocate a new buffer
 	realloc_function realloc_func; // Function used to realloc the vector buffer
+	free_function free_func; // Function used to free the vector buffer
 	equal_function equal_func; // Function used to compare values of the vector
+	vec_storage* storage; // Storage shared with other vectors, or NULL if the buffer is owned by this vector
+#ifdef VEC_STATS
+	vec_stats stats; // Counters since the vector was initialized or the last vec_reset_stats
+#endif
+#ifdef VEC_REGISTRY
+	const char* tag; // Accounting tag of the vector in the registry of live vectors (see registry.h)
+	struct vector* registry_prev; // Neighbours in the registry, NULL if the vector is not in it
+	struct vector* registry_next;
+#endif
 } vector;
 
+// Called after each reallocation of the buffer of a vector, with the old and new capacities in bytes and the time
+// the reallocation took, in ns. It runs in the thread that grows or shrinks the vector
+typedef void (*realloc_hook_function)(vector* vec, uint old_capacity, uint new_capacity, unsigned long long ns,
+	void* ctx);
+
+typedef struct vec_realloc_hook
+{
+	realloc_hook_function func;
+	void* ctx; // Passed to func
+} vec_realloc_hook;
+
+// Non-owning, read-only view over a range of elements. A view does not keep the
+// elements alive: it is invalidated by any modification of the vector it was taken from
+typedef struct vec_view
+{
+	const void* buffer; // First element of the range
+	uint data_size; // Size of each element, in bytes
+	uint size; // Number of elements in the view
+	equal_function equal_func; // Function used to compare values of the view
+} vec_view;
+
 // Please notice that this vector implementation only manages data by value, that is, 
 // it does not delete data dynamically allocated
+//
+// Vectors created by vec_dup share their data storage with the source vector (copy-on-write).
+// Any function that may modify the elements (including vec_at, vec_front and vec_back, which return
+// writable pointers) first gives the vector its own copy of the data. Reference counts are atomic, so
+// duplicates can be handed to other threads, and each vector sharing a storage can be read, modified and freed
+// from its own thread. A single vector must still not be used by several threads at once
+
+// Default functions set by vec_init
+void* alloc_buffer(uint size, uint count);
+void* realloc_buffer(void* old_buffer, uint old_size, uint new_size);
+void free_buffer(void* buffer);
+int equal_func(void* a, void* b, uint data_size);
+// Equality functions set by vecf_init and vecd_init, which compare by value instead of by bytes
+int floatcmp(float* a, float* b, uint data_size);
+int doublecmp(double* a, double* b, uint data_size);
 
 // Allocates a new vector dynamically and initializes it
 vector* vec_create(uint data_size);
@@ -27,6 +109,8 @@ vector* vec_create(uint data_size);
 void vec_free(vector* vec);
 // Initializes the vector with default parameters
 void vec_init(vector* vec, uint data_size);
+// Releases the data storage of a vector initialized with vec_init. The vector is left empty
+void vec_destroy(vector* vec);
 // Requests that the vector capacity be at least enough to contain n elements
 void vec_reserve(vector* vec, uint new_size);
 // Resizes the container so that it contains n elements
@@ -39,6 +123,8 @@ uint vec_max_size(vector* vec);
 uint vec_empty(vector* vec);
 // Requests the container to reduce its capacity to fit its size
 void vec_shrink_to_fit(vector* vec);
+// Gives the vector its own copy of the data storage if it shares it with other vectors
+void vec_own(vector* vec);
 // Returns the first position of the element in the vector, starting the search from offset.
 // If the element is not found, VEC_NPOS is returned
 uint vec_find(vector* vec, void* element, uint offset);
@@ -48,19 +134,21 @@ uint vec_find_last(vector* vec, void* element, uint offset);
 // Return 0 if the element is not stored in the vector
 uint vec_has(vector* vec, void* element);
 // Returns a pointer to the element at pos in the vector
-void* vec_at(vector* vec, uint pos);
+VEC_INLINE void* vec_at(vector* vec, uint pos);
+// Returns a read-only pointer to the element at pos in the vector. Unlike vec_at, it never copies a shared storage
+const void* vec_get(vector* vec, uint pos);
 // Returns a copy of the element at pos in the vector. The copy is stored in element
 void* vec_at_cp(vector* vec, uint pos, void* element);
 // Returns a reference to the first element in the vector
-void* vec_front(vector* vec);
+VEC_INLINE void* vec_front(vector* vec);
 // Returns a copy of the first element in the vector. The copy is stored in element
 void* vec_front_cp(vector* vec, void* element);
 // Returns a reference to the last element in the vector
-void* vec_back(vector* vec);
+VEC_INLINE void* vec_back(vector* vec);
 // Returns a copy of the last element in the vector. The copy is stored in element
 void* vec_back_cp(vector* vec, void* element);
 // Add element at the end. The value is copied to the vector
-void vec_push_back(vector* vec, void* element);
+VEC_INLINE void vec_push_back(vector* vec, void* element);
 // Removes the last element in the vector, effectively reducing the container size by one
 void vec_pop_back(vector* vec);
 // The vector is extended by inserting new elements before the element at the specified position, 
@@ -75,13 +163,74 @@ void vec_erase_range(vector* vec, uint first, uint last);
 // Removes all elements from the vector, leaving the container with a size of 0. This does not affect capacity
 void vec_clear(vector* vec);
 // Compares 2 vectors, returning 0 if v1 equals v2, that is, if both vectors have the same number of elements,
-// and their values are equal too. It uses vector.cmp_func to compare the values
+// and their values are equal too. It uses vector.equal_func to compare the values
 int vec_cmp(vector* v1, vector* v2);
 // Copy count elements, from v1 to v2, in the range v1[v1_off, v1_off+count) to v2[v2_off, v2_off+count)
-// and returns v2
+// and returns v2. Vector functions never use other threads: vec_bulk_copy and vec_bulk_fill (parallel.h) copy
+// big buffers in parallel
 vector* vec_cpy(vector* v1, vector* v2, uint v1_off, uint count, uint v2_off);
-// Duplicates the vector, in the range [offset, offset+count)
+// Duplicates the vector, in the range [offset, offset+count). The copy shares the data storage
+// with vec until one of them is modified, so this is O(1). The deferred copy is done like in vec_cpy
 vector* vec_dup(vector* vec, uint offset, uint count);
+// Replaces the contents of the vector by the first count elements of buffer, which has room for capacity elements,
+// without copying them. The vector takes ownership of buffer and releases it with free_func (NULL for free).
+// Buffers not released with free are moved to a buffer of malloc the first time the vector reallocates, and the
+// vector then uses the default allocator
+void vec_adopt(vector* vec, void* buffer, uint count, uint capacity, free_function free_func);
+// Takes the buffer out of the vector without copying it, leaving the vector empty, and stores the number of
+// elements in count if it is not NULL. The caller must release the buffer with the vector free_func. If the buffer
+// was shared with other vectors, the vector gets its own copy first
+void* vec_release(vector* vec, uint* count);
+// Exchanges the contents of 2 vectors in O(1)
+void vec_swap(vector* v1, vector* v2);
+// Moves the contents of src to dst in O(1), releasing the old contents of dst. src is left empty
+void vec_move(vector* dst, vector* src);
+// Returns the counters of the vector, and its current slack. Without VEC_STATS the counters are always 0
+vec_stats vec_get_stats(vector* vec);
+// Sets the counters of the vector to 0. Its peak capacity becomes its current capacity
+void vec_reset_stats(vector* vec);
+// Sets the hook called on each reallocation of any vector, whatever its realloc_func, or removes it if hook is NULL.
+// The hook is not copied: it must stay valid while reallocations can still call it. Without a hook, reallocations
+// are not timed
+void vec_set_realloc_hook(const vec_realloc_hook* hook);
+// Called when a check of VEC_CHECK_ALWAYS fails, with the condition that failed and the function that checked it.
+// The function then returns NULL, or does nothing if it returns no value
+typedef void (*vec_check_handler)(const char* condition, const char* function);
+// Sets the handler of failed checks, or removes it if handler is NULL. The default is vec_check_print
+void vec_set_check_handler(vec_check_handler handler);
+// Check handler that writes the failed check to stderr
+void vec_check_print(const char* condition, const char* function);
+// Calls the check handler, if any. Used by the accessors of inline.h
+void vec_check_failed(const char* condition, const char* function);
+
+
+// =========================== VECTOR VIEWS ===================================
+//
+// Views give zero-copy access to a range [offset, offset+count) of a vector or of any buffer.
+// They are passed by value and never allocate, except for vec_view_dup
+
+// Returns a view of the vector elements in the range [offset, offset+count)
+vec_view vec_slice(vector* vec, uint offset, uint count);
+// Returns a view of count elements of data_size bytes stored in buffer. Elements are compared with memcmp
+vec_view vec_view_from(const void* buffer, uint count, uint data_size);
+// Returns a view of the elements in the range [offset, offset+count) of view
+vec_view vec_view_slice(vec_view view, uint offset, uint count);
+// Returns the first position of the element in the view, starting the search from offset.
+// If the element is not found, VEC_NPOS is returned
+uint vec_view_find(vec_view view, const void* element, uint offset);
+// Returns the last position of the element in the view, starting the search from size-1-offset.
+// If the element is not found, VEC_NPOS is returned
+uint vec_view_find_last(vec_view view, const void* element, uint offset);
+// Return 0 if the element is not in the view
+uint vec_view_has(vec_view view, const void* element);
+// Returns a read-only pointer to the element at pos in the view
+const void* vec_view_at(vec_view view, uint pos);
+// Returns a copy of the element at pos in the view. The copy is stored in element
+void* vec_view_at_cp(vec_view view, uint pos, void* element);
+// Compares 2 views, returning 0 if both have the same number of elements and their values are equal
+int vec_view_cmp(vec_view v1, vec_view v2);
+// Allocates a new vector holding a copy of the elements of the view
+vector* vec_view_dup(vec_view view);
 
 
 // =========================== VECTOR VALUE-TYPE SPECIALIZATIONS ===================================
@@ -108,7 +257,7 @@ void vecc_resize_val(vector* vec, uint new_size, char val);
 uint vecc_find(vector* vec, char element, uint offset);
 uint vecc_find_last(vector* vec, char element, uint offset);
 uint vecc_has(vector* vec, char element);
-char* vecc_at(vector* vec, uint pos);
+VEC_INLINE char* vecc_at(vector* vec, uint pos);
 char vecc_at_cp(vector* vec, uint pos);
 char* vecc_front(vector* vec);
 char vecc_front_cp(vector* vec);
@@ -126,7 +275,7 @@ void vecuc_resize_val(vector* vec, uint new_size, unsigned char val);
 uint vecuc_find(vector* vec, unsigned char element, uint offset);
 uint vecuc_find_last(vector* vec, unsigned char element, uint offset);
 uint vecuc_has(vector* vec, unsigned char element);
-unsigned char* vecuc_at(vector* vec, uint pos);
+VEC_INLINE unsigned char* vecuc_at(vector* vec, uint pos);
 unsigned char vecuc_at_cp(vector* vec, uint pos);
 unsigned char* vecuc_front(vector* vec);
 unsigned char vecuc_front_cp(vector* vec);
@@ -144,7 +293,7 @@ void vecs_resize_val(vector* vec, uint new_size, short val);
 uint vecs_find(vector* vec, short element, uint offset);
 uint vecs_find_last(vector* vec, short element, uint offset);
 uint vecs_has(vector* vec, short element);
-short* vecs_at(vector* vec, uint pos);
+VEC_INLINE short* vecs_at(vector* vec, uint pos);
 short vecs_at_cp(vector* vec, uint pos);
 short* vecs_front(vector* vec);
 short vecs_front_cp(vector* vec);
@@ -162,7 +311,7 @@ void vecus_resize_val(vector* vec, uint new_size, unsigned short val);
 uint vecus_find(vector* vec, unsigned short element, uint offset);
 uint vecus_find_last(vector* vec, unsigned short element, uint offset);
 uint vecus_has(vector* vec, unsigned short element);
-unsigned short* vecus_at(vector* vec, uint pos);
+VEC_INLINE unsigned short* vecus_at(vector* vec, uint pos);
 unsigned short vecus_at_cp(vector* vec, uint pos);
 unsigned short* vecus_front(vector* vec);
 unsigned short vecus_front_cp(vector* vec);
@@ -180,7 +329,7 @@ void veci_resize_val(vector* vec, uint new_size, int val);
 uint veci_find(vector* vec, int element, uint offset);
 uint veci_find_last(vector* vec, int element, uint offset);
 uint veci_has(vector* vec, int element);
-int* veci_at(vector* vec, uint pos);
+VEC_INLINE int* veci_at(vector* vec, uint pos);
 int veci_at_cp(vector* vec, uint pos);
 int* veci_front(vector* vec);
 int veci_front_cp(vector* vec);
@@ -198,7 +347,7 @@ void vecui_resize_val(vector* vec, uint new_size, unsigned int val);
 uint vecui_find(vector* vec, unsigned int element, uint offset);
 uint vecui_find_last(vector* vec, unsigned int element, uint offset);
 uint vecui_has(vector* vec, unsigned int element);
-unsigned int* vecui_at(vector* vec, uint pos);
+VEC_INLINE unsigned int* vecui_at(vector* vec, uint pos);
 unsigned int vecui_at_cp(vector* vec, uint pos);
 unsigned int* vecui_front(vector* vec);
 unsigned int vecui_front_cp(vector* vec);
@@ -216,7 +365,7 @@ void vecl_resize_val(vector* vec, uint new_size, long val);
 uint vecl_find(vector* vec, long element, uint offset);
 uint vecl_find_last(vector* vec, long element, uint offset);
 uint vecl_has(vector* vec, long element);
-long* vecl_at(vector* vec, uint pos);
+VEC_INLINE long* vecl_at(vector* vec, uint pos);
 long vecl_at_cp(vector* vec, uint pos);
 long* vecl_front(vector* vec);
 long vecl_front_cp(vector* vec);
@@ -234,7 +383,7 @@ void vecul_resize_val(vector* vec, uint new_size, unsigned long val);
 uint vecul_find(vector* vec, unsigned long element, uint offset);
 uint vecul_find_last(vector* vec, unsigned long element, uint offset);
 uint vecul_has(vector* vec, unsigned long element);
-unsigned long* vecul_at(vector* vec, uint pos);
+VEC_INLINE unsigned long* vecul_at(vector* vec, uint pos);
 unsigned long vecul_at_cp(vector* vec, uint pos);
 unsigned long* vecul_front(vector* vec);
 unsigned long vecul_front_cp(vector* vec);
@@ -252,7 +401,7 @@ void vecf_resize_val(vector* vec, uint new_size, float val);
 uint vecf_find(vector* vec, float element, uint offset);
 uint vecf_find_last(vector* vec, float element, uint offset);
 uint vecf_has(vector* vec, float element);
-float* vecf_at(vector* vec, uint pos);
+VEC_INLINE float* vecf_at(vector* vec, uint pos);
 float vecf_at_cp(vector* vec, uint pos);
 float* vecf_front(vector* vec);
 float vecf_front_cp(vector* vec);
@@ -270,7 +419,7 @@ void vecd_resize_val(vector* vec, uint new_size, double val);
 uint vecd_find(vector* vec, double element, uint offset);
 uint vecd_find_last(vector* vec, double element, uint offset);
 uint vecd_has(vector* vec, double element);
-double* vecd_at(vector* vec, uint pos);
+VEC_INLINE double* vecd_at(vector* vec, uint pos);
 double vecd_at_cp(vector* vec, uint pos);
 double* vecd_front(vector* vec);
 double vecd_front_cp(vector* vec);
@@ -278,4 +427,8 @@ double* vecd_back(vector* vec);
 double vecd_back_cp(vector* vec);
 void vecd_push_back(vector* vec, double element);
 void vecd_insert(vector* vec, uint pos, double element);
-void vecd_replace(vector* vec, uint pos, double element);
\ No newline at end of file
+void vecd_replace(vector* vec, uint pos, double element);
+
+#ifdef VEC_HEADER_ONLY
+#include "inline.h"
+#endif
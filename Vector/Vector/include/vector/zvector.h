@@ -0,0 +1,82 @@
+#pragma once
+#include "vector.h"
+
+// Number of values packed together in a block
+#define ZVEC_BLOCK_SIZE 128
+
+// Header of a packed block. Values are stored as (value - min), using bits bits each
+typedef struct zvec_block
+{
+	unsigned long long min; // Smallest value of the block (frame of reference)
+	unsigned long long max; // Largest value of the block
+	uint offset; // Index of the first word of the block in zvector.words
+	uint bits; // Number of bits used by each value of the block
+} zvec_block;
+
+// Compressed vector of integers. Values are appended to an uncompressed tail, which is bit-packed
+// with frame-of-reference encoding every ZVEC_BLOCK_SIZE elements. Signed values are stored with
+// their sign bit flipped, so blocks keep the order of the values and can be skipped by min/max
+typedef struct zvector
+{
+	vector blocks; // Headers of the packed blocks (zvec_block)
+	vector words; // Packed values (unsigned long long), followed by one padding word
+	unsigned long long tail[ZVEC_BLOCK_SIZE]; // Values that are not packed yet
+	uint size; // Number of elements in the vector
+	uint data_size; // Size of each element, in bytes: 1, 2, 4 or 8
+	uint is_signed; // Whether the elements are signed integers
+} zvector;
+
+// Allocates a new compressed vector dynamically and initializes it
+zvector* zvec_create(uint data_size, uint is_signed);
+// Free the compressed vector and its data storage
+void zvec_free(zvector* zv);
+// Initializes the compressed vector for integers of data_size bytes
+void zvec_init(zvector* zv, uint data_size, uint is_signed);
+// Releases the data storage of a compressed vector initialized with zvec_init
+void zvec_destroy(zvector* zv);
+// Returns the number of elements in the compressed vector
+uint zvec_size(zvector* zv);
+// Returns the number of bytes used to store the elements
+uint zvec_memory(zvector* zv);
+// Add element at the end. The value is copied to the vector
+void zvec_push_back(zvector* zv, const void* element);
+// Returns a copy of the element at pos in the vector. The copy is stored in element
+void* zvec_at_cp(zvector* zv, uint pos, void* element);
+// Returns the first position of the element in the vector, starting the search from offset.
+// Blocks whose [min, max] range does not contain the element are skipped without decoding them.
+// If the element is not found, VEC_NPOS is returned
+uint zvec_find(zvector* zv, const void* element, uint offset);
+// Return 0 if the element is not stored in the vector
+uint zvec_has(zvector* zv, const void* element);
+// Decodes the count elements of the block starting at pos, which must be a multiple of ZVEC_BLOCK_SIZE,
+// into elements. Returns count
+uint zvec_decode(zvector* zv, uint pos, void* elements);
+// Appends all the elements of vec, which must have the same data_size
+void zvec_append(zvector* zv, vector* vec);
+// Decodes all the elements into vec, replacing its contents, and returns vec
+vector* zvec_to_vec(zvector* zv, vector* vec);
+
+// =========================== VALUE-TYPE SPECIALIZATIONS ===================================
+//
+// int: zveci
+// unsigned int: zvecui
+// unsigned long: zvecul
+//
+
+zvector* zveci_create();
+void zveci_init(zvector* zv);
+void zveci_push_back(zvector* zv, int element);
+int zveci_at(zvector* zv, uint pos);
+uint zveci_find(zvector* zv, int element, uint offset);
+
+zvector* zvecui_create();
+void zvecui_init(zvector* zv);
+void zvecui_push_back(zvector* zv, unsigned int element);
+unsigned int zvecui_at(zvector* zv, uint pos);
+uint zvecui_find(zvector* zv, unsigned int element, uint offset);
+
+zvector* zvecul_create();
+void zvecul_init(zvector* zv);
+void zvecul_push_back(zvector* zv, unsigned long element);
+unsigned long zvecul_at(zvector* zv, uint pos);
+uint zvecul_find(zvector* zv, unsigned long element, uint offset);
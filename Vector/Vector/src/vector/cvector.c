@@ -0,0 +1,397 @@
+#include "vector/cvector.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+#include <threads.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CPU_PAUSE() _mm_pause()
+#else
+#define CPU_PAUSE()
+#endif
+
+// Spins of a reader waiting for a write section before it yields its time slice
+#define READ_SPINS 64
+
+static char* elements(cvec_buffer* buffer)
+{
+	return (char*)(buffer+1);
+}
+
+static cvec_buffer* new_buffer(cvector* cv, uint capacity)
+{
+	cvec_buffer* buffer = (cvec_buffer*)cv->alloc_func(sizeof(cvec_buffer) + capacity* cv->data_size, 1);
+	buffer->capacity = capacity;
+	buffer->retired_epoch = 0;
+	buffer->next = NULL;
+
+	return buffer;
+}
+
+// Starts a modification: readers that overlap with it will retry
+static void write_begin(cvector* cv)
+{
+	atomic_fetch_add_explicit(&cv->seq, 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+static void write_end(cvector* cv)
+{
+	atomic_fetch_add_explicit(&cv->seq, 1, memory_order_release);
+}
+
+// Waits until no modification is in progress, and returns the sequence number. Write sections only
+// publish changes prepared before them, so the wait is short
+static uint read_seq(cvector* cv)
+{
+	uint seq;
+
+	for(uint spins = 0;(seq = atomic_load_explicit(&cv->seq, memory_order_acquire)) & 1;++spins)
+	{
+		if(spins < READ_SPINS)
+			CPU_PAUSE();
+		else
+			thrd_yield();
+	}
+
+	return seq;
+}
+
+// Returns whether the vector was modified since read_seq returned seq
+static int read_retry(cvector* cv, uint seq)
+{
+	atomic_thread_fence(memory_order_acquire);
+
+	return atomic_load_explicit(&cv->seq, memory_order_relaxed) != seq;
+}
+
+// Returns a new buffer of capacity elements with the elements of the current one, where the removed elements
+// at pos are replaced by inserted, if it is not NULL. Only the writer modifies the current buffer, so this is
+// done outside of any write section while readers keep reading the current buffer
+static cvec_buffer* rebuild(cvector* cv, uint capacity, uint pos, const void* inserted, uint removed)
+{
+	cvec_buffer* old = atomic_load_explicit(&cv->current, memory_order_relaxed);
+	cvec_buffer* buffer = new_buffer(cv, capacity);
+	const uint size = atomic_load_explicit(&cv->size, memory_order_relaxed);
+	const uint data_size = cv->data_size;
+	char* data = elements(buffer);
+	uint next = pos;
+
+	if(old != NULL)
+	{
+		memcpy(data, elements(old), pos* data_size);
+	}
+
+	if(inserted != NULL)
+	{
+		memcpy(data + pos* data_size, inserted, data_size);
+		++next;
+	}
+
+	if(old != NULL)
+	{
+		memcpy(data + next* data_size, elements(old) + (pos + removed)* data_size, (size - pos - removed)* data_size);
+	}
+
+	return buffer;
+}
+
+// Replaces the current buffer by buffer, holding size elements, and retires the old one
+static void publish(cvector* cv, cvec_buffer* buffer, uint size)
+{
+	cvec_buffer* old = atomic_load_explicit(&cv->current, memory_order_relaxed);
+
+	write_begin(cv);
+	// Sequentially consistent, so readers either see the new buffer or are seen by cvec_reclaim
+	atomic_store(&cv->current, buffer);
+	atomic_store_explicit(&cv->size, size, memory_order_relaxed);
+	write_end(cv);
+
+	if(old != NULL)
+	{
+		old->retired_epoch = atomic_fetch_add(&cv->epoch, 1);
+		old->next = cv->retired;
+		cv->retired = old;
+		cvec_reclaim(cv);
+	}
+}
+
+cvector* cvec_create(uint data_size)
+{
+	cvector* cv = (cvector*)malloc(sizeof(cvector));
+
+	cvec_init(cv, data_size);
+
+	return cv;
+}
+
+void cvec_free(cvector* cv)
+{
+	assert(cv != NULL);
+
+	cvec_destroy(cv);
+	free(cv);
+}
+
+void cvec_init(cvector* cv, uint data_size)
+{
+	assert(cv != NULL);
+
+	atomic_init(&cv->current, NULL);
+	atomic_init(&cv->size, 0);
+	atomic_init(&cv->seq, 0);
+	// Epochs start at 1, 0 marks idle readers
+	atomic_init(&cv->epoch, 1);
+
+	for(uint i = 0;i < CVEC_MAX_READERS;++i)
+	{
+		atomic_init(&cv->readers[i], 0);
+	}
+
+	cv->retired = NULL;
+	cv->data_size = data_size;
+	cv->alloc_func = alloc_buffer;
+	cv->free_func = free_buffer;
+	cv->equal_func = equal_func;
+}
+
+void cvec_destroy(cvector* cv)
+{
+	assert(cv != NULL);
+
+	while(cv->retired != NULL)
+	{
+		cvec_buffer* next = cv->retired->next;
+		cv->free_func(cv->retired);
+		cv->retired = next;
+	}
+
+	cvec_buffer* buffer = atomic_load_explicit(&cv->current, memory_order_relaxed);
+
+	if(buffer != NULL)
+	{
+		cv->free_func(buffer);
+	}
+
+	atomic_store_explicit(&cv->current, NULL, memory_order_relaxed);
+	atomic_store_explicit(&cv->size, 0, memory_order_relaxed);
+}
+
+void cvec_read_begin(cvector* cv, uint reader)
+{
+	assert(cv != NULL);
+	assert(reader < CVEC_MAX_READERS);
+
+	atomic_store(&cv->readers[reader], atomic_load(&cv->epoch));
+}
+
+void cvec_read_end(cvector* cv, uint reader)
+{
+	assert(cv != NULL);
+	assert(reader < CVEC_MAX_READERS);
+
+	atomic_store_explicit(&cv->readers[reader], 0, memory_order_release);
+}
+
+uint cvec_size(cvector* cv)
+{
+	assert(cv != NULL);
+
+	return atomic_load_explicit(&cv->size, memory_order_acquire);
+}
+
+int cvec_at_cp(cvector* cv, uint pos, void* element)
+{
+	assert(cv != NULL);
+	assert(element != NULL);
+
+	for(;;)
+	{
+		const uint seq = read_seq(cv);
+		cvec_buffer* buffer = atomic_load(&cv->current);
+		const uint size = atomic_load_explicit(&cv->size, memory_order_relaxed);
+
+		if(pos >= size)
+		{
+			if(!read_retry(cv, seq))
+				return 0;
+
+			continue;
+		}
+
+		// The copy may race with the writer, in which case it is discarded
+		memcpy(element, elements(buffer) + pos* cv->data_size, cv->data_size);
+
+		if(!read_retry(cv, seq))
+			return 1;
+	}
+}
+
+uint cvec_find(cvector* cv, const void* element, uint offset)
+{
+	assert(cv != NULL);
+
+	if(element == NULL)
+		return VEC_NPOS;
+
+	for(;;)
+	{
+		const uint seq = read_seq(cv);
+		cvec_buffer* buffer = atomic_load(&cv->current);
+		const uint size = atomic_load_explicit(&cv->size, memory_order_relaxed);
+		const uint data_size = cv->data_size;
+		uint result = VEC_NPOS;
+
+		for(uint i = offset;i < size;++i)
+		{
+			if(cv->equal_func(elements(buffer) + i*data_size, (void*)element, data_size))
+			{
+				result = i;
+				break;
+			}
+		}
+
+		if(!read_retry(cv, seq))
+			return result;
+	}
+}
+
+vector* cvec_to_vec(cvector* cv, vector* vec)
+{
+	assert(cv != NULL);
+	assert(vec != NULL);
+	assert(vec->data_size == cv->data_size);
+
+	for(;;)
+	{
+		const uint seq = read_seq(cv);
+		cvec_buffer* buffer = atomic_load(&cv->current);
+		const uint size = atomic_load_explicit(&cv->size, memory_order_relaxed);
+
+		vec_resize(vec, size);
+
+		if(size > 0)
+		{
+			memcpy(vec->buffer, elements(buffer), size* cv->data_size);
+		}
+
+		if(!read_retry(cv, seq))
+			return vec;
+	}
+}
+
+void cvec_reserve(cvector* cv, uint new_size)
+{
+	assert(cv != NULL);
+
+	cvec_buffer* buffer = atomic_load_explicit(&cv->current, memory_order_relaxed);
+	const uint size = atomic_load_explicit(&cv->size, memory_order_relaxed);
+
+	if(buffer != NULL && new_size <= buffer->capacity)
+		return;
+
+	publish(cv, rebuild(cv, new_size, size, NULL, 0), size);
+}
+
+void cvec_push_back(cvector* cv, const void* element)
+{
+	assert(cv != NULL);
+
+	cvec_insert(cv, atomic_load_explicit(&cv->size, memory_order_relaxed), element);
+}
+
+void cvec_insert(cvector* cv, uint pos, const void* element)
+{
+	assert(cv != NULL);
+	assert(element != NULL);
+
+	const uint size = atomic_load_explicit(&cv->size, memory_order_relaxed);
+	const uint data_size = cv->data_size;
+	cvec_buffer* buffer = atomic_load_explicit(&cv->current, memory_order_relaxed);
+
+	assert(pos <= size);
+
+	if(buffer != NULL && size < buffer->capacity && pos == size)
+	{
+		// The slot after the last element is not read by readers, so only the new size is published
+		memcpy(elements(buffer) + pos*data_size, element, data_size);
+
+		write_begin(cv);
+		atomic_store_explicit(&cv->size, size+1, memory_order_relaxed);
+		write_end(cv);
+		return;
+	}
+
+	// Shifting the elements in place would make readers wait for it, so they are copied to a new buffer
+	const uint capacity = buffer == NULL ? 1 : size == buffer->capacity ? size* 2 : buffer->capacity;
+
+	publish(cv, rebuild(cv, capacity, pos, element, 0), size+1);
+}
+
+void cvec_replace(cvector* cv, uint pos, const void* element)
+{
+	assert(cv != NULL);
+	assert(pos < atomic_load_explicit(&cv->size, memory_order_relaxed));
+	assert(element != NULL);
+
+	cvec_buffer* buffer = atomic_load_explicit(&cv->current, memory_order_relaxed);
+
+	write_begin(cv);
+	memcpy(elements(buffer) + pos* cv->data_size, element, cv->data_size);
+	write_end(cv);
+}
+
+void cvec_erase(cvector* cv, uint pos)
+{
+	assert(cv != NULL);
+
+	const uint size = atomic_load_explicit(&cv->size, memory_order_relaxed);
+	cvec_buffer* buffer = atomic_load_explicit(&cv->current, memory_order_relaxed);
+
+	assert(pos < size);
+
+	if(pos == size-1)
+	{
+		write_begin(cv);
+		atomic_store_explicit(&cv->size, size-1, memory_order_relaxed);
+		write_end(cv);
+		return;
+	}
+
+	publish(cv, rebuild(cv, buffer->capacity, pos, NULL, 1), size-1);
+}
+
+void cvec_reclaim(cvector* cv)
+{
+	assert(cv != NULL);
+
+	// Oldest epoch a reader may still be in
+	uint min_epoch = atomic_load(&cv->epoch);
+
+	for(uint i = 0;i < CVEC_MAX_READERS;++i)
+	{
+		const uint epoch = atomic_load(&cv->readers[i]);
+
+		if(epoch != 0 && epoch < min_epoch)
+			min_epoch = epoch;
+	}
+
+	// A buffer retired in epoch e can be seen by readers that entered in epoch e or before
+	cvec_buffer** link = &cv->retired;
+
+	while(*link != NULL)
+	{
+		cvec_buffer* buffer = *link;
+
+		if(buffer->retired_epoch < min_epoch)
+		{
+			*link = buffer->next;
+			cv->free_func(buffer);
+		}
+		else
+		{
+			link = &buffer->next;
+		}
+	}
+}
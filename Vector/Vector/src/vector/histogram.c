@@ -0,0 +1,205 @@
+#include "vector/histogram.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <threads.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define SUB_BUCKETS (1U << VEC_HISTOGRAM_SUB_BITS)
+
+static uint log2_floor(unsigned long long x)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanReverse64(&index, x);
+	return index;
+#elif defined(_MSC_VER)
+	// _BitScanReverse64 only exists on 64 bit targets
+	unsigned long index;
+	if(_BitScanReverse(&index, (unsigned long)(x >> 32)))
+		return index + 32;
+	_BitScanReverse(&index, (unsigned long)x);
+	return index;
+#elif defined(__GNUC__)
+	return 63 - __builtin_clzll(x);
+#else
+	uint index = 0;
+	while(x >>= 1) ++index;
+	return index;
+#endif
+}
+
+// Values below SUB_BUCKETS have their own bucket. Bigger values are grouped by their highest bit, and
+// then by the next VEC_HISTOGRAM_SUB_BITS bits
+static uint bucket_index(unsigned long long value)
+{
+	if(value < SUB_BUCKETS)
+		return (uint)value;
+
+	const uint exponent = log2_floor(value);
+	const uint sub = (uint)(value >> (exponent - VEC_HISTOGRAM_SUB_BITS)) & (SUB_BUCKETS - 1);
+
+	return (exponent - VEC_HISTOGRAM_SUB_BITS + 1)* SUB_BUCKETS + sub;
+}
+
+// Largest value of a bucket
+static unsigned long long bucket_max(uint index)
+{
+	if(index < SUB_BUCKETS)
+		return index;
+
+	const uint shift = index / SUB_BUCKETS - 1;
+	const unsigned long long first = (unsigned long long)(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+
+	return first + ((1ULL << shift) - 1);
+}
+
+vec_histogram* vec_histogram_create()
+{
+	vec_histogram* h = (vec_histogram*)malloc(sizeof(vec_histogram));
+
+	vec_histogram_init(h);
+
+	return h;
+}
+
+void vec_histogram_free(vec_histogram* h)
+{
+	assert(h != NULL);
+
+	free(h);
+}
+
+void vec_histogram_init(vec_histogram* h)
+{
+	assert(h != NULL);
+
+	for(uint i = 0;i < VEC_HISTOGRAM_BUCKETS;++i)
+	{
+		atomic_init(&h->buckets[i], 0);
+	}
+
+	atomic_init(&h->count, 0);
+	atomic_init(&h->sum, 0);
+	atomic_init(&h->max, 0);
+}
+
+void vec_histogram_reset(vec_histogram* h)
+{
+	assert(h != NULL);
+
+	for(uint i = 0;i < VEC_HISTOGRAM_BUCKETS;++i)
+	{
+		atomic_store_explicit(&h->buckets[i], 0, memory_order_relaxed);
+	}
+
+	atomic_store_explicit(&h->count, 0, memory_order_relaxed);
+	atomic_store_explicit(&h->sum, 0, memory_order_relaxed);
+	atomic_store_explicit(&h->max, 0, memory_order_relaxed);
+}
+
+void vec_histogram_record(vec_histogram* h, unsigned long long value)
+{
+	assert(h != NULL);
+
+	atomic_fetch_add_explicit(&h->buckets[bucket_index(value)], 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&h->sum, value, memory_order_relaxed);
+
+	unsigned long long max = atomic_load_explicit(&h->max, memory_order_relaxed);
+	while(value > max && !atomic_compare_exchange_weak_explicit(&h->max, &max, value,
+		memory_order_relaxed, memory_order_relaxed))
+		;
+
+	// Last, so that readers that see the count see the bucket too
+	atomic_fetch_add_explicit(&h->count, 1, memory_order_release);
+}
+
+unsigned long long vec_histogram_count(vec_histogram* h)
+{
+	assert(h != NULL);
+
+	return atomic_load_explicit(&h->count, memory_order_acquire);
+}
+
+double vec_histogram_mean(vec_histogram* h)
+{
+	assert(h != NULL);
+
+	const unsigned long long count = vec_histogram_count(h);
+
+	return count == 0 ? 0 : (double)atomic_load_explicit(&h->sum, memory_order_relaxed) / count;
+}
+
+unsigned long long vec_histogram_max(vec_histogram* h)
+{
+	assert(h != NULL);
+
+	return atomic_load_explicit(&h->max, memory_order_relaxed);
+}
+
+unsigned long long vec_histogram_percentile(vec_histogram* h, double percentile)
+{
+	assert(h != NULL);
+	assert(percentile >= 0 && percentile <= 100);
+
+	const unsigned long long count = vec_histogram_count(h);
+	const unsigned long long max = vec_histogram_max(h);
+
+	if(count == 0)
+		return 0;
+
+	unsigned long long target = (unsigned long long)(percentile / 100.0* count + 0.5);
+	unsigned long long seen = 0;
+
+	if(target == 0)
+		target = 1;
+
+	for(uint i = 0;i < VEC_HISTOGRAM_BUCKETS;++i)
+	{
+		seen += atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+
+		if(seen >= target)
+		{
+			const unsigned long long value = bucket_max(i);
+			return value < max ? value : max;
+		}
+	}
+
+	return max;
+}
+
+void vec_histogram_print(vec_histogram* h, FILE* file, const char* name)
+{
+	assert(h != NULL);
+	assert(file != NULL);
+
+	fprintf(file, "%s: count %llu, mean %.1f, p50 %llu, p90 %llu, p99 %llu, p99.9 %llu, max %llu\n", name,
+		vec_histogram_count(h), vec_histogram_mean(h), vec_histogram_percentile(h, 50),
+		vec_histogram_percentile(h, 90), vec_histogram_percentile(h, 99), vec_histogram_percentile(h, 99.9),
+		vec_histogram_max(h));
+}
+
+void vec_histogram_realloc_hook(vector* vec, uint old_capacity, uint new_capacity, unsigned long long ns, void* ctx)
+{
+	vec_histogram_record((vec_histogram*)ctx, ns);
+}
+
+static vec_histogram realloc_histogram;
+static vec_realloc_hook realloc_tracker = { vec_histogram_realloc_hook, &realloc_histogram };
+static once_flag realloc_histogram_once = ONCE_FLAG_INIT;
+
+static void init_realloc_histogram()
+{
+	vec_histogram_init(&realloc_histogram);
+}
+
+vec_histogram* vec_track_reallocs()
+{
+	call_once(&realloc_histogram_once, init_realloc_histogram);
+
+	vec_set_realloc_hook(&realloc_tracker);
+
+	return &realloc_histogram;
+}
@@ -0,0 +1,440 @@
+// For ftello, fseeko and writev, hidden by -std=c11. Offsets are 64 bits on 32 bit systems too
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "vector/io.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <limits.h>
+
+#ifdef _WIN32
+#include <io.h>
+
+struct iovec
+{
+	void* iov_base;
+	size_t iov_len;
+};
+
+// Windows has no writev, so the buffers are written one after another
+static long long writev(int fd, const struct iovec* iov, int count)
+{
+	long long total = 0;
+
+	for(int i = 0;i < count;++i)
+	{
+		const int written = _write(fd, iov[i].iov_base, (unsigned)iov[i].iov_len);
+
+		if(written < 0)
+			return total > 0 ? total : -1;
+
+		total += written;
+
+		if((size_t)written < iov[i].iov_len)
+			break;
+	}
+
+	return total;
+}
+
+#define read(fd, buffer, bytes) _read(fd, buffer, (unsigned)(bytes))
+#define lseek _lseeki64
+#define fseeko _fseeki64
+#define ftello _ftelli64
+#else
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+
+static uint swap32(uint value)
+{
+	return (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+}
+
+uint vec_io_checksum(const void* data, uint bytes, int swap)
+{
+	const unsigned char* p = data;
+	uint64_t a = 0, b = 0;
+	uint word;
+
+	for(;bytes >= 4;bytes -= 4, p += 4)
+	{
+		memcpy(&word, p, 4);
+		a += swap ? swap32(word) : word;
+		b += a;
+	}
+
+	if(bytes > 0)
+	{
+		// The last word is padded with zeroes, in the byte order of the writer
+		unsigned char tail[4] = { 0, 0, 0, 0 };
+		memcpy(tail, p, bytes);
+		memcpy(&word, tail, 4);
+		a += swap ? swap32(word) : word;
+		b += a;
+	}
+
+	return (uint)(a ^ b ^ (b >> 32));
+}
+
+// Reverses the bytes of each element of data_size bytes
+static void swap_elements(void* buffer, uint count, uint data_size)
+{
+	unsigned char* p = buffer;
+
+	for(uint i = 0;i < count;++i, p += data_size)
+	{
+		for(uint j = 0;j < data_size / 2;++j)
+		{
+			const unsigned char tmp = p[j];
+			p[j] = p[data_size-1-j];
+			p[data_size-1-j] = tmp;
+		}
+	}
+}
+
+// =========================== WRITING ===================================
+
+static vec_io_header make_header(uint data_size, uint count, uint checksum)
+{
+	vec_io_header header = { VEC_IO_MAGIC, VEC_IO_VERSION, VEC_IO_ENDIANNESS, data_size, count, checksum };
+
+	return header;
+}
+
+// Writes all the buffers, continuing after partial writes
+static vec_io_result write_all(int fd, struct iovec* iov, int count)
+{
+	while(count > 0)
+	{
+		const long long written = writev(fd, iov, count);
+
+		if(written < 0)
+		{
+			if(errno == EINTR)
+				continue;
+
+			return VEC_IO_ERROR;
+		}
+
+		size_t left = (size_t)written;
+
+		while(count > 0 && left >= iov->iov_len)
+		{
+			left -= iov->iov_len;
+			++iov;
+			--count;
+		}
+
+		if(count > 0)
+		{
+			iov->iov_base = (char*)iov->iov_base + left;
+			iov->iov_len -= left;
+		}
+	}
+
+	return VEC_IO_OK;
+}
+
+vec_io_result vec_write(vector* vec, FILE* file)
+{
+	assert(vec != NULL);
+	assert(file != NULL);
+
+	const uint bytes = vec->size* vec->data_size;
+	const vec_io_header header = make_header(vec->data_size, vec->size, vec_io_checksum(vec->buffer, bytes, 0));
+
+	if(fwrite(&header, sizeof(header), 1, file) != 1)
+		return VEC_IO_ERROR;
+
+	if(bytes > 0 && fwrite(vec->buffer, bytes, 1, file) != 1)
+		return VEC_IO_ERROR;
+
+	return VEC_IO_OK;
+}
+
+vec_io_result vec_write_fd(vector* vec, int fd)
+{
+	assert(vec != NULL);
+
+	const uint bytes = vec->size* vec->data_size;
+	vec_io_header header = make_header(vec->data_size, vec->size, vec_io_checksum(vec->buffer, bytes, 0));
+	struct iovec iov[2] = { { &header, sizeof(header) }, { vec->buffer, bytes } };
+
+	return write_all(fd, iov, bytes > 0 ? 2 : 1);
+}
+
+vec_io_result vec_stream_begin(int fd, uint data_size)
+{
+	vec_io_header header = make_header(data_size, VEC_IO_CHUNKED, 0);
+	struct iovec iov = { &header, sizeof(header) };
+
+	return write_all(fd, &iov, 1);
+}
+
+vec_io_result vec_stream_write(int fd, vector* vec, uint offset, uint count)
+{
+	assert(vec != NULL);
+	assert(offset <= vec->size);
+	assert(count <= vec->size - offset);
+
+	// An empty chunk would end the stream
+	if(count == 0)
+		return VEC_IO_OK;
+
+	const uint bytes = count* vec->data_size;
+	char* elements = (char*)vec->buffer + offset* vec->data_size;
+	vec_io_chunk chunk = { count, vec_io_checksum(elements, bytes, 0) };
+	struct iovec iov[2] = { { &chunk, sizeof(chunk) }, { elements, bytes } };
+
+	return write_all(fd, iov, 2);
+}
+
+vec_io_result vec_stream_end(int fd)
+{
+	vec_io_chunk chunk = { 0, 0 };
+	struct iovec iov = { &chunk, sizeof(chunk) };
+
+	return write_all(fd, &iov, 1);
+}
+
+// =========================== READING ===================================
+
+// Smallest growth of the capacity while reading elements whose count is not known to be in the source, in bytes
+#define READ_STEP (64U << 10)
+
+// Where the data is read from: file if it is not NULL, fd otherwise
+typedef struct source
+{
+	FILE* file;
+	int fd;
+} source;
+
+static vec_io_result read_all(source* src, void* buffer, size_t bytes)
+{
+	if(bytes == 0)
+		return VEC_IO_OK;
+
+	if(src->file != NULL)
+	{
+		if(fread(buffer, bytes, 1, src->file) == 1)
+			return VEC_IO_OK;
+
+		return ferror(src->file) ? VEC_IO_ERROR : VEC_IO_EOF;
+	}
+
+	char* p = buffer;
+
+	while(bytes > 0)
+	{
+		const long long n = read(src->fd, p, bytes);
+
+		if(n < 0)
+		{
+			if(errno == EINTR)
+				continue;
+
+			return VEC_IO_ERROR;
+		}
+
+		if(n == 0)
+			return VEC_IO_EOF;
+
+		p += n;
+		bytes -= (size_t)n;
+	}
+
+	return VEC_IO_OK;
+}
+
+// Returns the number of bytes left to read from the source, or -1 if it can not tell, like pipes
+static long long remaining_bytes(source* src)
+{
+	long long position, end;
+
+	if(src->file != NULL)
+	{
+		position = (long long)ftello(src->file);
+
+		if(position < 0 || fseeko(src->file, 0, SEEK_END) != 0)
+			return -1;
+
+		end = (long long)ftello(src->file);
+		fseeko(src->file, position, SEEK_SET);
+	}
+	else
+	{
+		position = (long long)lseek(src->fd, 0, SEEK_CUR);
+
+		if(position < 0)
+			return -1;
+
+		end = (long long)lseek(src->fd, 0, SEEK_END);
+		lseek(src->fd, position, SEEK_SET);
+	}
+
+	return end >= position ? end - position : -1;
+}
+
+// Reads count elements at the end of the vector. Counts come from the data, so unless the vector already has room
+// for them, the capacity only grows as the elements arrive, at least doubling each time to keep appends amortized
+static vec_io_result read_elements(vector* vec, source* src, uint count, uint checksum, int swap)
+{
+	const uint first = vec->size;
+	const uint step = READ_STEP / vec->data_size > 0 ? READ_STEP / vec->data_size : 1;
+	uint left = count;
+
+	while(left > 0)
+	{
+		if(vec->size == vec_max_size(vec))
+		{
+			const uint max_size = vec_max_size(vec);
+			const uint doubled = max_size <= UINT_MAX / vec->data_size / 2 ? max_size* 2 : UINT_MAX / vec->data_size;
+			const uint next = vec->size + (left < step ? left : step);
+			const uint target = doubled > next ? doubled : next;
+
+			vec_reserve(vec, target < first + count ? target : first + count);
+		}
+
+		const uint n = vec_max_size(vec) - vec->size < left ? vec_max_size(vec) - vec->size : left;
+		const vec_io_result result = read_all(src, (char*)vec->buffer + vec->size* vec->data_size, (size_t)n* vec->data_size);
+
+		if(result != VEC_IO_OK)
+		{
+			vec->size = first;
+			return result;
+		}
+
+		vec->size += n;
+		left -= n;
+	}
+
+	char* elements = (char*)vec->buffer + first* vec->data_size;
+
+	if(vec_io_checksum(elements, count* vec->data_size, swap) != checksum)
+	{
+		vec->size = first;
+		return VEC_IO_BAD_CHECKSUM;
+	}
+
+	if(swap)
+	{
+		swap_elements(elements, count, vec->data_size);
+	}
+
+	return VEC_IO_OK;
+}
+
+// Returns whether count more elements can be stored in the vector without overflowing its capacity in bytes.
+// Counts come from the data, so they are checked before they are used
+static int fits(vector* vec, uint count)
+{
+	const uint max_count = UINT_MAX / vec->data_size;
+
+	return vec->size <= max_count && count <= max_count - vec->size;
+}
+
+static vec_io_result read_vector(vector* vec, source* src)
+{
+	assert(vec != NULL);
+
+	vec_io_header header;
+	vec_io_result result = read_all(src, &header, sizeof(header));
+	int swap = 0;
+
+	if(result != VEC_IO_OK)
+		return result;
+
+	if(header.endianness == swap32(VEC_IO_ENDIANNESS))
+	{
+		swap = 1;
+		header.magic = swap32(header.magic);
+		header.version = swap32(header.version);
+		header.data_size = swap32(header.data_size);
+		header.count = swap32(header.count);
+		header.checksum = swap32(header.checksum);
+
+		// Only scalar elements can be converted
+		if(header.data_size != 1 && header.data_size != 2 && header.data_size != 4 && header.data_size != 8)
+			return VEC_IO_BAD_HEADER;
+	}
+	else if(header.endianness != VEC_IO_ENDIANNESS)
+	{
+		return VEC_IO_BAD_HEADER;
+	}
+
+	if(header.magic != VEC_IO_MAGIC || header.version != VEC_IO_VERSION || header.data_size != vec->data_size)
+		return VEC_IO_BAD_HEADER;
+
+	vec_clear(vec);
+
+	if(header.count != VEC_IO_CHUNKED)
+	{
+		if(!fits(vec, header.count))
+			return VEC_IO_BAD_HEADER;
+
+		const long long remaining = remaining_bytes(src);
+
+		// A truncated or corrupted header must not reserve more than the source holds. When the source can not
+		// tell its size, read_elements grows the vector as the elements arrive
+		if(remaining >= 0)
+		{
+			if((unsigned long long)header.count* header.data_size > (unsigned long long)remaining)
+				return VEC_IO_EOF;
+
+			vec_reserve(vec, header.count);
+		}
+
+		return read_elements(vec, src, header.count, header.checksum, swap);
+	}
+
+	for(;;)
+	{
+		vec_io_chunk chunk;
+
+		result = read_all(src, &chunk, sizeof(chunk));
+
+		if(result != VEC_IO_OK)
+			return result;
+
+		if(swap)
+		{
+			chunk.count = swap32(chunk.count);
+			chunk.checksum = swap32(chunk.checksum);
+		}
+
+		if(chunk.count == 0)
+			return VEC_IO_OK;
+
+		if(!fits(vec, chunk.count))
+			return VEC_IO_BAD_HEADER;
+
+		result = read_elements(vec, src, chunk.count, chunk.checksum, swap);
+
+		if(result != VEC_IO_OK)
+			return result;
+	}
+}
+
+vec_io_result vec_read(vector* vec, FILE* file)
+{
+	assert(file != NULL);
+
+	source src = { file, -1 };
+
+	return read_vector(vec, &src);
+}
+
+vec_io_result vec_read_fd(vector* vec, int fd)
+{
+	source src = { NULL, fd };
+
+	return read_vector(vec, &src);
+}
@@ -0,0 +1,326 @@
+// For pread, with 64 bit offsets on 32 bit systems too
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "vector/loader.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <threads.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define open _open
+#define close _close
+#define lseek _lseeki64
+#define read(fd, buffer, bytes) _read(fd, buffer, (unsigned)(bytes))
+#define O_RDONLY (_O_RDONLY | _O_BINARY)
+#else
+#include <unistd.h>
+#endif
+
+// State shared by the reading thread and the thread processing the chunks
+typedef struct loader
+{
+	int fd;
+	long long offset; // Position of the next read, for seekable files
+	long long remaining; // Bytes left to read, or -1 to read until the end
+	int seekable;
+	uint chunk_bytes;
+	char* buffers[2];
+	uint filled[2]; // Bytes read into each buffer
+	int full[2]; // Whether each buffer holds a chunk not processed yet
+	int last[2]; // Whether each buffer holds the last chunk
+	int stop; // Set by the processing thread to stop reading early
+	vec_io_result result;
+	mtx_t mutex;
+	cnd_t changed;
+} loader;
+
+// Reads up to bytes bytes, stopping early only at the end of the file
+static vec_io_result read_chunk(loader* l, char* buffer, uint bytes, uint* filled)
+{
+	*filled = 0;
+
+	while(*filled < bytes)
+	{
+		long long n;
+
+#ifdef _WIN32
+		// Only this thread reads, so seeking before each read is safe
+		if(l->seekable && lseek(l->fd, l->offset, SEEK_SET) < 0)
+			return VEC_IO_ERROR;
+
+		n = read(l->fd, buffer + *filled, bytes - *filled);
+#else
+		if(l->seekable)
+			n = pread(l->fd, buffer + *filled, bytes - *filled, (off_t)l->offset);
+		else
+			n = read(l->fd, buffer + *filled, bytes - *filled);
+#endif
+
+		if(n < 0)
+		{
+			if(errno == EINTR)
+				continue;
+
+			return VEC_IO_ERROR;
+		}
+
+		if(n == 0)
+			break;
+
+		*filled += (uint)n;
+		l->offset += n;
+	}
+
+	return VEC_IO_OK;
+}
+
+static int read_task(void* arg)
+{
+	loader* l = arg;
+
+	for(int i = 0;;i ^= 1)
+	{
+		mtx_lock(&l->mutex);
+
+		while(l->full[i] && !l->stop)
+		{
+			cnd_wait(&l->changed, &l->mutex);
+		}
+
+		const int stop = l->stop;
+		mtx_unlock(&l->mutex);
+
+		if(stop)
+			return 0;
+
+		uint bytes = l->chunk_bytes;
+
+		if(l->remaining >= 0 && l->remaining < bytes)
+			bytes = (uint)l->remaining;
+
+		uint filled;
+		const vec_io_result result = read_chunk(l, l->buffers[i], bytes, &filled);
+
+		if(l->remaining >= 0)
+			l->remaining -= filled;
+
+		const int last = result != VEC_IO_OK || filled < l->chunk_bytes || l->remaining == 0;
+
+		mtx_lock(&l->mutex);
+		l->filled[i] = filled;
+		l->full[i] = 1;
+		l->last[i] = last;
+
+		if(result != VEC_IO_OK)
+		{
+			l->result = result;
+		}
+		else if(l->remaining > 0 && filled < bytes)
+		{
+			// The file is shorter than expected
+			l->result = VEC_IO_EOF;
+		}
+
+		cnd_signal(&l->changed);
+		mtx_unlock(&l->mutex);
+
+		if(last)
+			return 0;
+	}
+}
+
+// Whether count more elements fit in the vector, whose size in bytes must fit in a uint
+static int fits(vector* vec, long long count)
+{
+	const uint max_count = UINT_MAX / vec->data_size;
+
+	return vec->size <= max_count && count <= max_count - vec->size;
+}
+
+static void append_chunk(vector* vec, const void* elements, uint count, void* ctx)
+{
+	const uint size = vec->size;
+
+	vec_resize(vec, size + count);
+	memcpy((char*)vec->buffer + size* vec->data_size, elements, count* vec->data_size);
+}
+
+// Processes the chunks read by the reading thread, until the last one or an error
+static void process_chunks(loader* l, vector* vec, vec_chunk_function func, void* ctx)
+{
+	const uint data_size = vec->data_size;
+
+	for(int i = 0;;i ^= 1)
+	{
+		mtx_lock(&l->mutex);
+
+		while(!l->full[i])
+		{
+			cnd_wait(&l->changed, &l->mutex);
+		}
+
+		const uint filled = l->filled[i];
+		const int last = l->last[i];
+		mtx_unlock(&l->mutex);
+
+		// A partial element at the end of a stream, or a stream longer than the vector can hold
+		const vec_io_result error = filled % data_size != 0 ? VEC_IO_EOF
+			: func == append_chunk && !fits(vec, filled / data_size) ? VEC_IO_BAD_HEADER : VEC_IO_OK;
+
+		if(error != VEC_IO_OK)
+		{
+			mtx_lock(&l->mutex);
+			l->result = error;
+			l->stop = 1;
+			cnd_signal(&l->changed);
+			mtx_unlock(&l->mutex);
+			break;
+		}
+
+		if(filled > 0)
+		{
+			func(vec, l->buffers[i], filled / data_size, ctx);
+		}
+
+		mtx_lock(&l->mutex);
+		l->full[i] = 0;
+		cnd_signal(&l->changed);
+		mtx_unlock(&l->mutex);
+
+		if(last)
+			break;
+	}
+}
+
+vec_io_result vec_load_fd(vector* vec, int fd, long long offset, long long bytes, uint chunk_bytes,
+	vec_chunk_function func, void* ctx)
+{
+	assert(vec != NULL);
+	assert(offset >= 0);
+	assert(bytes >= 0);
+
+	const uint data_size = vec->data_size;
+	loader l;
+
+	l.fd = fd;
+	l.offset = offset;
+	l.remaining = bytes > 0 ? bytes : -1;
+	l.seekable = lseek(fd, 0, SEEK_CUR) >= 0;
+
+	if(l.seekable && bytes == 0)
+	{
+		const long long end = lseek(fd, 0, SEEK_END);
+		l.remaining = end > offset ? end - offset : 0;
+	}
+
+	if(l.remaining == 0)
+		return VEC_IO_OK;
+
+	if(l.remaining > 0 && l.remaining % data_size != 0)
+		return VEC_IO_BAD_HEADER;
+
+	if(func == NULL)
+	{
+		func = append_chunk;
+
+		if(l.remaining > 0)
+		{
+			if(!fits(vec, l.remaining / data_size))
+				return VEC_IO_BAD_HEADER;
+
+			vec_reserve(vec, vec->size + (uint)(l.remaining / data_size));
+		}
+	}
+
+	l.chunk_bytes = (chunk_bytes > 0 ? chunk_bytes : VEC_LOAD_CHUNK) / data_size* data_size;
+	if(l.chunk_bytes == 0)
+		l.chunk_bytes = data_size;
+
+	l.buffers[0] = (char*)malloc(l.chunk_bytes);
+	l.buffers[1] = (char*)malloc(l.chunk_bytes);
+	l.full[0] = l.full[1] = 0;
+	l.stop = 0;
+	l.result = VEC_IO_OK;
+	mtx_init(&l.mutex, mtx_plain);
+	cnd_init(&l.changed);
+
+	thrd_t reader;
+
+	if(l.buffers[0] == NULL || l.buffers[1] == NULL || thrd_create(&reader, read_task, &l) != thrd_success)
+	{
+		l.result = VEC_IO_ERROR;
+	}
+	else
+	{
+		process_chunks(&l, vec, func, ctx);
+		thrd_join(reader, NULL);
+	}
+
+	mtx_destroy(&l.mutex);
+	cnd_destroy(&l.changed);
+	free(l.buffers[0]);
+	free(l.buffers[1]);
+
+	return l.result;
+}
+
+vec_io_result vec_load(vector* vec, const char* path, uint chunk_bytes, vec_chunk_function func, void* ctx)
+{
+	assert(vec != NULL);
+	assert(path != NULL);
+
+	const int fd = open(path, O_RDONLY);
+
+	if(fd < 0)
+		return VEC_IO_ERROR;
+
+	vec_io_header header;
+	uint filled = 0;
+	vec_io_result result = VEC_IO_OK;
+
+	while(filled < sizeof(header))
+	{
+		const long long n = read(fd, (char*)&header + filled, sizeof(header) - filled);
+
+		if(n <= 0)
+		{
+			result = n == 0 ? VEC_IO_EOF : VEC_IO_ERROR;
+			break;
+		}
+
+		filled += (uint)n;
+	}
+
+	if(result == VEC_IO_OK && (header.magic != VEC_IO_MAGIC || header.version != VEC_IO_VERSION
+		|| header.endianness != VEC_IO_ENDIANNESS || header.data_size != vec->data_size || header.count == VEC_IO_CHUNKED))
+	{
+		result = VEC_IO_BAD_HEADER;
+	}
+
+	if(result == VEC_IO_OK && header.count > 0)
+	{
+		const uint first = vec->size;
+
+		result = vec_load_fd(vec, fd, sizeof(header), (long long)header.count* header.data_size, chunk_bytes, func, ctx);
+
+		if(result == VEC_IO_OK && func == NULL
+			&& vec_io_checksum(vec_get(vec, first), header.count* header.data_size, 0) != header.checksum)
+		{
+			result = VEC_IO_BAD_CHECKSUM;
+		}
+	}
+
+	close(fd);
+
+	return result;
+}
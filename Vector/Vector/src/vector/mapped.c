@@ -0,0 +1,587 @@
+#ifdef __linux__
+// For mremap and memfd_create
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#else
+// For shm_open and ftruncate
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include "vector/mapped.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+
+#ifndef _WIN32
+#include <threads.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// The header of the file is mapped just before the elements
+#define HEADER_SIZE sizeof(vec_io_header)
+
+// File or shared memory object mapped by a vector. The allocator hooks only get the buffer, so the mappings
+// are looked up by buffer
+typedef struct mapping
+{
+	char* base; // Start of the mapping, where the header is
+	size_t length; // Size of the mapping, in bytes
+	uint header_size; // Offset of the elements
+	int fd;
+	int writable;
+	int shm; // Whether the header is a vec_shm_header
+	uint generation; // Generation of the shared memory object when it was mapped
+	char* moved; // Buffer in memory holding the elements after the mapping failed to grow, or NULL
+} mapping;
+
+static vector mappings;
+static mtx_t mappings_mutex;
+static once_flag mappings_once = ONCE_FLAG_INIT;
+
+static void init_mappings()
+{
+	vec_init(&mappings, sizeof(mapping));
+	mtx_init(&mappings_mutex, mtx_plain);
+}
+
+// Returns the position of the mapping of buffer in mappings, or VEC_NPOS. Must be called with mappings_mutex locked
+static uint find_mapping(const void* buffer)
+{
+	for(uint i = 0;i < mappings.size;++i)
+	{
+		const mapping* m = vec_get(&mappings, i);
+
+		if((m->moved != NULL ? m->moved : m->base + m->header_size) == buffer)
+			return i;
+	}
+
+	return VEC_NPOS;
+}
+
+static void unmap(mapping* m)
+{
+	free(m->moved);
+	munmap(m->base, m->length);
+	close(m->fd);
+}
+
+// Moves the elements of a mapping that can not grow to a buffer in memory, so the vector stays usable. The file
+// keeps the elements of the last sync, and vec_sync reports the failure. Returns NULL if there is no memory either
+static void* move_to_memory(mapping* m, uint old_size, uint new_size)
+{
+	char* buffer = malloc(new_size);
+
+	if(buffer != NULL)
+	{
+		memcpy(buffer, m->base + m->header_size, old_size < new_size ? old_size : new_size);
+		m->moved = buffer;
+	}
+
+	return buffer;
+}
+
+vector* vec_open_mapped(const char* path, uint data_size, vec_map_mode mode)
+{
+	assert(path != NULL);
+	assert(data_size > 0);
+
+	call_once(&mappings_once, init_mappings);
+
+	const int writable = mode == VEC_MAP_WRITE;
+	const int fd = open(path, writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+	struct stat st;
+
+	if(fd < 0)
+		return NULL;
+
+	if(fstat(fd, &st) != 0)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	size_t length = (size_t)st.st_size;
+	int created = 0;
+
+	if(length == 0 && writable)
+	{
+		// New file, with an empty vector
+		if(ftruncate(fd, HEADER_SIZE) != 0)
+		{
+			close(fd);
+			return NULL;
+		}
+
+		length = HEADER_SIZE;
+		created = 1;
+	}
+
+	if(length < HEADER_SIZE)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	// Private mappings of read-only files can still be written, the pages are copied by the OS
+	char* base = mmap(NULL, length, PROT_READ | PROT_WRITE, writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+
+	if(base == MAP_FAILED)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	vec_io_header* header = (vec_io_header*)base;
+
+	if(created)
+	{
+		const vec_io_header empty = { VEC_IO_MAGIC, VEC_IO_VERSION, VEC_IO_ENDIANNESS, data_size, 0, vec_io_checksum(NULL, 0, 0) };
+		*header = empty;
+	}
+
+	const uint capacity = (uint)((length - HEADER_SIZE) / data_size* data_size);
+
+	if(header->magic != VEC_IO_MAGIC || header->version != VEC_IO_VERSION || header->endianness != VEC_IO_ENDIANNESS
+		|| header->data_size != data_size || header->count == VEC_IO_CHUNKED || header->count > capacity / data_size)
+	{
+		munmap(base, length);
+		close(fd);
+		return NULL;
+	}
+
+	vector* vec = vec_create(data_size);
+	vec->buffer = base + HEADER_SIZE;
+	vec->size = header->count;
+	vec->capacity = capacity;
+	vec->realloc_func = vec_mapped_realloc;
+	vec->free_func = vec_mapped_free;
+
+	const mapping m = { base, length, HEADER_SIZE, fd, writable, 0, 0, NULL };
+
+	mtx_lock(&mappings_mutex);
+	vec_push_back(&mappings, (void*)&m);
+	mtx_unlock(&mappings_mutex);
+
+	return vec;
+}
+
+vec_io_result vec_sync(vector* vec)
+{
+	assert(vec != NULL);
+
+	call_once(&mappings_once, init_mappings);
+
+	mtx_lock(&mappings_mutex);
+
+	const uint pos = find_mapping(vec->buffer);
+	vec_io_result result = VEC_IO_OK;
+
+	// Read-only mappings and vectors whose elements were moved to memory have nothing to write
+	if(pos != VEC_NPOS)
+	{
+		const mapping* m = vec_get(&mappings, pos);
+
+		if(m->moved != NULL)
+		{
+			// The elements can no longer reach the file or the consumers
+			result = VEC_IO_ERROR;
+		}
+		else if(m->shm && m->writable)
+		{
+			// Elements written before are visible to consumers that see the new size
+			atomic_store_explicit(&((vec_shm_header*)m->base)->size, vec->size, memory_order_release);
+		}
+		else if(m->writable)
+		{
+			vec_io_header* header = (vec_io_header*)m->base;
+			header->count = vec->size;
+			header->checksum = vec_io_checksum(vec->buffer, vec->size* vec->data_size, 0);
+
+			if(msync(m->base, m->length, MS_SYNC) != 0)
+				result = VEC_IO_ERROR;
+		}
+	}
+
+	mtx_unlock(&mappings_mutex);
+
+	return result;
+}
+
+vec_io_result vec_close_mapped(vector* vec)
+{
+	assert(vec != NULL);
+
+	vec_io_result result = vec_sync(vec);
+
+	mtx_lock(&mappings_mutex);
+
+	const uint pos = find_mapping(vec->buffer);
+
+	// Vectors sharing the mapping may still read the capacity
+	if(pos != VEC_NPOS && vec->storage == NULL)
+	{
+		const mapping* m = vec_get(&mappings, pos);
+
+		if(m->writable && !m->shm && m->moved == NULL && ftruncate(m->fd, HEADER_SIZE + (size_t)vec->size* vec->data_size) != 0)
+			result = VEC_IO_ERROR;
+	}
+
+	mtx_unlock(&mappings_mutex);
+
+	vec_free(vec);
+
+	return result;
+}
+
+void* vec_mapped_realloc(void* old_buffer, uint old_size, uint new_size)
+{
+	call_once(&mappings_once, init_mappings);
+
+	mtx_lock(&mappings_mutex);
+
+	const uint pos = find_mapping(old_buffer);
+
+	if(pos == VEC_NPOS)
+	{
+		mtx_unlock(&mappings_mutex);
+		return realloc(old_buffer, new_size);
+	}
+
+	mapping* m = vec_at(&mappings, pos);
+	void* buffer = NULL;
+
+	if(m->moved != NULL)
+	{
+		buffer = realloc(m->moved, new_size);
+
+		if(buffer != NULL)
+			m->moved = buffer;
+	}
+	else if(m->writable && m->shm && m->header_size + (size_t)new_size <= m->length)
+	{
+		// Shared memory objects never shrink, consumers may still be reading past the new capacity
+		buffer = old_buffer;
+	}
+	else if(m->writable)
+	{
+		const size_t length = m->header_size + (size_t)new_size;
+
+		if(ftruncate(m->fd, length) == 0)
+		{
+#ifdef __linux__
+			char* base = mremap(m->base, m->length, length, MREMAP_MAYMOVE);
+#else
+			// The old mapping is kept until the new one succeeds
+			char* base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, m->fd, 0);
+
+			if(base != MAP_FAILED)
+				munmap(m->base, m->length);
+#endif
+			if(base != MAP_FAILED)
+			{
+				m->base = base;
+				m->length = length;
+				buffer = base + m->header_size;
+
+				if(m->shm)
+				{
+					// Tells consumers to remap
+					vec_shm_header* header = (vec_shm_header*)base;
+					atomic_store_explicit(&header->capacity, new_size, memory_order_relaxed);
+					atomic_fetch_add_explicit(&header->generation, 1, memory_order_release);
+				}
+			}
+		}
+
+		// The old mapping is still valid, but it can not hold new_size bytes
+		if(buffer == NULL)
+			buffer = move_to_memory(m, old_size, new_size);
+	}
+	else
+	{
+		// A private mapping can not grow past the file, so the elements are moved to memory
+		buffer = malloc(new_size);
+
+		if(buffer != NULL)
+		{
+			memcpy(buffer, old_buffer, old_size < new_size ? old_size : new_size);
+			unmap(m);
+			vec_erase(&mappings, pos);
+		}
+	}
+
+	mtx_unlock(&mappings_mutex);
+
+	return buffer;
+}
+
+void vec_mapped_free(void* buffer)
+{
+	call_once(&mappings_once, init_mappings);
+
+	mtx_lock(&mappings_mutex);
+
+	const uint pos = find_mapping(buffer);
+
+	if(pos == VEC_NPOS)
+	{
+		free(buffer);
+	}
+	else
+	{
+		unmap(vec_at(&mappings, pos));
+		vec_erase(&mappings, pos);
+	}
+
+	mtx_unlock(&mappings_mutex);
+}
+
+// =========================== SHARED MEMORY ===================================
+
+#define SHM_HEADER_SIZE sizeof(vec_shm_header)
+
+// Maps a shared memory object and adds it to the mappings. The object is initialized if create is not 0
+static vector* map_shm(int fd, uint data_size, int create)
+{
+	assert(data_size > 0);
+
+	call_once(&mappings_once, init_mappings);
+
+	if(create && ftruncate(fd, SHM_HEADER_SIZE) != 0)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	struct stat st;
+
+	if(fstat(fd, &st) != 0 || (size_t)st.st_size < SHM_HEADER_SIZE)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	const size_t length = (size_t)st.st_size;
+	char* base = mmap(NULL, length, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+
+	if(base == MAP_FAILED)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	vec_shm_header* header = (vec_shm_header*)base;
+
+	if(create)
+	{
+		header->magic = VEC_SHM_MAGIC;
+		header->data_size = data_size;
+		atomic_init(&header->size, 0);
+		atomic_init(&header->capacity, 0);
+		atomic_init(&header->generation, 0);
+	}
+
+	// The size is read first, so the storage holding the published elements is already mapped
+	const uint size = atomic_load_explicit(&header->size, memory_order_acquire);
+	const uint generation = atomic_load_explicit(&header->generation, memory_order_acquire);
+	const uint capacity = atomic_load_explicit(&header->capacity, memory_order_relaxed);
+
+	if(header->magic != VEC_SHM_MAGIC || header->data_size != data_size || SHM_HEADER_SIZE + (size_t)capacity > length)
+	{
+		munmap(base, length);
+		close(fd);
+		return NULL;
+	}
+
+	vector* vec = vec_create(data_size);
+	vec->buffer = base + SHM_HEADER_SIZE;
+	vec->size = size;
+	vec->capacity = capacity;
+	vec->realloc_func = vec_mapped_realloc;
+	vec->free_func = vec_mapped_free;
+
+	const mapping m = { base, length, SHM_HEADER_SIZE, fd, create, 1, generation, NULL };
+
+	mtx_lock(&mappings_mutex);
+	vec_push_back(&mappings, (void*)&m);
+	mtx_unlock(&mappings_mutex);
+
+	return vec;
+}
+
+vector* vec_shm_create(const char* name, uint data_size)
+{
+	int fd;
+
+	if(name == NULL)
+	{
+#ifdef __linux__
+		fd = memfd_create("vector", 0);
+#else
+		fd = -1;
+#endif
+	}
+	else
+	{
+		fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	}
+
+	if(fd < 0)
+		return NULL;
+
+	return map_shm(fd, data_size, 1);
+}
+
+vector* vec_shm_attach(const char* name, uint data_size)
+{
+	assert(name != NULL);
+
+	const int fd = shm_open(name, O_RDONLY, 0);
+
+	if(fd < 0)
+		return NULL;
+
+	return map_shm(fd, data_size, 0);
+}
+
+vector* vec_shm_attach_fd(int fd, uint data_size)
+{
+	const int copy = dup(fd);
+
+	if(copy < 0)
+		return NULL;
+
+	return map_shm(copy, data_size, 0);
+}
+
+int vec_shm_fd(vector* vec)
+{
+	assert(vec != NULL);
+
+	call_once(&mappings_once, init_mappings);
+
+	mtx_lock(&mappings_mutex);
+
+	const uint pos = find_mapping(vec->buffer);
+	const int fd = pos != VEC_NPOS ? ((const mapping*)vec_get(&mappings, pos))->fd : -1;
+
+	mtx_unlock(&mappings_mutex);
+
+	return fd;
+}
+
+int vec_shm_refresh(vector* vec)
+{
+	assert(vec != NULL);
+
+	call_once(&mappings_once, init_mappings);
+
+	mtx_lock(&mappings_mutex);
+
+	const uint pos = find_mapping(vec->buffer);
+	int remapped = 0;
+
+	assert(pos != VEC_NPOS);
+
+	mapping* m = vec_at(&mappings, pos);
+	vec_shm_header* header = (vec_shm_header*)m->base;
+	const uint size = atomic_load_explicit(&header->size, memory_order_acquire);
+	const uint generation = atomic_load_explicit(&header->generation, memory_order_acquire);
+
+	if(generation != m->generation)
+	{
+		const uint capacity = atomic_load_explicit(&header->capacity, memory_order_relaxed);
+		const size_t length = SHM_HEADER_SIZE + (size_t)capacity;
+		char* base = mmap(NULL, length, PROT_READ, MAP_SHARED, m->fd, 0);
+
+		if(base != MAP_FAILED)
+		{
+			munmap(m->base, m->length);
+			m->base = base;
+			m->length = length;
+			m->generation = generation;
+			vec->buffer = base + SHM_HEADER_SIZE;
+			vec->capacity = capacity;
+			remapped = 1;
+		}
+	}
+
+	vec->size = size;
+
+	mtx_unlock(&mappings_mutex);
+
+	return remapped;
+}
+
+int vec_shm_unlink(const char* name)
+{
+	assert(name != NULL);
+
+	return shm_unlink(name);
+}
+
+#else
+
+vector* vec_open_mapped(const char* path, uint data_size, vec_map_mode mode)
+{
+	return NULL;
+}
+
+vec_io_result vec_sync(vector* vec)
+{
+	return VEC_IO_OK;
+}
+
+vec_io_result vec_close_mapped(vector* vec)
+{
+	vec_free(vec);
+
+	return VEC_IO_OK;
+}
+
+void* vec_mapped_realloc(void* old_buffer, uint old_size, uint new_size)
+{
+	return realloc(old_buffer, new_size);
+}
+
+void vec_mapped_free(void* buffer)
+{
+	free(buffer);
+}
+
+vector* vec_shm_create(const char* name, uint data_size)
+{
+	return NULL;
+}
+
+vector* vec_shm_attach(const char* name, uint data_size)
+{
+	return NULL;
+}
+
+vector* vec_shm_attach_fd(int fd, uint data_size)
+{
+	return NULL;
+}
+
+int vec_shm_fd(vector* vec)
+{
+	return -1;
+}
+
+int vec_shm_refresh(vector* vec)
+{
+	return 0;
+}
+
+int vec_shm_unlink(const char* name)
+{
+	return -1;
+}
+
+#endif
@@ -0,0 +1,260 @@
+#include "vector/mpvector.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+#include <limits.h>
+#include <threads.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static uint log2_floor(uint x)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse(&index, x);
+	return index;
+#elif defined(__GNUC__)
+	return 31 - __builtin_clz(x);
+#else
+	uint index = 0;
+	while(x >>= 1) ++index;
+	return index;
+#endif
+}
+
+static uint segment_size(uint segment)
+{
+	return MPVEC_FIRST_SEGMENT << segment;
+}
+
+// Finds the segment of the element at pos, and its position inside the segment
+static uint locate(uint pos, uint* offset)
+{
+	// Segment k starts at MPVEC_FIRST_SEGMENT * (2^k - 1)
+	assert(pos < 0U - MPVEC_FIRST_SEGMENT);
+
+	const uint biased = pos + MPVEC_FIRST_SEGMENT;
+	const uint segment = log2_floor(biased) - log2_floor(MPVEC_FIRST_SEGMENT);
+
+	*offset = biased - (MPVEC_FIRST_SEGMENT << segment);
+
+	return segment;
+}
+
+static atomic_uchar* ready_flags(char* segment)
+{
+	return (atomic_uchar*)segment;
+}
+
+static char* segment_elements(char* segment, uint index)
+{
+	// Flags take one byte per element, so elements stay aligned to the segment size
+	return segment + segment_size(index);
+}
+
+// Installed in place of a segment that could not be allocated, so that the pushers waiting for it give up
+static char failed_segment;
+
+// Returns the segment of the slot at offset, or NULL if it can not be allocated. The pusher of the first slot
+// allocates the segment, and the pushers of the other slots wait for it
+static char* get_segment(mpvector* mpv, uint index, uint offset)
+{
+	char* segment = atomic_load_explicit(&mpv->segments[index], memory_order_acquire);
+
+	if(segment == NULL)
+	{
+		const uint size = segment_size(index);
+
+		// The flags and the elements of the segment are allocated together
+		if(mpv->data_size >= UINT_MAX / size)
+			return NULL;
+
+		if(offset == 0)
+		{
+			segment = (char*)mpv->alloc_func(size, 1 + mpv->data_size);
+
+			if(segment != NULL)
+			{
+				for(uint i = 0;i < size;++i)
+				{
+					atomic_init(&ready_flags(segment)[i], 0);
+				}
+			}
+			else
+			{
+				segment = &failed_segment;
+			}
+
+			atomic_store_explicit(&mpv->segments[index], segment, memory_order_release);
+		}
+		else
+		{
+			while((segment = atomic_load_explicit(&mpv->segments[index], memory_order_acquire)) == NULL)
+			{
+				thrd_yield();
+			}
+		}
+	}
+
+	return segment != &failed_segment ? segment : NULL;
+}
+
+mpvector* mpvec_create(uint data_size)
+{
+	mpvector* mpv = (mpvector*)malloc(sizeof(mpvector));
+
+	mpvec_init(mpv, data_size);
+
+	return mpv;
+}
+
+void mpvec_free(mpvector* mpv)
+{
+	assert(mpv != NULL);
+
+	mpvec_destroy(mpv);
+	free(mpv);
+}
+
+void mpvec_init(mpvector* mpv, uint data_size)
+{
+	assert(mpv != NULL);
+
+	for(uint i = 0;i < MPVEC_SEGMENTS;++i)
+	{
+		atomic_init(&mpv->segments[i], NULL);
+	}
+
+	mpv->data_size = data_size;
+	mpv->alloc_func = alloc_buffer;
+	mpv->free_func = free_buffer;
+	mpv->equal_func = equal_func;
+	atomic_init(&mpv->reserved, 0);
+	atomic_init(&mpv->published, 0);
+}
+
+void mpvec_destroy(mpvector* mpv)
+{
+	assert(mpv != NULL);
+
+	for(uint i = 0;i < MPVEC_SEGMENTS;++i)
+	{
+		char* segment = atomic_load_explicit(&mpv->segments[i], memory_order_relaxed);
+
+		if(segment != NULL && segment != &failed_segment)
+			mpv->free_func(segment);
+
+		atomic_store_explicit(&mpv->segments[i], NULL, memory_order_relaxed);
+	}
+
+	atomic_store_explicit(&mpv->reserved, 0, memory_order_relaxed);
+	atomic_store_explicit(&mpv->published, 0, memory_order_relaxed);
+}
+
+uint mpvec_push_back(mpvector* mpv, const void* element)
+{
+	assert(mpv != NULL);
+	assert(element != NULL);
+
+	const uint pos = atomic_fetch_add_explicit(&mpv->reserved, 1, memory_order_relaxed);
+
+	uint offset;
+	const uint index = locate(pos, &offset);
+	char* segment = get_segment(mpv, index, offset);
+
+	// The slot is never ready, so commits stop before it
+	if(segment == NULL)
+		return VEC_NPOS;
+
+	memcpy(segment_elements(segment, index) + offset* mpv->data_size, element, mpv->data_size);
+	atomic_store_explicit(&ready_flags(segment)[offset], 1, memory_order_release);
+
+	return pos;
+}
+
+uint mpvec_commit(mpvector* mpv)
+{
+	assert(mpv != NULL);
+
+	uint published = atomic_load_explicit(&mpv->published, memory_order_acquire);
+
+	for(;;)
+	{
+		const uint reserved = atomic_load_explicit(&mpv->reserved, memory_order_acquire);
+		uint end = published;
+
+		while(end < reserved)
+		{
+			uint offset;
+			const uint index = locate(end, &offset);
+			char* segment = atomic_load_explicit(&mpv->segments[index], memory_order_acquire);
+
+			if(segment == NULL || segment == &failed_segment || !atomic_load_explicit(&ready_flags(segment)[offset], memory_order_acquire))
+				break;
+
+			++end;
+		}
+
+		if(end == published)
+			return published;
+
+		// On failure published holds the value set by another thread, which may already be further
+		if(atomic_compare_exchange_weak_explicit(&mpv->published, &published, end,
+			memory_order_acq_rel, memory_order_acquire))
+		{
+			return end;
+		}
+	}
+}
+
+uint mpvec_size(mpvector* mpv)
+{
+	assert(mpv != NULL);
+
+	return atomic_load_explicit(&mpv->published, memory_order_acquire);
+}
+
+const void* mpvec_at(mpvector* mpv, uint pos)
+{
+	assert(mpv != NULL);
+	assert(pos < mpvec_size(mpv));
+
+	uint offset;
+	const uint index = locate(pos, &offset);
+	char* segment = atomic_load_explicit(&mpv->segments[index], memory_order_acquire);
+
+	return segment_elements(segment, index) + offset* mpv->data_size;
+}
+
+void* mpvec_at_cp(mpvector* mpv, uint pos, void* element)
+{
+	assert(element != NULL);
+
+	return memcpy(element, mpvec_at(mpv, pos), mpv->data_size);
+}
+
+vector* mpvec_to_vec(mpvector* mpv, vector* vec)
+{
+	assert(mpv != NULL);
+	assert(vec != NULL);
+	assert(vec->data_size == mpv->data_size);
+
+	const uint size = mpvec_size(mpv);
+
+	vec_resize(vec, size);
+
+	char* buffer = vec->buffer;
+
+	// Copy segment by segment
+	for(uint index = 0, first = 0;first < size;first += segment_size(index), ++index)
+	{
+		char* segment = atomic_load_explicit(&mpv->segments[index], memory_order_acquire);
+		const uint count = size - first < segment_size(index) ? size - first : segment_size(index);
+
+		memcpy(buffer + first* mpv->data_size, segment_elements(segment, index), count* mpv->data_size);
+	}
+
+	return vec;
+}
@@ -0,0 +1,195 @@
+#ifdef __linux__
+// For syscall and madvise
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif
+
+#include "vector/numa.h"
+#include "vector/parallel.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <memory.h>
+#include <assert.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+// From linux/mempolicy.h
+#define MPOL_PREFERRED 1
+#define MPOL_INTERLEAVE 3
+#endif
+
+// Policy of the nodes. Only read by the allocation functions, so it is set before allocating
+static vec_numa_policy numa_policy = VEC_NUMA_FIRST_TOUCH;
+static uint numa_node = 0;
+
+void vec_numa_set_policy(vec_numa_policy policy, uint node)
+{
+	assert(policy != VEC_NUMA_NODE || node < vec_numa_nodes());
+
+	numa_policy = policy;
+	numa_node = node;
+}
+
+uint vec_numa_nodes()
+{
+#ifdef __linux__
+	uint nodes = 0;
+	char path[64];
+
+	for(;;)
+	{
+		sprintf(path, "/sys/devices/system/node/node%u", nodes);
+
+		if(access(path, F_OK) != 0)
+			break;
+
+		++nodes;
+	}
+
+	return nodes > 0 ? nodes : 1;
+#else
+	return 1;
+#endif
+}
+
+#ifdef __linux__
+// Node of the CPU the calling thread is running on
+static uint current_node()
+{
+	unsigned cpu = 0, node = 0;
+
+	if(syscall(SYS_getcpu, &cpu, &node, NULL) != 0)
+		return 0;
+
+	return node;
+}
+
+// Applies the current policy and huge page advice to a buffer aligned to huge pages
+static void place(void* buffer, size_t bytes)
+{
+#ifdef MADV_HUGEPAGE
+	madvise(buffer, bytes, MADV_HUGEPAGE);
+#endif
+
+	const uint nodes = vec_numa_nodes();
+	unsigned long mask = 0;
+	int mode;
+
+	if(numa_policy == VEC_NUMA_FIRST_TOUCH || nodes == 1)
+		return;
+
+	switch(numa_policy)
+	{
+	case VEC_NUMA_LOCAL:
+		mode = MPOL_PREFERRED;
+		mask = 1UL << current_node();
+		break;
+	case VEC_NUMA_NODE:
+		mode = MPOL_PREFERRED;
+		mask = 1UL << numa_node;
+		break;
+	default:
+		mode = MPOL_INTERLEAVE;
+		mask = nodes >= sizeof(mask)*8 ? ~0UL : (1UL << nodes) - 1;
+		break;
+	}
+
+	// A failure leaves the default policy, which is still correct
+	syscall(SYS_mbind, buffer, bytes, mode, &mask, sizeof(mask)*8, 0);
+}
+#endif
+
+void* vec_numa_alloc(uint size, uint count)
+{
+	const size_t bytes = (size_t)size* count;
+
+	if(bytes < VEC_HUGE_PAGE_SIZE)
+		return malloc(bytes);
+
+#ifdef __linux__
+	// Whole huge pages, so that no other allocation shares them
+	const size_t rounded = (bytes + VEC_HUGE_PAGE_SIZE - 1) / VEC_HUGE_PAGE_SIZE* VEC_HUGE_PAGE_SIZE;
+	void* buffer;
+
+	if(posix_memalign(&buffer, VEC_HUGE_PAGE_SIZE, rounded) != 0)
+		return NULL;
+
+	place(buffer, rounded);
+
+	return buffer;
+#else
+	return malloc(bytes);
+#endif
+}
+
+void* vec_numa_realloc(void* old_buffer, uint old_size, uint new_size)
+{
+	if(new_size < VEC_HUGE_PAGE_SIZE)
+	{
+		// Buffers are always allocated with malloc or posix_memalign, so they can be shrunk by realloc
+		return realloc(old_buffer, new_size);
+	}
+
+	// realloc would lose the alignment and the policy
+	void* buffer = vec_numa_alloc(new_size, 1);
+
+	// Like realloc, the old buffer is kept if the new one can not be allocated
+	if(buffer == NULL)
+		return NULL;
+
+	if(old_buffer != NULL)
+	{
+		vec_bulk_copy(buffer, old_buffer, old_size < new_size ? old_size : new_size, 0);
+		free(old_buffer);
+	}
+
+	return buffer;
+}
+
+void vec_numa_use(vector* vec)
+{
+	assert(vec != NULL);
+
+	vec->alloc_func = vec_numa_alloc;
+	vec->realloc_func = vec_numa_realloc;
+}
+
+typedef struct touch_job
+{
+	char* buffer;
+	uint data_size;
+	uint first; // First new element
+} touch_job;
+
+static void touch_range(uint first, uint last, uint worker, void* ctx)
+{
+	touch_job* job = ctx;
+
+	if(first < job->first)
+		first = job->first;
+
+	if(first < last)
+	{
+		memset(job->buffer + first* job->data_size, 0, (last - first)* job->data_size);
+	}
+}
+
+void vec_numa_resize(vector* vec, uint new_size)
+{
+	assert(vec != NULL);
+
+	const uint old_size = vec->size;
+
+	vec_resize(vec, new_size);
+
+	if(new_size <= old_size)
+		return;
+
+	// Same job size and alignment as vec_parallel_for, so each worker touches the pages it will process
+	touch_job job = { vec->buffer, vec->data_size, old_size };
+	vec_pool_run(vec_pool_default(), new_size, vec_cache_align(vec->data_size), touch_range, &job);
+}
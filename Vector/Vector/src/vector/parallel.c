@@ -0,0 +1,570 @@
+#include "vector/parallel.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#include <malloc.h>
+#else
+#include <unistd.h>
+#endif
+
+static unsigned long long pack(uint first, uint last)
+{
+	return (unsigned long long)first << 32 | last;
+}
+
+// Takes the first task of the worker. Returns 0 if it has none left
+static int pop_task(vec_pool_worker* worker, uint* task)
+{
+	unsigned long long tasks = atomic_load(&worker->tasks);
+
+	for(;;)
+	{
+		const uint first = (uint)(tasks >> 32);
+		const uint last = (uint)tasks;
+
+		if(first >= last)
+			return 0;
+
+		if(atomic_compare_exchange_weak(&worker->tasks, &tasks, pack(first+1, last)))
+		{
+			*task = first;
+			return 1;
+		}
+	}
+}
+
+// Moves the second half of the remaining tasks of a victim to the thief. Returns 0 if there was nothing to steal
+static int steal_tasks(vec_pool* pool, uint thief)
+{
+	for(uint i = 1;i < pool->size;++i)
+	{
+		vec_pool_worker* victim = &pool->workers[(thief + i) % pool->size];
+		unsigned long long tasks = atomic_load(&victim->tasks);
+
+		for(;;)
+		{
+			const uint first = (uint)(tasks >> 32);
+			const uint last = (uint)tasks;
+
+			if(first >= last)
+				break;
+
+			const uint half = (last - first + 1) / 2;
+
+			if(atomic_compare_exchange_weak(&victim->tasks, &tasks, pack(first, last-half)))
+			{
+				atomic_store(&pool->workers[thief].tasks, pack(last-half, last));
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void work(vec_pool* pool, uint worker)
+{
+	uint task;
+
+	do
+	{
+		while(pop_task(&pool->workers[worker], &task))
+		{
+			const uint first = task* pool->task_size;
+			const uint last = pool->count - first < pool->task_size ? pool->count : first + pool->task_size;
+
+			pool->func(first, last, worker, pool->ctx);
+		}
+	}
+	while(steal_tasks(pool, worker));
+}
+
+typedef struct thread_arg
+{
+	vec_pool* pool;
+	uint worker;
+} thread_arg;
+
+static int thread_main(void* arg)
+{
+	vec_pool* pool = ((thread_arg*)arg)->pool;
+	const uint worker = ((thread_arg*)arg)->worker;
+	uint generation = 0;
+
+	free(arg);
+
+	for(;;)
+	{
+		mtx_lock(&pool->mutex);
+
+		while(pool->generation == generation && !pool->stop)
+		{
+			cnd_wait(&pool->start, &pool->mutex);
+		}
+
+		if(pool->stop)
+		{
+			mtx_unlock(&pool->mutex);
+			return 0;
+		}
+
+		generation = pool->generation;
+		mtx_unlock(&pool->mutex);
+
+		work(pool, worker);
+
+		mtx_lock(&pool->mutex);
+		if(--pool->running == 0)
+		{
+			cnd_signal(&pool->done);
+		}
+		mtx_unlock(&pool->mutex);
+	}
+}
+
+uint vec_hardware_threads()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#else
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (uint)count : 1;
+#endif
+}
+
+vec_pool* vec_pool_create(uint size, uint grain)
+{
+	vec_pool* pool = (vec_pool*)malloc(sizeof(vec_pool));
+
+	pool->size = size > 0 ? size : vec_hardware_threads();
+	pool->grain = grain > 0 ? grain : VEC_DEFAULT_GRAIN;
+	pool->threads = (thrd_t*)malloc(pool->size* sizeof(thrd_t));
+	pool->workers = (vec_pool_worker*)vec_cache_alloc(pool->size* sizeof(vec_pool_worker));
+	pool->generation = 0;
+	pool->running = 0;
+	pool->stop = 0;
+
+	mtx_init(&pool->run_mutex, mtx_plain);
+	mtx_init(&pool->mutex, mtx_plain);
+	cnd_init(&pool->start);
+	cnd_init(&pool->done);
+
+	for(uint i = 0;i < pool->size;++i)
+	{
+		atomic_init(&pool->workers[i].tasks, 0);
+	}
+
+	// Worker 0 is the thread calling vec_pool_run
+	for(uint i = 1;i < pool->size;++i)
+	{
+		thread_arg* arg = (thread_arg*)malloc(sizeof(thread_arg));
+		arg->pool = pool;
+		arg->worker = i;
+		thrd_create(&pool->threads[i], thread_main, arg);
+	}
+
+	return pool;
+}
+
+void vec_pool_free(vec_pool* pool)
+{
+	assert(pool != NULL);
+
+	mtx_lock(&pool->mutex);
+	pool->stop = 1;
+	cnd_broadcast(&pool->start);
+	mtx_unlock(&pool->mutex);
+
+	for(uint i = 1;i < pool->size;++i)
+	{
+		thrd_join(pool->threads[i], NULL);
+	}
+
+	mtx_destroy(&pool->run_mutex);
+	mtx_destroy(&pool->mutex);
+	cnd_destroy(&pool->start);
+	cnd_destroy(&pool->done);
+	free(pool->threads);
+	vec_cache_free(pool->workers);
+	free(pool);
+}
+
+static vec_pool* default_pool = NULL;
+static once_flag default_pool_once = ONCE_FLAG_INIT;
+
+static void create_default_pool()
+{
+	default_pool = vec_pool_create(0, VEC_DEFAULT_GRAIN);
+}
+
+vec_pool* vec_pool_default()
+{
+	call_once(&default_pool_once, create_default_pool);
+
+	return default_pool;
+}
+
+void vec_pool_set_grain(vec_pool* pool, uint grain)
+{
+	assert(pool != NULL);
+	assert(grain > 0);
+
+	mtx_lock(&pool->run_mutex);
+	pool->grain = grain;
+	mtx_unlock(&pool->run_mutex);
+}
+
+// Runs a job. Must be called with run_mutex taken
+static void run_job(vec_pool* pool, uint count, uint align, vec_range_function func, void* ctx)
+{
+	const uint task_size = (pool->grain + align - 1) / align* align;
+	const uint ntasks = (uint)(((unsigned long long)count + task_size - 1) / task_size);
+
+	if(ntasks == 1 || pool->size == 1)
+	{
+		// Not worth waking up the threads
+		func(0, count, 0, ctx);
+		return;
+	}
+
+	for(uint i = 0;i < pool->size;++i)
+	{
+		const uint first = (uint)((unsigned long long)i* ntasks / pool->size);
+		const uint last = (uint)((unsigned long long)(i+1)* ntasks / pool->size);
+		atomic_store(&pool->workers[i].tasks, pack(first, last));
+	}
+
+	mtx_lock(&pool->mutex);
+	pool->func = func;
+	pool->ctx = ctx;
+	pool->count = count;
+	pool->task_size = task_size;
+	pool->running = pool->size - 1;
+	++pool->generation;
+	cnd_broadcast(&pool->start);
+	mtx_unlock(&pool->mutex);
+
+	work(pool, 0);
+
+	mtx_lock(&pool->mutex);
+	while(pool->running > 0)
+	{
+		cnd_wait(&pool->done, &pool->mutex);
+	}
+	mtx_unlock(&pool->mutex);
+}
+
+void vec_pool_run(vec_pool* pool, uint count, uint align, vec_range_function func, void* ctx)
+{
+	assert(pool != NULL);
+	assert(func != NULL);
+	assert(align > 0);
+
+	if(count == 0)
+		return;
+
+	mtx_lock(&pool->run_mutex);
+	run_job(pool, count, align, func, ctx);
+	mtx_unlock(&pool->run_mutex);
+}
+
+// Runs the job only if the pool is not running another one, which also happens when it is called from inside a
+// job of the pool. Returns 0 if the pool was busy
+static int try_run(vec_pool* pool, uint count, uint align, vec_range_function func, void* ctx)
+{
+	if(mtx_trylock(&pool->run_mutex) != thrd_success)
+		return 0;
+
+	run_job(pool, count, align, func, ctx);
+	mtx_unlock(&pool->run_mutex);
+
+	return 1;
+}
+
+// Smallest number of elements that fill a whole number of cache lines
+uint vec_cache_align(uint data_size)
+{
+	uint align = 1;
+
+	while((align* data_size) % VEC_CACHE_LINE != 0 && align < VEC_CACHE_LINE)
+		align <<= 1;
+
+	return align;
+}
+
+void* vec_cache_alloc(uint size)
+{
+	// aligned_alloc needs a multiple of the alignment
+	const size_t bytes = ((size_t)size + VEC_CACHE_LINE - 1) / VEC_CACHE_LINE* VEC_CACHE_LINE;
+
+#ifdef _WIN32
+	return _aligned_malloc(bytes, VEC_CACHE_LINE);
+#else
+	return aligned_alloc(VEC_CACHE_LINE, bytes);
+#endif
+}
+
+void vec_cache_free(void* buffer)
+{
+#ifdef _WIN32
+	_aligned_free(buffer);
+#else
+	free(buffer);
+#endif
+}
+
+typedef struct parallel_job
+{
+	vector* src;
+	vector* dst;
+	void* func;
+	vec_combine_function combine;
+	void* ctx;
+	char* results; // Partial result of each worker, for reductions
+	uint result_size;
+} parallel_job;
+
+static void for_range(uint first, uint last, uint worker, void* ctx)
+{
+	parallel_job* job = ctx;
+	const vec_for_function func = (vec_for_function)job->func;
+	const uint data_size = job->src->data_size;
+	char* buffer = job->src->buffer;
+
+	for(uint i = first;i < last;++i)
+	{
+		func(buffer + i*data_size, i, job->ctx);
+	}
+}
+
+static void map_range(uint first, uint last, uint worker, void* ctx)
+{
+	parallel_job* job = ctx;
+	const vec_map_function func = (vec_map_function)job->func;
+	const uint src_size = job->src->data_size;
+	const uint dst_size = job->dst->data_size;
+	const char* src = job->src->buffer;
+	char* dst = job->dst->buffer;
+
+	for(uint i = first;i < last;++i)
+	{
+		func(src + i*src_size, dst + i*dst_size, job->ctx);
+	}
+}
+
+static void reduce_range(uint first, uint last, uint worker, void* ctx)
+{
+	parallel_job* job = ctx;
+	const vec_reduce_function func = (vec_reduce_function)job->func;
+	const uint data_size = job->src->data_size;
+	const char* buffer = job->src->buffer;
+	void* acc = job->results + worker* job->result_size;
+
+	for(uint i = first;i < last;++i)
+	{
+		func(acc, buffer + i*data_size, job->ctx);
+	}
+}
+
+void vec_parallel_for(vector* vec, vec_for_function func, void* ctx)
+{
+	assert(vec != NULL);
+	assert(func != NULL);
+
+	if(vec->size == 0)
+		return;
+
+	// Elements may be modified, so the vector must not share its buffer
+	vec_at(vec, 0);
+
+	parallel_job job = { vec, NULL, (void*)func, NULL, ctx, NULL, 0 };
+	vec_pool_run(vec_pool_default(), vec->size, vec_cache_align(vec->data_size), for_range, &job);
+}
+
+void vec_parallel_map(vector* src, vector* dst, vec_map_function func, void* ctx)
+{
+	assert(src != NULL);
+	assert(dst != NULL);
+	assert(src != dst);
+	assert(func != NULL);
+
+	vec_resize(dst, src->size);
+
+	if(src->size == 0)
+		return;
+
+	parallel_job job = { src, dst, (void*)func, NULL, ctx, NULL, 0 };
+	vec_pool_run(vec_pool_default(), src->size, vec_cache_align(dst->data_size), map_range, &job);
+}
+
+void vec_parallel_reduce(vector* vec, void* result, uint result_size, vec_reduce_function reduce,
+	vec_combine_function combine, void* ctx)
+{
+	assert(vec != NULL);
+	assert(result != NULL);
+	assert(reduce != NULL);
+	assert(combine != NULL);
+
+	vec_pool* pool = vec_pool_default();
+
+	// Partial results are kept in separate cache lines
+	const uint stride = (result_size + VEC_CACHE_LINE - 1) / VEC_CACHE_LINE* VEC_CACHE_LINE;
+	char* results = (char*)vec_cache_alloc(pool->size* stride);
+
+	for(uint i = 0;i < pool->size;++i)
+	{
+		memcpy(results + i*stride, result, result_size);
+	}
+
+	parallel_job job = { vec, NULL, (void*)reduce, combine, ctx, results, stride };
+	vec_pool_run(pool, vec->size, vec_cache_align(vec->data_size), reduce_range, &job);
+
+	for(uint i = 0;i < pool->size;++i)
+	{
+		combine(result, results + i*stride, ctx);
+	}
+
+	vec_cache_free(results);
+}
+
+// =========================== BULK COPY ===================================
+
+// Copies using non-temporal stores where the destination is 16 bytes aligned
+static void stream_copy(char* dst, const char* src, uint bytes)
+{
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	const uint head = (uint)((16 - ((uintptr_t)dst & 15)) & 15);
+
+	if(bytes < head + 64)
+	{
+		memcpy(dst, src, bytes);
+		return;
+	}
+
+	memcpy(dst, src, head);
+	dst += head;
+	src += head;
+	bytes -= head;
+
+	for(;bytes >= 64;bytes -= 64, dst += 64, src += 64)
+	{
+		const __m128i a = _mm_loadu_si128((const __m128i*)src);
+		const __m128i b = _mm_loadu_si128((const __m128i*)(src + 16));
+		const __m128i c = _mm_loadu_si128((const __m128i*)(src + 32));
+		const __m128i d = _mm_loadu_si128((const __m128i*)(src + 48));
+		_mm_stream_si128((__m128i*)dst, a);
+		_mm_stream_si128((__m128i*)(dst + 16), b);
+		_mm_stream_si128((__m128i*)(dst + 32), c);
+		_mm_stream_si128((__m128i*)(dst + 48), d);
+	}
+
+	memcpy(dst, src, bytes);
+	// Non-temporal stores are weakly ordered
+	_mm_sfence();
+#else
+	memcpy(dst, src, bytes);
+#endif
+}
+
+typedef struct copy_job
+{
+	char* dst;
+	const char* src;
+	uint bytes;
+	uint pattern_size; // For fills, size of the pattern at the start of dst. 0 for copies
+	int streaming;
+} copy_job;
+
+// Ranges are in cache lines of the destination
+static void copy_range(uint first, uint last, uint worker, void* ctx)
+{
+	copy_job* job = ctx;
+	const uint begin = first* VEC_CACHE_LINE;
+	const uint end = last* VEC_CACHE_LINE < job->bytes ? last* VEC_CACHE_LINE : job->bytes;
+
+	if(job->streaming)
+		stream_copy(job->dst + begin, job->src + begin, end - begin);
+	else
+		memcpy(job->dst + begin, job->src + begin, end - begin);
+}
+
+static void fill_range(uint first, uint last, uint worker, void* ctx)
+{
+	copy_job* job = ctx;
+	uint begin = first* VEC_CACHE_LINE;
+	const uint end = last* VEC_CACHE_LINE < job->bytes ? last* VEC_CACHE_LINE : job->bytes;
+
+	// The pattern is already in [0, pattern_size)
+	if(begin < job->pattern_size)
+		begin = job->pattern_size;
+
+	while(begin < end)
+	{
+		// Offset inside the pattern of the first byte to write
+		const uint offset = begin % job->pattern_size;
+		uint n = job->pattern_size - offset;
+
+		if(n > end - begin)
+			n = end - begin;
+
+		memcpy(job->dst + begin, job->dst + offset, n);
+		begin += n;
+	}
+}
+
+void vec_bulk_copy(void* dst, const void* src, uint bytes, int streaming)
+{
+	assert(dst != NULL || bytes == 0);
+	assert(src != NULL || bytes == 0);
+
+	if(bytes < VEC_PARALLEL_COPY_MIN)
+	{
+		memcpy(dst, src, bytes);
+		return;
+	}
+
+	copy_job job = { dst, src, bytes, 0, streaming };
+	const uint lines = (bytes + VEC_CACHE_LINE - 1) / VEC_CACHE_LINE;
+
+	// Copies do not wait for the pool, and do not deadlock when called from inside one of its jobs
+	if(!try_run(vec_pool_default(), lines, 1, copy_range, &job))
+		copy_range(0, lines, 0, &job);
+}
+
+void vec_bulk_fill(void* dst, uint pattern_size, uint bytes)
+{
+	assert(dst != NULL || bytes == 0);
+	assert(pattern_size > 0);
+	assert(bytes % pattern_size == 0);
+
+	char* buffer = dst;
+	uint filled = pattern_size < bytes ? pattern_size : bytes;
+
+	// Each copy doubles the filled part, until the rest is big enough to be worth splitting
+	while(filled < bytes && (filled < VEC_CACHE_LINE* 64 || bytes < VEC_PARALLEL_COPY_MIN))
+	{
+		const uint n = filled < bytes - filled ? filled : bytes - filled;
+
+		memcpy(buffer + filled, buffer, n);
+		filled += n;
+	}
+
+	if(filled < bytes)
+	{
+		copy_job job = { dst, NULL, bytes, filled, 0 };
+		const uint lines = (bytes + VEC_CACHE_LINE - 1) / VEC_CACHE_LINE;
+
+		if(!try_run(vec_pool_default(), lines, 1, fill_range, &job))
+			fill_range(0, lines, 0, &job);
+	}
+}
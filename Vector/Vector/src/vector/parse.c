@@ -0,0 +1,382 @@
+#include "vector/parse.h"
+#include "vector/parallel.h"
+#include "vector/sharded.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+
+// Values parsed before appending them to the vector
+#define BATCH_SIZE 256
+// Bytes used to estimate the number of values of a text
+#define SAMPLE_SIZE (64U << 10)
+
+typedef enum number_type
+{
+	TYPE_FLOAT,
+	TYPE_DOUBLE,
+	TYPE_INT,
+	TYPE_ULONG
+} number_type;
+
+static int is_separator(char c)
+{
+	return c == ' ' || c == '\n' || c == ',' || c == '\r' || c == '\t' || c == ';';
+}
+
+static const double powers10[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Parses a decimal number with Clinger's fast path: when the mantissa and the power of 10 are both exact
+// in the floating point type, one multiplication or division gives the correctly rounded result.
+// Returns 0 if the token is not a plain decimal number or it is out of the fast path
+static int parse_fast_float(const char* p, const char* end, int is_float, double* value)
+{
+	const int negative = *p == '-';
+	uint64_t mantissa = 0;
+	int exponent = 0;
+	int digits = 0;
+
+	if(*p == '-' || *p == '+')
+		++p;
+
+	for(;p < end && *p >= '0' && *p <= '9';++p, ++digits)
+	{
+		mantissa = mantissa* 10 + (*p - '0');
+	}
+
+	if(p < end && *p == '.')
+	{
+		for(++p;p < end && *p >= '0' && *p <= '9';++p, ++digits)
+		{
+			mantissa = mantissa* 10 + (*p - '0');
+			--exponent;
+		}
+	}
+
+	// Leading zeros do not matter, so digits only limits overflows
+	if(digits == 0 || digits > 19)
+		return 0;
+
+	if(p < end && (*p == 'e' || *p == 'E'))
+	{
+		++p;
+
+		int exponent_negative = 0;
+		int e = 0;
+
+		if(p < end && (*p == '-' || *p == '+'))
+		{
+			exponent_negative = *p == '-';
+			++p;
+		}
+
+		if(p == end || *p < '0' || *p > '9')
+			return 0;
+
+		for(;p < end && *p >= '0' && *p <= '9';++p)
+		{
+			if(e < 10000)
+				e = e* 10 + (*p - '0');
+		}
+
+		exponent += exponent_negative ? -e : e;
+	}
+
+	if(p != end)
+		return 0;
+
+	// Exact mantissas and powers of 10: 2^24 and 10^10 for floats, 2^53 and 10^22 for doubles
+	const uint64_t max_mantissa = is_float ? (1ULL << 24) : (1ULL << 53);
+	const int max_exponent = is_float ? 10 : 22;
+
+	if(mantissa > max_mantissa || exponent < -max_exponent || exponent > max_exponent)
+		return 0;
+
+	if(is_float)
+	{
+		const float f = exponent < 0 ? (float)mantissa / (float)powers10[-exponent] : (float)mantissa* (float)powers10[exponent];
+		*value = negative ? -f : f;
+	}
+	else
+	{
+		const double d = exponent < 0 ? (double)mantissa / powers10[-exponent] : (double)mantissa* powers10[exponent];
+		*value = negative ? -d : d;
+	}
+
+	return 1;
+}
+
+// Parses the token with strtod/strtof. Returns 0 if the whole token is not a number
+static int parse_slow_float(const char* p, const char* end, int is_float, double* value)
+{
+	char local[64];
+	const size_t length = end - p;
+	char* token = length < sizeof(local) ? local : (char*)malloc(length + 1);
+	char* token_end;
+
+	memcpy(token, p, length);
+	token[length] = '\0';
+
+	if(is_float)
+		*value = strtof(token, &token_end);
+	else
+		*value = strtod(token, &token_end);
+
+	const int valid = token_end == token + length;
+
+	if(token != local)
+		free(token);
+
+	return valid;
+}
+
+static int parse_integer(const char* p, const char* end, number_type type, void* value)
+{
+	const int negative = *p == '-';
+	unsigned long long n = 0;
+	const unsigned long long max = type == TYPE_INT ? (negative ? -(long long)INT_MIN : INT_MAX) : ULONG_MAX;
+
+	if(*p == '-' || *p == '+')
+		++p;
+
+	if(p == end || (negative && type == TYPE_ULONG))
+		return 0;
+
+	for(;p < end;++p)
+	{
+		if(*p < '0' || *p > '9')
+			return 0;
+
+		const unsigned digit = *p - '0';
+
+		if(n > (max - digit) / 10)
+			return 0;
+
+		n = n* 10 + digit;
+	}
+
+	if(type == TYPE_INT)
+		*(int*)value = negative ? (int)(-(long long)n) : (int)n;
+	else
+		*(unsigned long*)value = (unsigned long)n;
+
+	return 1;
+}
+
+// Parses the token [p, end) into value. Returns 0 if it is not a valid number
+static int parse_token(const char* p, const char* end, number_type type, void* value)
+{
+	double d;
+
+	switch(type)
+	{
+	case TYPE_INT:
+	case TYPE_ULONG:
+		return parse_integer(p, end, type, value);
+	case TYPE_FLOAT:
+		if(!parse_fast_float(p, end, 1, &d) && !parse_slow_float(p, end, 1, &d))
+			return 0;
+
+		*(float*)value = (float)d;
+		return 1;
+	default:
+		if(!parse_fast_float(p, end, 0, &d) && !parse_slow_float(p, end, 0, &d))
+			return 0;
+
+		*(double*)value = d;
+		return 1;
+	}
+}
+
+static void append_batch(vector* vec, const void* batch, uint count)
+{
+	const uint size = vec->size;
+
+	vec_resize(vec, size + count);
+	memcpy((char*)vec->buffer + size* vec->data_size, batch, count* vec->data_size);
+}
+
+// Parses the tokens starting in [first, last) of text, which may end after last. Returns the position of the
+// first invalid token, or VEC_NPOS
+static uint parse_range(vector* vec, const char* text, uint length, uint first, uint last, number_type type)
+{
+	unsigned long long batch[BATCH_SIZE];
+	const uint data_size = vec->data_size;
+	uint count = 0;
+	uint pos = first;
+
+	// A token that starts before first belongs to the previous range
+	if(pos > 0 && !is_separator(text[pos-1]))
+	{
+		while(pos < length && !is_separator(text[pos]))
+			++pos;
+	}
+
+	for(;;)
+	{
+		while(pos < last && is_separator(text[pos]))
+			++pos;
+
+		if(pos >= last)
+			break;
+
+		uint end = pos;
+		while(end < length && !is_separator(text[end]))
+			++end;
+
+		if(!parse_token(text + pos, text + end, type, (char*)batch + count* data_size))
+		{
+			append_batch(vec, batch, count);
+			return pos;
+		}
+
+		if(++count == BATCH_SIZE)
+		{
+			append_batch(vec, batch, count);
+			count = 0;
+		}
+
+		pos = end;
+	}
+
+	append_batch(vec, batch, count);
+
+	return VEC_NPOS;
+}
+
+// Estimates the number of values of text from the number of tokens of its first bytes
+static uint estimate_count(const char* text, uint length)
+{
+	const uint sample = length < SAMPLE_SIZE ? length : SAMPLE_SIZE;
+	uint tokens = 0;
+
+	for(uint i = 0;i < sample;++i)
+	{
+		if(!is_separator(text[i]) && (i == 0 || is_separator(text[i-1])))
+			++tokens;
+	}
+
+	if(sample == length)
+		return tokens;
+
+	// A bit more, so that the vector is not reallocated for an unlucky sample
+	return (uint)((unsigned long long)tokens* length / sample* 9 / 8);
+}
+
+typedef struct parse_job
+{
+	vec_sharded* shards; // One shard per chunk
+	const char* text;
+	uint length;
+	number_type type;
+	uint* errors; // Position of the first invalid token of each chunk
+} parse_job;
+
+// Ranges are in bytes and hold whole chunks
+static void parse_chunks(uint first, uint last, uint worker, void* ctx)
+{
+	parse_job* job = ctx;
+
+	for(uint chunk = first / VEC_PARSE_CHUNK;chunk* VEC_PARSE_CHUNK < last;++chunk)
+	{
+		const uint begin = chunk* VEC_PARSE_CHUNK;
+		const uint end = job->length - begin < VEC_PARSE_CHUNK ? job->length : begin + VEC_PARSE_CHUNK;
+		vector* vec = vec_shard_get(job->shards, chunk);
+
+		vec_reserve(vec, estimate_count(job->text + begin, end - begin));
+		job->errors[chunk] = parse_range(vec, job->text, job->length, begin, end, job->type);
+	}
+}
+
+static uint parse(vector* vec, const char* text, uint length, int parallel, number_type type)
+{
+	assert(vec != NULL);
+	assert(text != NULL || length == 0);
+
+	if(!parallel || length < 2* VEC_PARSE_CHUNK)
+	{
+		vec_reserve(vec, vec->size + estimate_count(text, length));
+
+		const uint error = parse_range(vec, text, length, 0, length, type);
+
+		return error == VEC_NPOS ? length : error;
+	}
+
+	const uint chunks = (length + VEC_PARSE_CHUNK - 1) / VEC_PARSE_CHUNK;
+	vec_sharded* shards = vec_shard_create(vec->data_size, chunks);
+	uint* errors = (uint*)malloc(chunks* sizeof(uint));
+	parse_job job = { shards, text, length, type, errors };
+	uint result = length;
+
+	vec_pool_run(vec_pool_default(), length, VEC_PARSE_CHUNK, parse_chunks, &job);
+
+	// Values after the first invalid token are discarded
+	for(uint i = 0;i < chunks;++i)
+	{
+		if(errors[i] != VEC_NPOS)
+		{
+			result = errors[i];
+
+			for(uint j = i + 1;j < chunks;++j)
+			{
+				vec_clear(vec_shard_get(shards, j));
+			}
+
+			break;
+		}
+	}
+
+	if(vec->size == 0)
+	{
+		vec_shard_merge(shards, vec, 1);
+	}
+	else
+	{
+		vector merged;
+		vec_init(&merged, vec->data_size);
+		vec_shard_merge(shards, &merged, 1);
+
+		const uint size = vec->size;
+		vec_resize(vec, size + merged.size);
+		vec_cpy(&merged, vec, 0, merged.size, size);
+		vec_destroy(&merged);
+	}
+
+	free(errors);
+	vec_shard_free(shards);
+
+	return result;
+}
+
+uint vecf_parse(vector* vec, const char* text, uint length, int parallel)
+{
+	assert(vec->data_size == sizeof(float));
+
+	return parse(vec, text, length, parallel, TYPE_FLOAT);
+}
+
+uint vecd_parse(vector* vec, const char* text, uint length, int parallel)
+{
+	assert(vec->data_size == sizeof(double));
+
+	return parse(vec, text, length, parallel, TYPE_DOUBLE);
+}
+
+uint veci_parse(vector* vec, const char* text, uint length, int parallel)
+{
+	assert(vec->data_size == sizeof(int));
+
+	return parse(vec, text, length, parallel, TYPE_INT);
+}
+
+uint vecul_parse(vector* vec, const char* text, uint length, int parallel)
+{
+	assert(vec->data_size == sizeof(unsigned long));
+
+	return parse(vec, text, length, parallel, TYPE_ULONG);
+}
@@ -0,0 +1,388 @@
+#include "vector/pvector.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+
+#define MASK (PVEC_WIDTH - 1)
+
+static pvec_node** children(pvec_node* node)
+{
+	return (pvec_node**)(node+1);
+}
+
+static char* elements(pvec_node* node)
+{
+	return (char*)(node+1);
+}
+
+static uint node_bytes(pvector* pv, uint leaf)
+{
+	return sizeof(pvec_node) + PVEC_WIDTH* (leaf ? pv->data_size : sizeof(pvec_node*));
+}
+
+static pvec_node* new_node(pvector* pv, uint leaf)
+{
+	pvec_node* node = (pvec_node*)malloc(node_bytes(pv, leaf));
+	node->refs = 1;
+	node->leaf = leaf;
+
+	if(!leaf)
+	{
+		memset(children(node), 0, PVEC_WIDTH* sizeof(pvec_node*));
+	}
+
+	return node;
+}
+
+static void release(pvec_node* node)
+{
+	if(node == NULL || --node->refs > 0)
+		return;
+
+	if(!node->leaf)
+	{
+		for(uint i = 0;i < PVEC_WIDTH;++i)
+		{
+			release(children(node)[i]);
+		}
+	}
+
+	free(node);
+}
+
+// Returns the node if it is only referenced once, or a copy which replaces that reference otherwise
+static pvec_node* editable(pvector* pv, pvec_node* node)
+{
+	if(node->refs == 1)
+		return node;
+
+	pvec_node* copy = (pvec_node*)malloc(node_bytes(pv, node->leaf));
+	memcpy(copy, node, node_bytes(pv, node->leaf));
+	copy->refs = 1;
+
+	if(!node->leaf)
+	{
+		for(uint i = 0;i < PVEC_WIDTH;++i)
+		{
+			if(children(copy)[i] != NULL)
+				++children(copy)[i]->refs;
+		}
+	}
+
+	--node->refs;
+
+	return copy;
+}
+
+// Position of the first element of the tail
+static uint tail_offset(pvector* pv)
+{
+	return pv->size < PVEC_WIDTH ? 0 : ((pv->size-1) >> PVEC_BITS) << PVEC_BITS;
+}
+
+// Returns the leaf holding the element at pos
+static pvec_node* leaf_for(pvector* pv, uint pos)
+{
+	if(pos >= tail_offset(pv))
+		return pv->tail;
+
+	pvec_node* node = pv->root;
+
+	for(uint level = pv->shift;level > 0;level -= PVEC_BITS)
+	{
+		node = children(node)[(pos >> level) & MASK];
+	}
+
+	return node;
+}
+
+// Returns a chain of branches from level down to the leaf
+static pvec_node* new_path(pvector* pv, uint level, pvec_node* leaf)
+{
+	if(level == 0)
+		return leaf;
+
+	pvec_node* node = new_node(pv, 0);
+	children(node)[0] = new_path(pv, level-PVEC_BITS, leaf);
+
+	return node;
+}
+
+// Inserts the full tail leaf in the trie, below the editable node parent at level
+static pvec_node* push_tail(pvector* pv, uint level, pvec_node* parent, pvec_node* leaf)
+{
+	const uint i = ((pv->size-1) >> level) & MASK;
+	pvec_node* child = children(parent)[i];
+
+	if(level == PVEC_BITS)
+	{
+		children(parent)[i] = leaf;
+	}
+	else if(child != NULL)
+	{
+		children(parent)[i] = push_tail(pv, level-PVEC_BITS, editable(pv, child), leaf);
+	}
+	else
+	{
+		children(parent)[i] = new_path(pv, level-PVEC_BITS, leaf);
+	}
+
+	return parent;
+}
+
+// Returns a new version sharing all the nodes of pv
+static pvector* clone(pvector* pv)
+{
+	pvector* copy = (pvector*)malloc(sizeof(pvector));
+	*copy = *pv;
+
+	if(copy->root != NULL) ++copy->root->refs;
+	if(copy->tail != NULL) ++copy->tail->refs;
+
+	return copy;
+}
+
+// Adds element at the end of pv, copying the nodes shared with other versions
+static void push_back(pvector* pv, const void* element)
+{
+	const uint pos = pv->size - tail_offset(pv);
+
+	if(pv->tail == NULL)
+	{
+		pv->tail = new_node(pv, 1);
+	}
+	else if(pos < PVEC_WIDTH)
+	{
+		pv->tail = editable(pv, pv->tail);
+	}
+	else
+	{
+		// The tail is full, move it to the trie. The version reference of the tail becomes the parent one
+		pvec_node* leaf = pv->tail;
+
+		if(pv->root == NULL)
+		{
+			pv->root = new_node(pv, 0);
+			pv->shift = PVEC_BITS;
+		}
+
+		if((pv->size >> PVEC_BITS) > (1U << pv->shift))
+		{
+			// The trie is full, add a level
+			pvec_node* root = new_node(pv, 0);
+			children(root)[0] = pv->root;
+			children(root)[1] = new_path(pv, pv->shift, leaf);
+			pv->root = root;
+			pv->shift += PVEC_BITS;
+		}
+		else
+		{
+			pv->root = push_tail(pv, pv->shift, editable(pv, pv->root), leaf);
+		}
+
+		pv->tail = new_node(pv, 1);
+	}
+
+	memcpy(elements(pv->tail) + (pv->size & MASK)* pv->data_size, element, pv->data_size);
+	++pv->size;
+}
+
+// Sets the element at pos of pv, copying the nodes shared with other versions
+static void replace(pvector* pv, uint pos, const void* element)
+{
+	pvec_node* node;
+
+	if(pos >= tail_offset(pv))
+	{
+		pv->tail = editable(pv, pv->tail);
+		node = pv->tail;
+	}
+	else
+	{
+		pv->root = editable(pv, pv->root);
+		node = pv->root;
+
+		for(uint level = pv->shift;level > 0;level -= PVEC_BITS)
+		{
+			pvec_node** child = &children(node)[(pos >> level) & MASK];
+			*child = editable(pv, *child);
+			node = *child;
+		}
+	}
+
+	memcpy(elements(node) + (pos & MASK)* pv->data_size, element, pv->data_size);
+}
+
+pvector* pvec_create(uint data_size)
+{
+	pvector* pv = (pvector*)malloc(sizeof(pvector));
+
+	pv->root = NULL;
+	pv->tail = NULL;
+	pv->size = 0;
+	pv->shift = 0;
+	pv->data_size = data_size;
+	pv->transient = 0;
+	pv->equal_func = equal_func;
+
+	return pv;
+}
+
+void pvec_free(pvector* pv)
+{
+	assert(pv != NULL);
+
+	release(pv->root);
+	release(pv->tail);
+	free(pv);
+}
+
+uint pvec_size(pvector* pv)
+{
+	assert(pv != NULL);
+
+	return pv->size;
+}
+
+const void* pvec_at(pvector* pv, uint pos)
+{
+	assert(pv != NULL);
+	assert(pos < pv->size);
+
+	return elements(leaf_for(pv, pos)) + (pos & MASK)* pv->data_size;
+}
+
+void* pvec_at_cp(pvector* pv, uint pos, void* element)
+{
+	assert(element != NULL);
+
+	return memcpy(element, pvec_at(pv, pos), pv->data_size);
+}
+
+uint pvec_find(pvector* pv, const void* element, uint offset)
+{
+	assert(pv != NULL);
+
+	if(element == NULL)
+		return VEC_NPOS;
+
+	const uint data_size = pv->data_size;
+	const equal_function equal_func = pv->equal_func;
+
+	// Search leaf by leaf, instead of walking the trie for every element
+	for(uint first = offset & ~MASK;first < pv->size;first += PVEC_WIDTH)
+	{
+		const char* leaf = elements(leaf_for(pv, first));
+		const uint count = pv->size - first < PVEC_WIDTH ? pv->size - first : PVEC_WIDTH;
+
+		for(uint i = first < offset ? offset - first : 0;i < count;++i)
+		{
+			if(equal_func((void*)(leaf + i*data_size), (void*)element, data_size))
+			{
+				return first + i;
+			}
+		}
+	}
+
+	return VEC_NPOS;
+}
+
+pvector* pvec_push_back(pvector* pv, const void* element)
+{
+	assert(pv != NULL);
+	assert(element != NULL);
+
+	pvector* next = clone(pv);
+	next->transient = 0;
+	push_back(next, element);
+
+	return next;
+}
+
+pvector* pvec_replace(pvector* pv, uint pos, const void* element)
+{
+	assert(pv != NULL);
+	assert(pos < pv->size);
+	assert(element != NULL);
+
+	pvector* next = clone(pv);
+	next->transient = 0;
+	replace(next, pos, element);
+
+	return next;
+}
+
+pvector* pvec_transient(pvector* pv)
+{
+	assert(pv != NULL);
+
+	pvector* copy = clone(pv);
+	copy->transient = 1;
+
+	return copy;
+}
+
+void pvec_tpush_back(pvector* pv, const void* element)
+{
+	assert(pv != NULL);
+	assert(pv->transient);
+	assert(element != NULL);
+
+	push_back(pv, element);
+}
+
+void pvec_treplace(pvector* pv, uint pos, const void* element)
+{
+	assert(pv != NULL);
+	assert(pv->transient);
+	assert(pos < pv->size);
+	assert(element != NULL);
+
+	replace(pv, pos, element);
+}
+
+pvector* pvec_persistent(pvector* pv)
+{
+	assert(pv != NULL);
+
+	pv->transient = 0;
+
+	return pv;
+}
+
+pvector* pvec_from_vec(vector* vec)
+{
+	assert(vec != NULL);
+
+	pvector* pv = pvec_create(vec->data_size);
+	pv->equal_func = vec->equal_func;
+
+	const char* buffer = vec->buffer;
+
+	// Nodes are owned by pv alone, so they are filled in place
+	for(uint i = 0;i < vec->size;++i)
+	{
+		push_back(pv, buffer + i* vec->data_size);
+	}
+
+	return pv;
+}
+
+vector* pvec_to_vec(pvector* pv, vector* vec)
+{
+	assert(pv != NULL);
+	assert(vec != NULL);
+	assert(vec->data_size == pv->data_size);
+
+	vec_resize(vec, pv->size);
+
+	char* buffer = vec->buffer;
+
+	for(uint first = 0;first < pv->size;first += PVEC_WIDTH)
+	{
+		const uint count = pv->size - first < PVEC_WIDTH ? pv->size - first : PVEC_WIDTH;
+		memcpy(buffer + first* pv->data_size, elements(leaf_for(pv, first)), count* pv->data_size);
+	}
+
+	return vec;
+}
@@ -0,0 +1,340 @@
+#include "vector/queue.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+
+// Offset of the element inside an mpmc_queue slot, keeping 8 bytes alignment
+#define SLOT_HEADER 8
+
+static uint round_pow2(uint n)
+{
+	uint capacity = 1;
+
+	while(capacity < n)
+		capacity <<= 1;
+
+	return capacity;
+}
+
+static uint min_uint(uint a, uint b)
+{
+	return a < b ? a : b;
+}
+
+// =========================== SPSC QUEUE ===================================
+
+spsc_queue* spsc_create(uint data_size, uint capacity)
+{
+	spsc_queue* q = (spsc_queue*)malloc(sizeof(spsc_queue));
+
+	spsc_init(q, data_size, capacity);
+
+	return q;
+}
+
+void spsc_free(spsc_queue* q)
+{
+	assert(q != NULL);
+
+	spsc_destroy(q);
+	free(q);
+}
+
+void spsc_init(spsc_queue* q, uint data_size, uint capacity)
+{
+	spsc_init_alloc(q, data_size, capacity, alloc_buffer, free_buffer);
+}
+
+void spsc_init_alloc(spsc_queue* q, uint data_size, uint capacity, alloc_function alloc_func, free_function free_func)
+{
+	assert(q != NULL);
+	assert(capacity > 0);
+	assert(alloc_func != NULL && free_func != NULL);
+
+	capacity = round_pow2(capacity);
+
+	q->data_size = data_size;
+	q->mask = capacity - 1;
+	q->alloc_func = alloc_func;
+	q->free_func = free_func;
+	q->buffer = q->alloc_func(data_size, capacity);
+	atomic_init(&q->head, 0);
+	atomic_init(&q->tail, 0);
+	q->cached_head = 0;
+	q->cached_tail = 0;
+}
+
+void spsc_destroy(spsc_queue* q)
+{
+	assert(q != NULL);
+
+	q->free_func(q->buffer);
+	q->buffer = NULL;
+}
+
+// Copies count elements starting at ring position pos, wrapping around the end of the buffer
+static void ring_write(spsc_queue* q, uint pos, const char* elements, uint count)
+{
+	const uint first = pos & q->mask;
+	const uint n = min_uint(count, q->mask + 1 - first);
+
+	memcpy(q->buffer + first* q->data_size, elements, n* q->data_size);
+	memcpy(q->buffer, elements + n* q->data_size, (count-n)* q->data_size);
+}
+
+static void ring_read(spsc_queue* q, uint pos, char* elements, uint count)
+{
+	const uint first = pos & q->mask;
+	const uint n = min_uint(count, q->mask + 1 - first);
+
+	memcpy(elements, q->buffer + first* q->data_size, n* q->data_size);
+	memcpy(elements + n* q->data_size, q->buffer, (count-n)* q->data_size);
+}
+
+int spsc_enqueue(spsc_queue* q, const void* element)
+{
+	return spsc_enqueue_batch(q, element, 1) == 1;
+}
+
+uint spsc_enqueue_batch(spsc_queue* q, const void* elements, uint count)
+{
+	assert(q != NULL);
+	assert(elements != NULL || count == 0);
+
+	const uint tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+	const uint capacity = q->mask + 1;
+
+	if(capacity - (tail - q->cached_head) < count)
+	{
+		q->cached_head = atomic_load_explicit(&q->head, memory_order_acquire);
+	}
+
+	count = min_uint(count, capacity - (tail - q->cached_head));
+
+	if(count == 0)
+		return 0;
+
+	ring_write(q, tail, elements, count);
+	atomic_store_explicit(&q->tail, tail + count, memory_order_release);
+
+	return count;
+}
+
+int spsc_dequeue(spsc_queue* q, void* element)
+{
+	return spsc_dequeue_batch(q, element, 1) == 1;
+}
+
+uint spsc_dequeue_batch(spsc_queue* q, void* elements, uint count)
+{
+	assert(q != NULL);
+	assert(elements != NULL || count == 0);
+
+	const uint head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+	if(q->cached_tail - head < count)
+	{
+		q->cached_tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+	}
+
+	count = min_uint(count, q->cached_tail - head);
+
+	if(count == 0)
+		return 0;
+
+	ring_read(q, head, elements, count);
+	atomic_store_explicit(&q->head, head + count, memory_order_release);
+
+	return count;
+}
+
+uint spsc_size(spsc_queue* q)
+{
+	assert(q != NULL);
+
+	return atomic_load_explicit(&q->tail, memory_order_acquire) - atomic_load_explicit(&q->head, memory_order_acquire);
+}
+
+// =========================== MPMC QUEUE ===================================
+
+static atomic_uint* slot_seq(mpmc_queue* q, uint pos)
+{
+	return (atomic_uint*)(q->buffer + (pos & q->mask)* q->slot_size);
+}
+
+static char* slot_data(mpmc_queue* q, uint pos)
+{
+	return q->buffer + (pos & q->mask)* q->slot_size + SLOT_HEADER;
+}
+
+mpmc_queue* mpmc_create(uint data_size, uint capacity)
+{
+	mpmc_queue* q = (mpmc_queue*)malloc(sizeof(mpmc_queue));
+
+	mpmc_init(q, data_size, capacity);
+
+	return q;
+}
+
+void mpmc_free(mpmc_queue* q)
+{
+	assert(q != NULL);
+
+	mpmc_destroy(q);
+	free(q);
+}
+
+void mpmc_init(mpmc_queue* q, uint data_size, uint capacity)
+{
+	mpmc_init_alloc(q, data_size, capacity, alloc_buffer, free_buffer);
+}
+
+void mpmc_init_alloc(mpmc_queue* q, uint data_size, uint capacity, alloc_function alloc_func, free_function free_func)
+{
+	assert(q != NULL);
+	assert(capacity > 0);
+	assert(alloc_func != NULL && free_func != NULL);
+
+	capacity = round_pow2(capacity);
+
+	q->data_size = data_size;
+	q->slot_size = (SLOT_HEADER + data_size + 7) & ~7U;
+	q->mask = capacity - 1;
+	q->alloc_func = alloc_func;
+	q->free_func = free_func;
+	q->buffer = q->alloc_func(q->slot_size, capacity);
+
+	// Slot i is ready to be written at position i
+	for(uint i = 0;i < capacity;++i)
+	{
+		atomic_init(slot_seq(q, i), i);
+	}
+
+	atomic_init(&q->enqueue_pos, 0);
+	atomic_init(&q->dequeue_pos, 0);
+}
+
+void mpmc_destroy(mpmc_queue* q)
+{
+	assert(q != NULL);
+
+	q->free_func(q->buffer);
+	q->buffer = NULL;
+}
+
+int mpmc_enqueue(mpmc_queue* q, const void* element)
+{
+	return mpmc_enqueue_batch(q, element, 1) == 1;
+}
+
+uint mpmc_enqueue_batch(mpmc_queue* q, const void* elements, uint count)
+{
+	assert(q != NULL);
+	assert(elements != NULL || count == 0);
+
+	uint pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+	uint n;
+
+	for(;;)
+	{
+		// Count the consecutive slots ready to be written in this lap
+		n = 0;
+		while(n < count && n <= q->mask)
+		{
+			const uint seq = atomic_load_explicit(slot_seq(q, pos+n), memory_order_acquire);
+
+			if(seq != pos+n)
+				break;
+
+			++n;
+		}
+
+		if(n == 0)
+		{
+			const int diff = (int)(atomic_load_explicit(slot_seq(q, pos), memory_order_acquire) - pos);
+
+			// The slot has not been read in the previous lap yet
+			if(diff < 0)
+				return 0;
+
+			// Another producer took the slot
+			pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+			continue;
+		}
+
+		if(atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos+n,
+			memory_order_relaxed, memory_order_relaxed))
+		{
+			break;
+		}
+	}
+
+	const char* src = elements;
+
+	for(uint i = 0;i < n;++i)
+	{
+		memcpy(slot_data(q, pos+i), src + i* q->data_size, q->data_size);
+		atomic_store_explicit(slot_seq(q, pos+i), pos+i+1, memory_order_release);
+	}
+
+	return n;
+}
+
+int mpmc_dequeue(mpmc_queue* q, void* element)
+{
+	return mpmc_dequeue_batch(q, element, 1) == 1;
+}
+
+uint mpmc_dequeue_batch(mpmc_queue* q, void* elements, uint count)
+{
+	assert(q != NULL);
+	assert(elements != NULL || count == 0);
+
+	uint pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+	uint n;
+
+	for(;;)
+	{
+		// Count the consecutive slots written in this lap
+		n = 0;
+		while(n < count && n <= q->mask)
+		{
+			const uint seq = atomic_load_explicit(slot_seq(q, pos+n), memory_order_acquire);
+
+			if(seq != pos+n+1)
+				break;
+
+			++n;
+		}
+
+		if(n == 0)
+		{
+			const int diff = (int)(atomic_load_explicit(slot_seq(q, pos), memory_order_acquire) - (pos+1));
+
+			// The slot has not been written yet
+			if(diff < 0)
+				return 0;
+
+			// Another consumer took the slot
+			pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+			continue;
+		}
+
+		if(atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos, pos+n,
+			memory_order_relaxed, memory_order_relaxed))
+		{
+			break;
+		}
+	}
+
+	char* dst = elements;
+
+	for(uint i = 0;i < n;++i)
+	{
+		memcpy(dst + i* q->data_size, slot_data(q, pos+i), q->data_size);
+		// Ready to be written in the next lap
+		atomic_store_explicit(slot_seq(q, pos+i), pos+i+q->mask+1, memory_order_release);
+	}
+
+	return n;
+}
@@ -0,0 +1,403 @@
+#include "vector/registry.h"
+
+#ifdef VEC_REGISTRY
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <threads.h>
+
+// Totals of the live vectors of a tag
+typedef struct tag_totals
+{
+	const char* tag;
+	uint vectors;
+	unsigned long long size; // Bytes of the elements
+	unsigned long long capacity; // Bytes of the buffers
+	unsigned long long budget; // 0 for no budget
+} tag_totals;
+
+// Copy of a vector taken for the report, so that it is written without holding the lock
+typedef struct vector_info
+{
+	const void* address;
+	const char* tag;
+	uint data_size;
+	uint size;
+	uint capacity;
+} vector_info;
+
+typedef struct tag_budget
+{
+	const char* tag;
+	unsigned long long bytes;
+} tag_budget;
+
+// Circular list of the live vectors: only the links of head are used
+static vector head;
+static uint live_count;
+static tag_budget* budgets;
+static uint budget_count;
+static mtx_t registry_mutex;
+static once_flag registry_once = ONCE_FLAG_INIT;
+
+static void init_registry()
+{
+	mtx_init(&registry_mutex, mtx_plain);
+	head.registry_prev = &head;
+	head.registry_next = &head;
+}
+
+static const char* tag_name(const char* tag)
+{
+	return tag != NULL ? tag : "untagged";
+}
+
+static unsigned long long find_budget(const char* tag)
+{
+	for(uint i = 0;i < budget_count;++i)
+	{
+		if(strcmp(budgets[i].tag, tag) == 0)
+			return budgets[i].bytes;
+	}
+
+	return 0;
+}
+
+// Returns the totals of every tag, in order of appearance. Must be called with the lock taken
+static tag_totals* aggregate(uint* count)
+{
+	tag_totals* totals = NULL;
+	uint capacity = 0;
+
+	*count = 0;
+
+	for(vector* vec = head.registry_next;vec != &head;vec = vec->registry_next)
+	{
+		const char* tag = tag_name(vec->tag);
+		uint i = 0;
+
+		while(i < *count && totals[i].tag != tag && strcmp(totals[i].tag, tag) != 0)
+			++i;
+
+		if(i == *count)
+		{
+			if(*count == capacity)
+			{
+				capacity = capacity == 0 ? 8 : capacity* 2;
+				totals = (tag_totals*)realloc(totals, capacity* sizeof(tag_totals));
+			}
+
+			totals[i].tag = tag;
+			totals[i].vectors = 0;
+			totals[i].size = 0;
+			totals[i].capacity = 0;
+			totals[i].budget = find_budget(tag);
+			++*count;
+		}
+
+		++totals[i].vectors;
+		totals[i].size += (unsigned long long)vec->size* vec->data_size;
+		totals[i].capacity += vec->capacity;
+	}
+
+	return totals;
+}
+
+static const tag_totals* find_totals(const tag_totals* totals, uint count, const char* tag)
+{
+	for(uint i = 0;i < count;++i)
+	{
+		if(strcmp(totals[i].tag, tag) == 0)
+			return &totals[i];
+	}
+
+	return NULL;
+}
+
+// Writes s as a JSON string
+static void write_json_string(FILE* file, const char* s)
+{
+	fputc('"', file);
+
+	for(;*s != '\0';++s)
+	{
+		if(*s == '"' || *s == '\\')
+			fputc('\\', file);
+
+		if((unsigned char)*s >= 0x20)
+			fputc(*s, file);
+	}
+
+	fputc('"', file);
+}
+
+#ifndef NDEBUG
+// Must be called with the lock taken
+static int is_linked(const vector* vec)
+{
+	for(const vector* node = head.registry_next;node != &head;node = node->registry_next)
+	{
+		if(node == vec)
+			return 1;
+	}
+
+	return 0;
+}
+#endif
+
+void vec_registry_add(vector* vec)
+{
+	call_once(&registry_once, init_registry);
+
+	vec->tag = NULL;
+
+	mtx_lock(&registry_mutex);
+	// A vector initialized twice without vec_destroy would be linked twice, making the list loop on itself.
+	// The links of vec can not be trusted before vec_init, so the whole list is searched, only in debug builds
+	assert(!is_linked(vec));
+	vec->registry_prev = &head;
+	vec->registry_next = head.registry_next;
+	head.registry_next->registry_prev = vec;
+	head.registry_next = vec;
+	++live_count;
+	mtx_unlock(&registry_mutex);
+}
+
+void vec_registry_remove(vector* vec)
+{
+	if(vec->registry_next == NULL)
+		return;
+
+	mtx_lock(&registry_mutex);
+	vec->registry_prev->registry_next = vec->registry_next;
+	vec->registry_next->registry_prev = vec->registry_prev;
+	--live_count;
+	mtx_unlock(&registry_mutex);
+
+	vec->registry_prev = NULL;
+	vec->registry_next = NULL;
+}
+
+void vec_set_tag(vector* vec, const char* tag)
+{
+	assert(vec != NULL);
+
+	vec->tag = tag;
+}
+
+const char* vec_get_tag(vector* vec)
+{
+	assert(vec != NULL);
+
+	return vec->tag;
+}
+
+uint vec_registry_count()
+{
+	call_once(&registry_once, init_registry);
+
+	mtx_lock(&registry_mutex);
+	const uint count = live_count;
+	mtx_unlock(&registry_mutex);
+
+	return count;
+}
+
+void vec_report(FILE* file, vec_report_format format, uint largest)
+{
+	assert(file != NULL);
+
+	call_once(&registry_once, init_registry);
+
+	vector_info* infos = largest > 0 ? (vector_info*)malloc(largest* sizeof(vector_info)) : NULL;
+	uint info_count = 0;
+	uint tag_count;
+
+	mtx_lock(&registry_mutex);
+
+	const uint count = live_count;
+	tag_totals* totals = aggregate(&tag_count);
+
+	// Insertion in the list of the largest vectors, sorted by capacity
+	for(vector* vec = head.registry_next;vec != &head && largest > 0;vec = vec->registry_next)
+	{
+		if(info_count == largest && vec->capacity <= infos[info_count-1].capacity)
+			continue;
+
+		uint pos = info_count < largest ? info_count++ : info_count - 1;
+
+		for(;pos > 0 && infos[pos-1].capacity < vec->capacity;--pos)
+		{
+			infos[pos] = infos[pos-1];
+		}
+
+		infos[pos].address = vec;
+		infos[pos].tag = tag_name(vec->tag);
+		infos[pos].data_size = vec->data_size;
+		infos[pos].size = vec->size;
+		infos[pos].capacity = vec->capacity;
+	}
+
+	mtx_unlock(&registry_mutex);
+
+	if(format == VEC_REPORT_JSON)
+	{
+		fprintf(file, "{\"vectors\": %u, \"tags\": [", count);
+
+		for(uint i = 0;i < tag_count;++i)
+		{
+			fprintf(file, i == 0 ? "{\"tag\": " : ", {\"tag\": ");
+			write_json_string(file, totals[i].tag);
+			fprintf(file, ", \"vectors\": %u, \"size_bytes\": %llu, \"capacity_bytes\": %llu, \"budget_bytes\": %llu}",
+				totals[i].vectors, totals[i].size, totals[i].capacity, totals[i].budget);
+		}
+
+		fprintf(file, "], \"largest\": [");
+
+		for(uint i = 0;i < info_count;++i)
+		{
+			fprintf(file, i == 0 ? "{\"tag\": " : ", {\"tag\": ");
+			write_json_string(file, infos[i].tag);
+			fprintf(file, ", \"address\": \"%p\", \"data_size\": %u, \"size\": %u, \"capacity_bytes\": %u}",
+				infos[i].address, infos[i].data_size, infos[i].size, infos[i].capacity);
+		}
+
+		fprintf(file, "]}\n");
+	}
+	else
+	{
+		fprintf(file, "%u live vectors\n", count);
+		fprintf(file, "%-24s %10s %16s %16s %16s\n", "tag", "vectors", "size bytes", "capacity bytes", "budget bytes");
+
+		for(uint i = 0;i < tag_count;++i)
+		{
+			fprintf(file, "%-24s %10u %16llu %16llu", totals[i].tag, totals[i].vectors, totals[i].size,
+				totals[i].capacity);
+
+			if(totals[i].budget != 0)
+				fprintf(file, " %16llu%s\n", totals[i].budget, totals[i].capacity > totals[i].budget ? " (over)" : "");
+			else
+				fprintf(file, " %16s\n", "-");
+		}
+
+		if(info_count > 0)
+			fprintf(file, "Largest vectors:\n");
+
+		for(uint i = 0;i < info_count;++i)
+		{
+			fprintf(file, "%-24s %18p %6u bytes x %10u, capacity %u bytes\n", infos[i].tag, infos[i].address,
+				infos[i].data_size, infos[i].size, infos[i].capacity);
+		}
+	}
+
+	free(totals);
+	free(infos);
+}
+
+void vec_set_budget(const char* tag, unsigned long long bytes)
+{
+	assert(tag != NULL);
+
+	call_once(&registry_once, init_registry);
+
+	mtx_lock(&registry_mutex);
+
+	uint i = 0;
+	while(i < budget_count && strcmp(budgets[i].tag, tag) != 0)
+		++i;
+
+	if(i == budget_count)
+	{
+		budgets = (tag_budget*)realloc(budgets, (budget_count + 1)* sizeof(tag_budget));
+		budgets[i].tag = tag;
+		++budget_count;
+	}
+
+	budgets[i].bytes = bytes;
+
+	mtx_unlock(&registry_mutex);
+}
+
+unsigned long long vec_registry_enforce()
+{
+	unsigned long long released = 0;
+	uint tag_count;
+	uint count = 0;
+
+	call_once(&registry_once, init_registry);
+
+	mtx_lock(&registry_mutex);
+
+	tag_totals* totals = aggregate(&tag_count);
+	vector** over = (vector**)malloc((live_count > 0 ? live_count : 1)* sizeof(vector*));
+
+	for(vector* vec = head.registry_next;vec != &head;vec = vec->registry_next)
+	{
+		const tag_totals* t = find_totals(totals, tag_count, tag_name(vec->tag));
+
+		// Shared storages are not shrunk, since other vectors use them
+		if(t->budget == 0 || t->capacity <= t->budget || vec->storage != NULL)
+			continue;
+
+		over[count++] = vec;
+	}
+
+	mtx_unlock(&registry_mutex);
+
+	// Shrinking runs realloc_func and the reallocation hook, which may take their own locks, so it is done
+	// without the lock of the registry
+	for(uint i = 0;i < count;++i)
+	{
+		const uint capacity = over[i]->capacity;
+		vec_shrink_to_fit(over[i]);
+		released += capacity - over[i]->capacity;
+	}
+
+	free(over);
+	free(totals);
+
+	return released;
+}
+
+#else
+
+void vec_set_tag(vector* vec, const char* tag)
+{
+}
+
+const char* vec_get_tag(vector* vec)
+{
+	return NULL;
+}
+
+uint vec_registry_count()
+{
+	return 0;
+}
+
+void vec_report(FILE* file, vec_report_format format, uint largest)
+{
+	if(format == VEC_REPORT_JSON)
+		fprintf(file, "{\"vectors\": 0, \"tags\": [], \"largest\": []}\n");
+	else
+		fprintf(file, "Vector registry not compiled in (VEC_REGISTRY)\n");
+}
+
+void vec_set_budget(const char* tag, unsigned long long bytes)
+{
+}
+
+unsigned long long vec_registry_enforce()
+{
+	return 0;
+}
+
+void vec_registry_add(vector* vec)
+{
+}
+
+void vec_registry_remove(vector* vec)
+{
+}
+
+#endif
@@ -0,0 +1,212 @@
+#include "vector/sharded.h"
+#include "vector/parallel.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+
+vec_sharded* vec_shard_create(uint data_size, uint count)
+{
+	vec_sharded* sv = (vec_sharded*)malloc(sizeof(vec_sharded));
+
+	vec_shard_init(sv, data_size, count);
+
+	return sv;
+}
+
+void vec_shard_free(vec_sharded* sv)
+{
+	assert(sv != NULL);
+
+	vec_shard_destroy(sv);
+	free(sv);
+}
+
+void vec_shard_init(vec_sharded* sv, uint data_size, uint count)
+{
+	assert(sv != NULL);
+
+	sv->count = count > 0 ? count : vec_hardware_threads();
+	sv->data_size = data_size;
+	sv->shards = (vec_shard*)vec_cache_alloc(sv->count* sizeof(vec_shard));
+
+	for(uint i = 0;i < sv->count;++i)
+	{
+		vec_init(&sv->shards[i].vec, data_size);
+	}
+}
+
+void vec_shard_destroy(vec_sharded* sv)
+{
+	assert(sv != NULL);
+
+	for(uint i = 0;i < sv->count;++i)
+	{
+		vec_destroy(&sv->shards[i].vec);
+	}
+
+	vec_cache_free(sv->shards);
+	sv->shards = NULL;
+	sv->count = 0;
+}
+
+vector* vec_shard_get(vec_sharded* sv, uint shard)
+{
+	assert(sv != NULL);
+	assert(shard < sv->count);
+
+	return &sv->shards[shard].vec;
+}
+
+void vec_shard_push_back(vec_sharded* sv, uint shard, void* element)
+{
+	vec_push_back(vec_shard_get(sv, shard), element);
+}
+
+uint vec_shard_size(vec_sharded* sv)
+{
+	assert(sv != NULL);
+
+	uint size = 0;
+
+	for(uint i = 0;i < sv->count;++i)
+	{
+		size += sv->shards[i].vec.size;
+	}
+
+	return size;
+}
+
+void vec_shard_clear(vec_sharded* sv)
+{
+	assert(sv != NULL);
+
+	for(uint i = 0;i < sv->count;++i)
+	{
+		vec_clear(&sv->shards[i].vec);
+	}
+}
+
+// Exchanges the data storage of two vectors, with the functions that manage it
+static void swap_data(vector* v1, vector* v2)
+{
+	vector tmp = *v1;
+
+	v1->buffer = v2->buffer;
+	v1->size = v2->size;
+	v1->capacity = v2->capacity;
+	v1->storage = v2->storage;
+	v1->alloc_func = v2->alloc_func;
+	v1->realloc_func = v2->realloc_func;
+	v1->free_func = v2->free_func;
+
+	v2->buffer = tmp.buffer;
+	v2->size = tmp.size;
+	v2->capacity = tmp.capacity;
+	v2->storage = tmp.storage;
+	v2->alloc_func = tmp.alloc_func;
+	v2->realloc_func = tmp.realloc_func;
+	v2->free_func = tmp.free_func;
+}
+
+typedef struct merge_job
+{
+	vec_sharded* sv;
+	char* dst; // Buffer of the merged vector
+	uint* shards; // Shards to copy, in destination order
+	uint* starts; // Destination position of each shard to copy, followed by the end position
+	uint count; // Number of shards to copy
+} merge_job;
+
+static void merge_range(uint first, uint last, uint worker, void* ctx)
+{
+	merge_job* job = ctx;
+	const uint data_size = job->sv->data_size;
+
+	// Last shard starting at or before first
+	uint lo = 0, hi = job->count;
+	while(hi - lo > 1)
+	{
+		const uint mid = (lo + hi) / 2;
+
+		if(job->starts[mid] <= first)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	for(uint i = lo;i < job->count && first < last;++i)
+	{
+		const uint end = job->starts[i+1] < last ? job->starts[i+1] : last;
+		const char* src = job->sv->shards[job->shards[i]].vec.buffer;
+
+		memcpy(job->dst + first*data_size, src + (first - job->starts[i])*data_size, (end - first)*data_size);
+		first = end;
+	}
+}
+
+vector* vec_shard_merge(vec_sharded* sv, vector* dst, int ordered)
+{
+	assert(sv != NULL);
+	assert(dst != NULL);
+	assert(dst->data_size == sv->data_size);
+
+	const uint size = vec_shard_size(sv);
+	uint* shards = (uint*)malloc(sv->count* sizeof(uint));
+	uint* starts = (uint*)malloc((sv->count + 1)* sizeof(uint));
+	uint count = 0;
+	uint pos = 0;
+
+	vec_clear(dst);
+
+	if(!ordered)
+	{
+		uint largest = 0;
+
+		for(uint i = 1;i < sv->count;++i)
+		{
+			if(sv->shards[i].vec.size > sv->shards[largest].vec.size)
+				largest = i;
+		}
+
+		// The largest shard is already in place, and the shard is left with the old buffer of dst
+		swap_data(dst, &sv->shards[largest].vec);
+		pos = dst->size;
+	}
+
+	for(uint i = 0;i < sv->count;++i)
+	{
+		if(sv->shards[i].vec.size > 0)
+		{
+			shards[count] = i;
+			starts[count] = pos;
+			pos += sv->shards[i].vec.size;
+			++count;
+		}
+	}
+
+	starts[count] = pos;
+
+	vec_resize(dst, size);
+
+	if(count > 0)
+	{
+		merge_job job = { sv, dst->buffer, shards, starts, count };
+		const uint first = starts[0];
+
+		// Positions before the first shard to copy are already in place
+		job.dst += first* sv->data_size;
+		for(uint i = 0;i <= count;++i)
+		{
+			starts[i] -= first;
+		}
+
+		vec_pool_run(vec_pool_default(), size - first, vec_cache_align(sv->data_size), merge_range, &job);
+	}
+
+	vec_shard_clear(sv);
+
+	free(starts);
+	free(shards);
+
+	return dst;
+}
@@ -0,0 +1,547 @@
+// For fseeko, with 64 bit offsets on 32 bit systems too
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "vector/snapshot.h"
+#include "vector/parallel.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <limits.h>
+
+// =========================== LZ CODEC ===================================
+//
+// LZ4-like format. A block is a list of sequences: a token with the number of literals (high 4 bits) and
+// the match length - 4 (low 4 bits), extra length bytes when a field is 15, the literals, and a 2 bytes
+// little endian offset of the match. The last sequence only has literals
+
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 12
+#define LZ_MAX_OFFSET 65535
+// The last bytes of a block are always literals, so matches never read past the input
+#define LZ_LAST_LITERALS 5
+
+typedef unsigned char uchar;
+
+static uint32_t read32(const uchar* p)
+{
+	uint32_t value;
+	memcpy(&value, p, 4);
+
+	return value;
+}
+
+static uint lz_hash(uint32_t sequence)
+{
+	return (sequence* 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+// Maximum size of n bytes compressed
+static uint lz_bound(uint n)
+{
+	return n + n / 255 + 16;
+}
+
+static uchar* write_length(uchar* out, uint length)
+{
+	for(;length >= 255;length -= 255)
+		*out++ = 255;
+
+	*out++ = (uchar)length;
+
+	return out;
+}
+
+static uchar* write_sequence(uchar* out, const uchar* literals, uint literal_count, uint offset, uint match_length)
+{
+	uchar* token = out++;
+	const uint match_code = match_length >= LZ_MIN_MATCH ? match_length - LZ_MIN_MATCH : 0;
+
+	*token = (uchar)((literal_count < 15 ? literal_count : 15) << 4);
+
+	if(literal_count >= 15)
+		out = write_length(out, literal_count - 15);
+
+	memcpy(out, literals, literal_count);
+	out += literal_count;
+
+	// The last sequence has no match
+	if(match_length == 0)
+		return out;
+
+	*token |= (uchar)(match_code < 15 ? match_code : 15);
+	*out++ = (uchar)offset;
+	*out++ = (uchar)(offset >> 8);
+
+	if(match_code >= 15)
+		out = write_length(out, match_code - 15);
+
+	return out;
+}
+
+// Compresses n bytes of src into dst, which must hold lz_bound(n) bytes. Returns the compressed size
+static uint lz_compress(const uchar* src, uint n, uchar* dst)
+{
+	uint table[1 << LZ_HASH_BITS];
+	uchar* out = dst;
+	uint anchor = 0;
+	uint i = 0;
+
+	// Positions + 1, so that 0 is empty
+	memset(table, 0, sizeof(table));
+
+	while(n >= LZ_LAST_LITERALS + LZ_MIN_MATCH && i <= n - LZ_LAST_LITERALS - LZ_MIN_MATCH)
+	{
+		const uint32_t sequence = read32(src + i);
+		const uint h = lz_hash(sequence);
+		const uint candidate = table[h];
+
+		table[h] = i + 1;
+
+		if(candidate == 0 || i - (candidate-1) > LZ_MAX_OFFSET || read32(src + candidate-1) != sequence)
+		{
+			++i;
+			continue;
+		}
+
+		const uint match = candidate - 1;
+		uint length = LZ_MIN_MATCH;
+
+		while(i + length < n - LZ_LAST_LITERALS && src[match + length] == src[i + length])
+			++length;
+
+		out = write_sequence(out, src + anchor, i - anchor, i - match, length);
+		i += length;
+		anchor = i;
+	}
+
+	out = write_sequence(out, src + anchor, n - anchor, 0, 0);
+
+	return (uint)(out - dst);
+}
+
+static int read_length(const uchar** in, const uchar* end, uint* length)
+{
+	uchar byte;
+
+	do
+	{
+		if(*in >= end)
+			return 0;
+
+		byte = *(*in)++;
+		*length += byte;
+	}
+	while(byte == 255);
+
+	return 1;
+}
+
+// Decompresses n bytes of src into dst, which must become exactly dst_size bytes. Returns 0 if src is corrupted
+static int lz_decompress(const uchar* src, uint n, uchar* dst, uint dst_size)
+{
+	const uchar* in = src;
+	const uchar* end = src + n;
+	uint pos = 0;
+
+	while(in < end)
+	{
+		const uchar token = *in++;
+		uint literal_count = token >> 4;
+
+		if(literal_count == 15 && !read_length(&in, end, &literal_count))
+			return 0;
+
+		if(literal_count > (uint)(end - in) || literal_count > dst_size - pos)
+			return 0;
+
+		memcpy(dst + pos, in, literal_count);
+		in += literal_count;
+		pos += literal_count;
+
+		if(in == end)
+			break;
+
+		if(end - in < 2)
+			return 0;
+
+		const uint offset = in[0] | (uint)in[1] << 8;
+		uint length = token & 15;
+		in += 2;
+
+		if(length == 15 && !read_length(&in, end, &length))
+			return 0;
+
+		length += LZ_MIN_MATCH;
+
+		if(offset == 0 || offset > pos || length > dst_size - pos)
+			return 0;
+
+		// The match may overlap the bytes being written
+		const uchar* match = dst + pos - offset;
+		for(uint i = 0;i < length;++i)
+		{
+			dst[pos + i] = match[i];
+		}
+
+		pos += length;
+	}
+
+	return pos == dst_size;
+}
+
+// =========================== SHUFFLING ===================================
+
+static void shuffle(const uchar* src, uchar* dst, uint count, uint data_size)
+{
+	for(uint b = 0;b < data_size;++b)
+	{
+		uchar* out = dst + b* count;
+
+		for(uint i = 0;i < count;++i)
+		{
+			out[i] = src[i* data_size + b];
+		}
+	}
+}
+
+static void unshuffle(const uchar* src, uchar* dst, uint count, uint data_size)
+{
+	for(uint b = 0;b < data_size;++b)
+	{
+		const uchar* in = src + b* count;
+
+		for(uint i = 0;i < count;++i)
+		{
+			dst[i* data_size + b] = in[i];
+		}
+	}
+}
+
+// =========================== SNAPSHOTS ===================================
+
+typedef struct block_job
+{
+	const vec_snapshot_header* header;
+	vec_snapshot_block* blocks;
+	uchar* elements; // Uncompressed elements of the first block of the job
+	uchar* data; // Compressed blocks
+	uint first_block; // Block of elements[0]
+	uint slot_size; // Room for each compressed block when compressing
+	atomic_int result; // VEC_IO_OK, or the error of a failed block
+} block_job;
+
+// Number of elements of a block
+static uint block_count(const vec_snapshot_header* header, uint block)
+{
+	const uint first = block* header->block_elements;
+
+	return header->count - first < header->block_elements ? header->count - first : header->block_elements;
+}
+
+// Number of elements of the biggest block. block_elements comes from the file, so it may be much bigger than count
+static uint max_block_count(const vec_snapshot_header* header)
+{
+	return header->count < header->block_elements ? header->count : header->block_elements;
+}
+
+// Ranges are in elements and always hold whole blocks
+static void compress_range(uint first, uint last, uint worker, void* ctx)
+{
+	block_job* job = ctx;
+	const uint data_size = job->header->data_size;
+	uchar* shuffled = (uchar*)malloc(max_block_count(job->header)* data_size);
+
+	if(shuffled == NULL)
+	{
+		atomic_store(&job->result, VEC_IO_ERROR);
+		return;
+	}
+
+	for(uint block = first / job->header->block_elements;block* job->header->block_elements < last;++block)
+	{
+		const uint count = block_count(job->header, block);
+		const uint bytes = count* data_size;
+		const uchar* elements = job->elements + (size_t)block* job->header->block_elements* data_size;
+		uchar* out = job->data + (size_t)block* job->slot_size;
+
+		shuffle(elements, shuffled, count, data_size);
+
+		uint size = lz_compress(shuffled, bytes, out);
+
+		if(size >= bytes)
+		{
+			memcpy(out, shuffled, bytes);
+			size = bytes;
+		}
+
+		job->blocks[block].size = size;
+		job->blocks[block].checksum = vec_io_checksum(elements, bytes, 0);
+	}
+
+	free(shuffled);
+}
+
+static void decompress_range(uint first, uint last, uint worker, void* ctx)
+{
+	block_job* job = ctx;
+	const uint data_size = job->header->data_size;
+	const uint block_elements = job->header->block_elements;
+	uchar* shuffled = (uchar*)malloc(max_block_count(job->header)* data_size);
+	const unsigned long long base = job->blocks[job->first_block].offset;
+
+	if(shuffled == NULL)
+	{
+		atomic_store(&job->result, VEC_IO_ERROR);
+		return;
+	}
+
+	for(uint block = job->first_block + first / block_elements;(block - job->first_block)* block_elements < last;++block)
+	{
+		const vec_snapshot_block* b = &job->blocks[block];
+		const uint count = block_count(job->header, block);
+		const uint bytes = count* data_size;
+		const uchar* in = job->data + (b->offset - base);
+		uchar* elements = job->elements + (size_t)(block - job->first_block)* block_elements* data_size;
+
+		if(b->size == bytes)
+		{
+			memcpy(shuffled, in, bytes);
+		}
+		else if(!lz_decompress(in, b->size, shuffled, bytes))
+		{
+			atomic_store(&job->result, VEC_IO_BAD_CHECKSUM);
+			continue;
+		}
+
+		unshuffle(shuffled, elements, count, data_size);
+
+		if(vec_io_checksum(elements, bytes, 0) != b->checksum)
+		{
+			atomic_store(&job->result, VEC_IO_BAD_CHECKSUM);
+		}
+	}
+
+	free(shuffled);
+}
+
+vec_io_result vec_snapshot_write(vector* vec, FILE* file)
+{
+	assert(vec != NULL);
+	assert(file != NULL);
+
+	const uint data_size = vec->data_size;
+	const uint block_elements = VEC_SNAPSHOT_BLOCK / data_size > 0 ? VEC_SNAPSHOT_BLOCK / data_size : 1;
+	const vec_snapshot_header header = { VEC_SNAPSHOT_MAGIC, VEC_SNAPSHOT_VERSION, VEC_IO_ENDIANNESS, data_size,
+		vec->size, block_elements, (vec->size + block_elements - 1) / block_elements };
+
+	vec_snapshot_block* blocks = (vec_snapshot_block*)malloc((header.block_count + 1)* sizeof(vec_snapshot_block));
+	const uint slot_size = lz_bound(block_elements* data_size);
+	uchar* data = (uchar*)malloc((size_t)header.block_count* slot_size + 1);
+	block_job job = { &header, blocks, vec->buffer, data, 0, slot_size, VEC_IO_OK };
+
+	if(blocks == NULL || data == NULL)
+	{
+		free(data);
+		free(blocks);
+		return VEC_IO_ERROR;
+	}
+
+	// Tasks hold whole blocks
+	vec_pool_run(vec_pool_default(), vec->size, block_elements, compress_range, &job);
+
+	vec_io_result result = (vec_io_result)atomic_load(&job.result);
+	unsigned long long offset = 0;
+	for(uint i = 0;i < header.block_count && result == VEC_IO_OK;++i)
+	{
+		blocks[i].offset = offset;
+		offset += blocks[i].size;
+	}
+
+	if(result == VEC_IO_OK && (fwrite(&header, sizeof(header), 1, file) != 1
+		|| fwrite(blocks, sizeof(vec_snapshot_block), header.block_count, file) != header.block_count))
+	{
+		result = VEC_IO_ERROR;
+	}
+
+	for(uint i = 0;i < header.block_count && result == VEC_IO_OK;++i)
+	{
+		if(fwrite(data + (size_t)i* slot_size, blocks[i].size, 1, file) != 1)
+			result = VEC_IO_ERROR;
+	}
+
+	free(data);
+	free(blocks);
+
+	return result;
+}
+
+// Moves the position of file offset bytes forward. offset may not fit in a long, which is 32 bits on Windows
+static int seek_forward(FILE* file, unsigned long long offset)
+{
+#ifdef _WIN32
+	return _fseeki64(file, (long long)offset, SEEK_CUR);
+#else
+	return fseeko(file, (off_t)offset, SEEK_CUR);
+#endif
+}
+
+// Reads the header and the block table. Both come from the file, so they are checked before they are used:
+// the blocks must follow each other, and none can be bigger than its elements, since those are stored as is
+static vec_io_result read_table(vector* vec, FILE* file, vec_snapshot_header* header, vec_snapshot_block** blocks)
+{
+	if(fread(header, sizeof(*header), 1, file) != 1)
+		return ferror(file) ? VEC_IO_ERROR : VEC_IO_EOF;
+
+	if(header->magic != VEC_SNAPSHOT_MAGIC || header->version != VEC_SNAPSHOT_VERSION
+		|| header->endianness != VEC_IO_ENDIANNESS || header->data_size != vec->data_size || header->block_elements == 0
+		|| header->count > UINT_MAX / header->data_size || header->block_elements > UINT_MAX / header->data_size
+		|| header->block_count != header->count / header->block_elements + (header->count % header->block_elements != 0))
+	{
+		return VEC_IO_BAD_HEADER;
+	}
+
+	*blocks = (vec_snapshot_block*)malloc(((size_t)header->block_count + 1)* sizeof(vec_snapshot_block));
+
+	if(*blocks == NULL)
+		return VEC_IO_ERROR;
+
+	if(fread(*blocks, sizeof(vec_snapshot_block), header->block_count, file) != header->block_count)
+	{
+		free(*blocks);
+		return ferror(file) ? VEC_IO_ERROR : VEC_IO_EOF;
+	}
+
+	unsigned long long offset = 0;
+
+	for(uint i = 0;i < header->block_count;++i)
+	{
+		if((*blocks)[i].offset != offset || (*blocks)[i].size > block_count(header, i)* header->data_size)
+		{
+			free(*blocks);
+			return VEC_IO_BAD_HEADER;
+		}
+
+		offset += (*blocks)[i].size;
+	}
+
+	return VEC_IO_OK;
+}
+
+// Reads the blocks [first, last) from the current position of file, which is the start of block first,
+// and decompresses them into elements
+static vec_io_result read_blocks(FILE* file, const vec_snapshot_header* header, vec_snapshot_block* blocks,
+	uint first, uint last, void* elements)
+{
+	const unsigned long long begin = blocks[first].offset;
+	const unsigned long long end = blocks[last-1].offset + blocks[last-1].size;
+	uchar* data = (uchar*)malloc(end - begin + 1);
+	vec_io_result result = VEC_IO_OK;
+
+	if(data == NULL)
+		return VEC_IO_ERROR;
+
+	if(fread(data, end - begin, 1, file) != 1)
+	{
+		result = ferror(file) ? VEC_IO_ERROR : VEC_IO_EOF;
+	}
+	else
+	{
+		block_job job = { header, blocks, elements, data, first, 0, VEC_IO_OK };
+		const uint first_element = first* header->block_elements;
+		const uint last_element = last == header->block_count ? header->count : last* header->block_elements;
+
+		vec_pool_run(vec_pool_default(), last_element - first_element, header->block_elements, decompress_range, &job);
+
+		result = (vec_io_result)atomic_load(&job.result);
+	}
+
+	free(data);
+
+	return result;
+}
+
+vec_io_result vec_snapshot_read(vector* vec, FILE* file)
+{
+	assert(vec != NULL);
+	assert(file != NULL);
+
+	vec_snapshot_header header;
+	vec_snapshot_block* blocks;
+	vec_io_result result = read_table(vec, file, &header, &blocks);
+
+	if(result != VEC_IO_OK)
+		return result;
+
+	vec_clear(vec);
+
+	if(header.count > 0)
+	{
+		vec_resize(vec, header.count);
+		result = read_blocks(file, &header, blocks, 0, header.block_count, vec->buffer);
+
+		if(result != VEC_IO_OK)
+			vec_clear(vec);
+	}
+
+	free(blocks);
+
+	return result;
+}
+
+vec_io_result vec_snapshot_read_range(vector* vec, FILE* file, uint offset, uint count)
+{
+	assert(vec != NULL);
+	assert(file != NULL);
+
+	vec_snapshot_header header;
+	vec_snapshot_block* blocks;
+	vec_io_result result = read_table(vec, file, &header, &blocks);
+
+	if(result != VEC_IO_OK)
+		return result;
+
+	if(offset > header.count || count > header.count - offset)
+	{
+		free(blocks);
+		return VEC_IO_EOF;
+	}
+
+	vec_clear(vec);
+
+	if(count > 0)
+	{
+		const uint first = offset / header.block_elements;
+		const uint last = (offset + count - 1) / header.block_elements + 1;
+		const uint data_size = header.data_size;
+		const uint last_element = last == header.block_count ? header.count : last* header.block_elements;
+		uchar* elements = (uchar*)malloc((size_t)(last_element - first* header.block_elements)* data_size);
+
+		if(elements == NULL || seek_forward(file, blocks[first].offset) != 0)
+		{
+			result = VEC_IO_ERROR;
+		}
+		else
+		{
+			result = read_blocks(file, &header, blocks, first, last, elements);
+		}
+
+		if(result == VEC_IO_OK)
+		{
+			vec_resize(vec, count);
+			memcpy(vec->buffer, elements + (size_t)(offset - first* header.block_elements)* data_size, count* data_size);
+		}
+
+		free(elements);
+	}
+
+	free(blocks);
+
+	return result;
+}
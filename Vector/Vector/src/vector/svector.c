@@ -0,0 +1,580 @@
+#include "vector/svector.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+
+// Returns the position in sv->indices of the first stored index not less than pos
+static uint lower_bound(svector* sv, uint pos)
+{
+	const uint* indices = sv->indices.buffer;
+	uint first = 0;
+	uint count = sv->indices.size;
+
+	while(count > 0)
+	{
+		const uint step = count / 2;
+
+		if(indices[first+step] < pos)
+		{
+			first += step+1;
+			count -= step+1;
+		}
+		else
+		{
+			count = step;
+		}
+	}
+
+	return first;
+}
+
+static int is_default(svector* sv, const void* element)
+{
+	return sv->equal_func((void*)element, sv->default_value, sv->data_size);
+}
+
+// Switches to dense mode if the density went above the threshold
+static void check_density(svector* sv)
+{
+	if(!sv->dense && sv->nnz > sv->threshold* sv->size)
+	{
+		svec_densify(sv);
+	}
+}
+
+svector* svec_create(uint data_size, const void* default_value)
+{
+	svector* sv = (svector*)malloc(sizeof(svector));
+
+	svec_init(sv, data_size, default_value);
+
+	return sv;
+}
+
+void svec_free(svector* sv)
+{
+	assert(sv != NULL);
+
+	svec_destroy(sv);
+	free(sv);
+}
+
+void svec_init(svector* sv, uint data_size, const void* default_value)
+{
+	assert(sv != NULL);
+
+	vec_init(&sv->indices, sizeof(uint));
+	vec_init(&sv->values, data_size);
+	sv->default_value = calloc(1, data_size);
+	sv->size = 0;
+	sv->nnz = 0;
+	sv->data_size = data_size;
+	sv->dense = 0;
+	sv->threshold = SVEC_DEFAULT_THRESHOLD;
+	sv->equal_func = sv->values.equal_func;
+
+	if(default_value != NULL)
+	{
+		memcpy(sv->default_value, default_value, data_size);
+	}
+}
+
+void svec_destroy(svector* sv)
+{
+	assert(sv != NULL);
+
+	vec_destroy(&sv->indices);
+	vec_destroy(&sv->values);
+	free(sv->default_value);
+	sv->default_value = NULL;
+	sv->size = 0;
+	sv->nnz = 0;
+}
+
+void svec_set_threshold(svector* sv, float threshold)
+{
+	assert(sv != NULL);
+
+	sv->threshold = threshold;
+	check_density(sv);
+}
+
+void svec_densify(svector* sv)
+{
+	assert(sv != NULL);
+
+	if(sv->dense)
+		return;
+
+	const uint data_size = sv->data_size;
+	const uint* indices = sv->indices.buffer;
+
+	vector values;
+	vec_init(&values, data_size);
+	values.equal_func = sv->equal_func;
+	vec_resize_val(&values, sv->size, sv->default_value);
+
+	char* dst = values.buffer;
+	const char* src = sv->values.buffer;
+
+	for(uint i = 0;i < sv->indices.size;++i)
+	{
+		memcpy(dst + indices[i]*data_size, src + i*data_size, data_size);
+	}
+
+	vec_move(&sv->values, &values);
+	vec_destroy(&values);
+	vec_destroy(&sv->indices);
+	vec_init(&sv->indices, sizeof(uint));
+	sv->dense = 1;
+}
+
+void svec_sparsify(svector* sv)
+{
+	assert(sv != NULL);
+
+	if(!sv->dense)
+		return;
+
+	const uint data_size = sv->data_size;
+	const char* src = sv->values.buffer;
+
+	vector values;
+	vec_init(&values, data_size);
+	values.equal_func = sv->equal_func;
+	vec_reserve(&values, sv->nnz);
+	vec_reserve(&sv->indices, sv->nnz);
+
+	for(uint i = 0;i < sv->size;++i)
+	{
+		if(!is_default(sv, src + i*data_size))
+		{
+			vec_push_back(&sv->indices, &i);
+			vec_push_back(&values, (void*)(src + i*data_size));
+		}
+	}
+
+	vec_move(&sv->values, &values);
+	vec_destroy(&values);
+	sv->dense = 0;
+}
+
+void svec_resize(svector* sv, uint new_size)
+{
+	assert(sv != NULL);
+
+	if(new_size < sv->size)
+	{
+		if(sv->dense)
+		{
+			// Elements being removed are no longer counted
+			const char* buffer = sv->values.buffer;
+			for(uint i = new_size;i < sv->size;++i)
+			{
+				if(!is_default(sv, buffer + i*sv->data_size))
+					--sv->nnz;
+			}
+
+			vec_resize(&sv->values, new_size);
+		}
+		else
+		{
+			const uint first = lower_bound(sv, new_size);
+			vec_erase_range(&sv->indices, first, sv->indices.size);
+			vec_erase_range(&sv->values, first, sv->values.size);
+			sv->nnz = first;
+		}
+
+		sv->size = new_size;
+		return;
+	}
+
+	const uint old_size = sv->size;
+	sv->size = new_size;
+
+	if(sv->dense)
+	{
+		if(sv->nnz < sv->threshold* new_size / 2)
+		{
+			// Shrink the existing elements before growing
+			sv->size = old_size;
+			svec_sparsify(sv);
+			sv->size = new_size;
+		}
+		else
+		{
+			vec_resize_val(&sv->values, new_size, sv->default_value);
+		}
+	}
+}
+
+const void* svec_at(svector* sv, uint pos)
+{
+	assert(sv != NULL);
+	assert(pos < sv->size);
+
+	if(sv->dense)
+		return vec_get(&sv->values, pos);
+
+	const uint i = lower_bound(sv, pos);
+
+	if(i < sv->indices.size && *(const uint*)vec_get(&sv->indices, i) == pos)
+		return vec_get(&sv->values, i);
+
+	return sv->default_value;
+}
+
+void* svec_at_cp(svector* sv, uint pos, void* element)
+{
+	assert(element != NULL);
+
+	return memcpy(element, svec_at(sv, pos), sv->data_size);
+}
+
+void svec_replace(svector* sv, uint pos, const void* element)
+{
+	assert(sv != NULL);
+	assert(pos < sv->size);
+	assert(element != NULL);
+
+	const int element_default = is_default(sv, element);
+
+	if(sv->dense)
+	{
+		void* ptr = vec_at(&sv->values, pos);
+		const int old_default = is_default(sv, ptr);
+
+		sv->nnz += old_default - element_default;
+		memcpy(ptr, element, sv->data_size);
+		return;
+	}
+
+	const uint i = lower_bound(sv, pos);
+	const int stored = i < sv->indices.size && *(const uint*)vec_get(&sv->indices, i) == pos;
+
+	if(stored)
+	{
+		if(element_default)
+		{
+			vec_erase(&sv->indices, i);
+			vec_erase(&sv->values, i);
+			--sv->nnz;
+		}
+		else
+		{
+			vec_replace(&sv->values, i, (void*)element);
+		}
+	}
+	else if(!element_default)
+	{
+		vec_insert(&sv->indices, i, &pos);
+		vec_insert(&sv->values, i, (void*)element);
+		++sv->nnz;
+		check_density(sv);
+	}
+}
+
+void svec_push_back(svector* sv, const void* element)
+{
+	assert(sv != NULL);
+
+	if(sv->dense)
+	{
+		vec_push_back(&sv->values, (void*)element);
+		sv->nnz += !is_default(sv, element);
+		++sv->size;
+		return;
+	}
+
+	++sv->size;
+	svec_replace(sv, sv->size-1, element);
+}
+
+uint svec_next(svector* sv, uint pos)
+{
+	assert(sv != NULL);
+
+	if(sv->dense)
+	{
+		const char* buffer = sv->values.buffer;
+
+		for(uint i = pos;i < sv->size;++i)
+		{
+			if(!is_default(sv, buffer + i*sv->data_size))
+				return i;
+		}
+
+		return VEC_NPOS;
+	}
+
+	const uint i = lower_bound(sv, pos);
+
+	return i < sv->indices.size ? *(const uint*)vec_get(&sv->indices, i) : VEC_NPOS;
+}
+
+void svec_from_vec(svector* sv, vector* vec)
+{
+	assert(sv != NULL);
+	assert(vec != NULL);
+	assert(vec->data_size == sv->data_size);
+
+	vec_clear(&sv->indices);
+	vec_destroy(&sv->values);
+	vec_init(&sv->values, sv->data_size);
+	sv->values.equal_func = sv->equal_func;
+
+	// Start dense so that the elements are counted with a single copy
+	vec_resize(&sv->values, vec->size);
+	if(vec->size > 0)
+	{
+		memcpy(sv->values.buffer, vec->buffer, vec->size* vec->data_size);
+	}
+
+	sv->dense = 1;
+	sv->size = vec->size;
+	sv->nnz = 0;
+
+	for(uint i = 0;i < sv->size;++i)
+	{
+		sv->nnz += !is_default(sv, (const char*)vec->buffer + i*sv->data_size);
+	}
+
+	if(sv->nnz <= sv->threshold* sv->size)
+	{
+		svec_sparsify(sv);
+	}
+}
+
+vector* svec_to_vec(svector* sv, vector* vec)
+{
+	assert(sv != NULL);
+	assert(vec != NULL);
+	assert(vec->data_size == sv->data_size);
+
+	if(sv->dense)
+	{
+		vec_resize(vec, sv->size);
+		if(sv->size > 0)
+		{
+			memcpy(vec->buffer, sv->values.buffer, sv->size* sv->data_size);
+		}
+		return vec;
+	}
+
+	const uint data_size = sv->data_size;
+	const uint* indices = sv->indices.buffer;
+	const char* src = sv->values.buffer;
+
+	vec_clear(vec);
+	vec_resize_val(vec, sv->size, sv->default_value);
+
+	char* dst = vec->buffer;
+
+	for(uint i = 0;i < sv->indices.size;++i)
+	{
+		memcpy(dst + indices[i]*data_size, src + i*data_size, data_size);
+	}
+
+	return vec;
+}
+
+// =========================== VALUE-TYPE SPECIALIZATIONS ===================================
+//
+// Kernels handle any default value d: x.y = d*sum(y) + sum((x[i]-d)*y[i]) over the stored elements
+//
+
+svector* svecf_create()
+{
+	svector* sv = (svector*)malloc(sizeof(svector));
+
+	svecf_init(sv);
+
+	return sv;
+}
+
+void svecf_init(svector* sv)
+{
+	svec_init(sv, sizeof(float), NULL);
+	sv->values.equal_func = (equal_function)floatcmp;
+	sv->equal_func = sv->values.equal_func;
+}
+
+float svecf_at(svector* sv, uint pos)
+{
+	return *(const float*)svec_at(sv, pos);
+}
+
+void svecf_replace(svector* sv, uint pos, float element)
+{
+	svec_replace(sv, pos, &element);
+}
+
+void svecf_push_back(svector* sv, float element)
+{
+	svec_push_back(sv, &element);
+}
+
+float svecf_dot(svector* x, vector* y)
+{
+	assert(x != NULL);
+	assert(y != NULL);
+	assert(x->size == y->size);
+
+	const float d = *(const float*)x->default_value;
+	const float* values = x->values.buffer;
+	const float* yv = y->buffer;
+	float result = 0.0f;
+
+	if(x->dense)
+	{
+		for(uint i = 0;i < x->size;++i)
+			result += values[i] * yv[i];
+
+		return result;
+	}
+
+	const uint* indices = x->indices.buffer;
+
+	if(d != 0.0f)
+	{
+		for(uint i = 0;i < y->size;++i)
+			result += d * yv[i];
+	}
+
+	for(uint i = 0;i < x->indices.size;++i)
+		result += (values[i] - d) * yv[indices[i]];
+
+	return result;
+}
+
+void svecf_axpy(float a, svector* x, vector* y)
+{
+	assert(x != NULL);
+	assert(y != NULL);
+	assert(x->size == y->size);
+
+	const float d = *(const float*)x->default_value;
+	const float* values = x->values.buffer;
+
+	if(y->size == 0)
+		return;
+
+	float* yv = vec_at(y, 0);
+
+	if(x->dense)
+	{
+		for(uint i = 0;i < x->size;++i)
+			yv[i] += a * values[i];
+
+		return;
+	}
+
+	const uint* indices = x->indices.buffer;
+
+	if(d != 0.0f)
+	{
+		for(uint i = 0;i < y->size;++i)
+			yv[i] += a * d;
+	}
+
+	for(uint i = 0;i < x->indices.size;++i)
+		yv[indices[i]] += a * (values[i] - d);
+}
+
+svector* svecd_create()
+{
+	svector* sv = (svector*)malloc(sizeof(svector));
+
+	svecd_init(sv);
+
+	return sv;
+}
+
+void svecd_init(svector* sv)
+{
+	svec_init(sv, sizeof(double), NULL);
+	sv->values.equal_func = (equal_function)doublecmp;
+	sv->equal_func = sv->values.equal_func;
+}
+
+double svecd_at(svector* sv, uint pos)
+{
+	return *(const double*)svec_at(sv, pos);
+}
+
+void svecd_replace(svector* sv, uint pos, double element)
+{
+	svec_replace(sv, pos, &element);
+}
+
+void svecd_push_back(svector* sv, double element)
+{
+	svec_push_back(sv, &element);
+}
+
+double svecd_dot(svector* x, vector* y)
+{
+	assert(x != NULL);
+	assert(y != NULL);
+	assert(x->size == y->size);
+
+	const double d = *(const double*)x->default_value;
+	const double* values = x->values.buffer;
+	const double* yv = y->buffer;
+	double result = 0.0;
+
+	if(x->dense)
+	{
+		for(uint i = 0;i < x->size;++i)
+			result += values[i] * yv[i];
+
+		return result;
+	}
+
+	const uint* indices = x->indices.buffer;
+
+	if(d != 0.0)
+	{
+		for(uint i = 0;i < y->size;++i)
+			result += d * yv[i];
+	}
+
+	for(uint i = 0;i < x->indices.size;++i)
+		result += (values[i] - d) * yv[indices[i]];
+
+	return result;
+}
+
+void svecd_axpy(double a, svector* x, vector* y)
+{
+	assert(x != NULL);
+	assert(y != NULL);
+	assert(x->size == y->size);
+
+	const double d = *(const double*)x->default_value;
+	const double* values = x->values.buffer;
+
+	if(y->size == 0)
+		return;
+
+	double* yv = vec_at(y, 0);
+
+	if(x->dense)
+	{
+		for(uint i = 0;i < x->size;++i)
+			yv[i] += a * values[i];
+
+		return;
+	}
+
+	const uint* indices = x->indices.buffer;
+
+	if(d != 0.0)
+	{
+		for(uint i = 0;i < y->size;++i)
+			yv[i] += a * d;
+	}
+
+	for(uint i = 0;i < x->indices.size;++i)
+		yv[indices[i]] += a * (values[i] - d);
+}
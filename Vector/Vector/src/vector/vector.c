@@ -1,7 +1,29 @@
-#include "vector\vector.h"
+// The accessors of inline.h are compiled here as normal functions, whatever the mode of the files that use them
+#undef VEC_HEADER_ONLY
+
+// For clock_gettime, hidden by -std=c11
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "vector/vector.h"
+#include "vector/registry.h"
 #include <stdlib.h>
+#include <stdio.h>
 #include <memory.h>
 #include <assert.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Statements that update the statistics of a vector, compiled out without VEC_STATS
+#ifdef VEC_STATS
+#define VEC_STAT(statement) statement
+#else
+#define VEC_STAT(statement)
+#endif
 
 void* alloc_buffer(uint size, uint count)
 {
@@ -13,6 +35,11 @@ void* realloc_buffer(void* old_buffer, uint old_size, uint new_size)
 	return realloc(old_buffer, new_size);
 }
 
+void free_buffer(void* buffer)
+{
+	free(buffer);
+}
+
 int equal_func(void* a, void* b, uint data_size)
 {
 	assert(a != NULL);
@@ -23,6 +50,167 @@ int equal_func(void* a, void* b, uint data_size)
 
 
 
+struct vec_storage
+{
+	void* buffer; // Start of the shared allocation
+	uint capacity; // Size of the shared allocation, in bytes
+	atomic_uint refs; // Number of vectors referencing this storage
+	free_function free_func; // Function used to free the shared allocation
+};
+
+// Drops a reference to a shared storage, freeing it when no vector uses it anymore. The release orders the reads
+// of this vector before the free, and the acquire orders the free after the reads of the other vectors
+static void storage_release(vec_storage* storage)
+{
+	if(atomic_fetch_sub_explicit(&storage->refs, 1, memory_order_acq_rel) == 1)
+	{
+		storage->free_func(storage->buffer);
+		free(storage);
+	}
+}
+
+// Allocates a new buffer of capacity bytes for the vector. Adopted buffers that can not be reallocated
+// (realloc_func is NULL) have a free_func that does not match alloc_func, so the vector switches to the default
+// allocator
+static void* vec_alloc_own(vector* vec, uint capacity)
+{
+	if(vec->realloc_func != NULL)
+		return vec->alloc_func(capacity, 1);
+
+	void* buffer = alloc_buffer(capacity, 1);
+
+	if(buffer != NULL)
+	{
+		vec->realloc_func = realloc_buffer;
+		vec->free_func = free_buffer;
+	}
+
+	return buffer;
+}
+
+// Gives the vector its own data storage, with room for at least capacity bytes
+static void vec_detach(vector* vec, uint capacity)
+{
+	vec_storage* storage = vec->storage;
+	const uint bytes = vec->size* vec->data_size;
+
+	vec->storage = NULL;
+
+	if(atomic_load_explicit(&storage->refs, memory_order_acquire) == 1 && storage->buffer == vec->buffer)
+	{
+		// This is the last vector using the storage, so it can take it back
+		vec->capacity = storage->capacity;
+		free(storage);
+		return;
+	}
+
+	if(capacity < bytes)
+		capacity = bytes;
+
+	void* buffer = capacity > 0 ? vec_alloc_own(vec, capacity) : NULL;
+	memcpy(buffer, vec->buffer, bytes);
+	storage_release(storage);
+
+	vec->buffer = buffer;
+	vec->capacity = capacity;
+	VEC_STAT(if(capacity > vec->stats.peak_capacity) vec->stats.peak_capacity = capacity);
+}
+
+static _Atomic(const vec_realloc_hook*) realloc_hook;
+
+// Time of a monotonic clock, in ns
+static unsigned long long now_ns()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+
+	const unsigned long long ticks = counter.QuadPart, rate = frequency.QuadPart;
+	return ticks / rate* 1000000000ULL + ticks % rate* 1000000000ULL / rate;
+#else
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (unsigned long long)time.tv_sec* 1000000000ULL + time.tv_nsec;
+#endif
+}
+
+// Changes the capacity of the buffer, which must be owned by the vector. Adopted buffers that can not be
+// reallocated (realloc_func is NULL) are moved to a buffer of the default allocator
+static void vec_realloc(vector* vec, uint capacity)
+{
+	const vec_realloc_hook* hook = atomic_load_explicit(&realloc_hook, memory_order_acquire);
+	const uint old_capacity = vec->capacity;
+	const unsigned long long start = hook != NULL ? now_ns() : 0;
+
+	VEC_STAT(++vec->stats.reallocs);
+	VEC_STAT(vec->stats.realloc_bytes += capacity);
+	VEC_STAT(if(capacity > vec->stats.peak_capacity) vec->stats.peak_capacity = capacity);
+
+	if(vec->realloc_func != NULL)
+	{
+		vec->buffer = vec->realloc_func(vec->buffer, vec->capacity, capacity);
+	}
+	else
+	{
+		const free_function free_func = vec->free_func;
+		void* buffer = vec_alloc_own(vec, capacity);
+
+		// Out of memory: the vector keeps its adopted buffer
+		assert(buffer != NULL);
+		if(buffer == NULL)
+			return;
+
+		memcpy(buffer, vec->buffer, vec->size* vec->data_size);
+		free_func(vec->buffer);
+		vec->buffer = buffer;
+	}
+
+	vec->capacity = capacity;
+
+	if(hook != NULL)
+	{
+		hook->func(vec, old_capacity, capacity, now_ns() - start, hook->ctx);
+	}
+}
+
+// Releases the buffer of the vector, leaving it empty
+static void vec_release_buffer(vector* vec)
+{
+	if(vec->storage != NULL)
+	{
+		storage_release(vec->storage);
+		vec->storage = NULL;
+	}
+	else if(vec->buffer != NULL)
+	{
+		vec->free_func(vec->buffer);
+	}
+
+	vec->buffer = NULL;
+	vec->size = 0;
+	vec->capacity = 0;
+}
+
+#ifdef VEC_REGISTRY
+// Copies the place in the registry and the tag of src to dst
+static void copy_registry(vector* dst, const vector* src)
+{
+	dst->tag = src->tag;
+	dst->registry_prev = src->registry_prev;
+	dst->registry_next = src->registry_next;
+}
+#endif
+
+// Must be called before modifying the elements of the vector
+void vec_own(vector* vec)
+{
+	if(vec->storage != NULL)
+	{
+		vec_detach(vec, vec->capacity);
+	}
+}
+
 vector* vec_create(uint data_size)
 {
 	vector* vec = (vector*)malloc(sizeof(vector));
@@ -36,7 +224,7 @@ void vec_free(vector* vec)
 {
 	assert(vec != NULL);
 
-	free(vec->buffer);
+	vec_destroy(vec);
 	free(vec);
 }
 
@@ -49,19 +237,40 @@ void vec_init(vector* vec, uint data_size)
 	vec->capacity = 0;
 	vec->alloc_func = alloc_buffer;
 	vec->realloc_func = realloc_buffer;
+	vec->free_func = free_buffer;
 	vec->equal_func = equal_func;
 	vec->buffer = NULL;
+	vec->storage = NULL;
+	VEC_STAT(memset(&vec->stats, 0, sizeof(vec_stats)));
+
+#ifdef VEC_REGISTRY
+	vec_registry_add(vec);
+#endif
+}
+
+void vec_destroy(vector* vec)
+{
+	assert(vec != NULL);
+
+	vec_release_buffer(vec);
+
+#ifdef VEC_REGISTRY
+	vec_registry_remove(vec);
+#endif
 }
 
 void vec_reserve(vector* vec, uint new_size)
 {
 	assert(vec != NULL);
 
-	if(new_size > vec->size)
+	if(vec->storage != NULL)
 	{
-		const uint new_capacity = new_size* vec->data_size;
-		vec->buffer = vec->realloc_func(vec->buffer, vec->capacity, new_capacity);
-		vec->capacity = new_capacity;
+		vec_detach(vec, new_size* vec->data_size);
+	}
+
+	if(new_size > vec_max_size(vec))
+	{
+		vec_realloc(vec, new_size* vec->data_size);
 	}
 }
 
@@ -79,17 +288,21 @@ void vec_resize_val(vector* vec, uint new_size, const void* val)
 	assert(vec != NULL);
 	assert(val != NULL);
 
-	const uint old_size = new_size;
+	const uint old_size = vec->size;
 
 	vec_resize(vec, new_size);
 
 	if(new_size > old_size)
 	{
 		const uint data_size = vec->data_size;
-		char* buffer = vec->buffer;
-		for(int i = old_size;i < new_size;++i)
+		char* buffer = (char*)vec->buffer + old_size*data_size;
+		const uint bytes = (new_size-old_size)*data_size;
+		memcpy(buffer, val, data_size);
+
+		// Each copy doubles the filled part
+		for(uint filled = data_size;filled < bytes;filled *= 2)
 		{
-			memcpy(buffer+i*data_size, val, data_size);
+			memcpy(buffer + filled, buffer, filled < bytes - filled ? filled : bytes - filled);
 		}
 	}
 }
@@ -101,7 +314,7 @@ uint vec_max_size(vector* vec)
 	return vec->capacity / vec->data_size;
 }
 
-int vec_empty(vector* vec)
+uint vec_empty(vector* vec)
 {
 	assert(vec != NULL);
 
@@ -112,78 +325,46 @@ void vec_shrink_to_fit(vector* vec)
 {
 	assert(vec != NULL);
 
+	if(vec->storage != NULL)
+	{
+		vec_detach(vec, 0);
+	}
+
 	if(vec->size < vec_max_size(vec))
 	{
-		const uint new_capacity = vec->size* vec->data_size;
-		vec->buffer = vec->realloc_func(vec->buffer, vec->capacity, new_capacity);
-		vec->capacity = new_capacity;
+		vec_realloc(vec, vec->size* vec->data_size);
 	}
 }
 
 uint vec_find(vector* vec, void* element, uint offset)
 {
 	assert(vec != NULL);
-	assert(offset < vec->size);
 
-	if(element == NULL)
-		return VEC_NPOS;
-
-	const uint size = vec->size;
-	const uint data_size = vec->data_size;
-	const uint limit = size * data_size;
-	const equal_function equal_func = vec->equal_func;
-	const char* buffer = vec->buffer;
-
-	for(uint i = offset*data_size;i < limit;i += data_size)
-	{
-		// printf("find %i...\n", i);
-		if(equal_func(buffer+i, element, data_size))
-		{
-			return i / data_size;
-		}
-	}
-
-	return VEC_NPOS;
+	return vec_view_find(vec_slice(vec, 0, vec->size), element, offset);
 }
 
 uint vec_find_last(vector* vec, void* element, uint offset)
 {
 	assert(vec != NULL);
-	assert(offset < vec->size);
-
-	if(element == NULL)
-		return VEC_NPOS;
-
-	const uint size = vec->size;
-	const uint data_size = vec->data_size;
-	const uint limit = size * data_size;
-	const equal_function equal_func = vec->equal_func;
-	const char* buffer = vec->buffer;
-
-	for(uint i = (size-1)*data_size - offset*data_size;i >= 0;i -= data_size)
-	{
-		if(equal_func(buffer+i, element, data_size))
-		{
-			return i / data_size;
-		}
-	}
 
-	return VEC_NPOS;
+	return vec_view_find_last(vec_slice(vec, 0, vec->size), element, offset);
 }
 
 uint vec_has(vector* vec, void* element)
 {
 	assert(vec != NULL);
 
-	return vec_find(vec, element, 0) != VEC_NPOS;
+	return vec_view_has(vec_slice(vec, 0, vec->size), element);
 }
 
-void* vec_at(vector* vec, uint pos)
+#include "vector/inline.h"
+
+const void* vec_get(vector* vec, uint pos)
 {
 	assert(vec != NULL);
 	assert(pos < vec->size);
 
-	return (char*)vec->buffer + pos* vec->data_size;
+	return (const char*)vec->buffer + pos* vec->data_size;
 }
 
 void* vec_at_cp(vector* vec, uint pos, void* element)
@@ -195,23 +376,11 @@ void* vec_at_cp(vector* vec, uint pos, void* element)
 	return memcpy(element, (char*)vec->buffer+pos*vec->data_size, vec->data_size);
 }
 
-void* vec_front(vector* vec)
-{
-	return vec_at(vec, 0);
-}
-
 void* vec_front_cp(vector* vec, void* element)
 {
 	return vec_at_cp(vec, 0, element);
 }
 
-void* vec_back(vector* vec)
-{
-	assert(vec != NULL);
-
-	return vec_at(vec, vec->size-1);
-}
-
 void* vec_back_cp(vector* vec, void* element)
 {
 	assert(vec != NULL);
@@ -219,13 +388,6 @@ void* vec_back_cp(vector* vec, void* element)
 	return vec_at_cp(vec, vec->size-1, element);
 }
 
-void vec_push_back(vector* vec, void* element)
-{
-	assert(vec != NULL);
-
-	vec_insert(vec, vec->size, element);
-}
-
 void vec_pop_back(vector* vec)
 {
 	assert(vec != NULL);
@@ -241,6 +403,12 @@ void vec_insert(vector* vec, uint pos, void* element)
 
 	const uint size = vec->size;
 	const uint offset = pos* vec->data_size;
+
+	if(vec->storage != NULL)
+	{
+		// Copied straight to the capacity it would grow to, instead of copied and then reallocated
+		vec_detach(vec, size < vec_max_size(vec) ? vec->capacity : (size > 0 ? size* 2 : 1)* vec->data_size);
+	}
 	
 	if(size == 0)
 	{
@@ -256,6 +424,7 @@ void vec_insert(vector* vec, uint pos, void* element)
 		// Shift buffer elements from pos to the right
 		memmove((char*)vec->buffer+(pos+1)*vec->data_size, (char*)vec->buffer+offset,
 			(size-pos)*vec->data_size);
+		VEC_STAT(vec->stats.moved_bytes += (size-pos)*vec->data_size);
 	}
 
 	memcpy((char*)vec->buffer+offset, element, vec->data_size);
@@ -280,9 +449,12 @@ void vec_erase(vector* vec, uint pos)
 
 	if(pos < vec->size-1)
 	{
+		vec_own(vec);
+
 		// Shift buffer elements from pos+1 to the left
 		memmove((char*)vec->buffer+pos*vec->data_size, (char*)vec->buffer+(pos+1)*vec->data_size,
-			(vec->size-pos+1)*vec->data_size);
+			(vec->size-pos-1)*vec->data_size);
+		VEC_STAT(vec->stats.moved_bytes += (vec->size-pos-1)*vec->data_size);
 	}
 
 	--vec->size;
@@ -296,9 +468,12 @@ void vec_erase_range(vector* vec, uint first, uint last)
 
 	if(last < vec->size)
 	{
+		vec_own(vec);
+
 		// Shift buffer elements from pos+1 to the left
 		memmove((char*)vec->buffer+first*vec->data_size, (char*)vec->buffer+(last)*vec->data_size,
 			(vec->size-last)*vec->data_size);
+		VEC_STAT(vec->stats.moved_bytes += (vec->size-last)*vec->data_size);
 	}
 
 	vec->size -= last-first;
@@ -308,6 +483,12 @@ void vec_clear(vector* vec)
 {
 	assert(vec != NULL);
 
+	if(vec->storage != NULL)
+	{
+		// No need to copy the data that is going to be discarded
+		vec_release_buffer(vec);
+	}
+
 	vec->size = 0;
 }
 
@@ -318,31 +499,7 @@ int vec_cmp(vector* v1, vector* v2)
 	if(v2 == NULL)
 		return v1->size;
 
-	if(v1->size != v2->size) 
-	{
-		return v1->size - v2->size;
-	}
-	
-	if(v1->data_size != v2->data_size)
-	{
-		return v1->data_size - v2->data_size;
-	}
-
-	const uint data_size = v1->data_size;
-	const uint limit = v1->size* data_size;
-	const equal_function equal_func = v1->equal_func;
-	const char* v1_buf = v1->buffer;
-	const char* v2_buf = v2->buffer;
-
-	for(uint i = 0;i < limit;i += data_size)
-	{
-		const uint cmp = equal_func(v1_buf+i, v2_buf+i, data_size);
-
-		if(cmp != 0)
-			return cmp;
-	}
-	
-	return 0;
+	return vec_view_cmp(vec_slice(v1, 0, v1->size), vec_slice(v2, 0, v2->size));
 }
 
 vector* vec_cpy(vector* v1, vector* v2, uint v1_off, uint count, uint v2_off)
@@ -352,8 +509,20 @@ vector* vec_cpy(vector* v1, vector* v2, uint v1_off, uint count, uint v2_off)
 	assert(v1_off < v1->size);
 	assert(count <= v1->size - v1_off);
 	assert(v2_off < v2->size);
+	assert(count <= v2->size - v2_off);
+
+	vec_own(v2);
+
+	char* dst = (char*)v2->buffer+v2_off*v2->data_size;
+	const char* src = (char*)v1->buffer+v1_off*v1->data_size;
+	const uint bytes = count*v1->data_size;
+
+	if(v1 == v2)
+		memmove(dst, src, bytes);
+	else
+		memcpy(dst, src, bytes);
 
-	memcpy((char*)v1->buffer+v1_off*v1->data_size, (char*)v2->buffer+v2_off*v2->data_size, count*v1->data_size);
+	return v2;
 }
 
 vector* vec_dup(vector* vec, uint offset, uint count)
@@ -362,17 +531,314 @@ vector* vec_dup(vector* vec, uint offset, uint count)
 	assert(offset < vec->size);
 	assert(count <= vec->size - offset);
 
+	if(vec->storage == NULL)
+	{
+		// From now on the buffer belongs to a storage shared by vec and its copies
+		vec_storage* storage = (vec_storage*)malloc(sizeof(vec_storage));
+		storage->buffer = vec->buffer;
+		storage->capacity = vec->capacity;
+		atomic_init(&storage->refs, 1);
+		storage->free_func = vec->free_func;
+		vec->storage = storage;
+	}
+
 	vector* copy = vec_create(vec->data_size);
-	vec_reserve(copy, vec_max_size(vec));
-	vec_cpy(vec, copy, 0, vec->size, 0);
+	copy->buffer = (char*)vec->buffer + offset* vec->data_size;
+	copy->size = count;
+	copy->capacity = count* vec->data_size;
 	copy->alloc_func = vec->alloc_func;
 	copy->realloc_func = vec->realloc_func;
+	copy->free_func = vec->free_func;
 	copy->equal_func = vec->equal_func;
-	copy->size = vec->size;
+	copy->storage = vec->storage;
+	// vec holds a reference, so the storage can not be freed meanwhile
+	atomic_fetch_add_explicit(&copy->storage->refs, 1, memory_order_relaxed);
 
 	return copy;
 }
 
+void vec_adopt(vector* vec, void* buffer, uint count, uint capacity, free_function free_func)
+{
+	assert(vec != NULL);
+	assert(count <= capacity);
+	assert(buffer != NULL || capacity == 0);
+
+	vec_release_buffer(vec);
+
+	vec->buffer = buffer;
+	vec->size = count;
+	vec->capacity = capacity* vec->data_size;
+	VEC_STAT(if(vec->capacity > vec->stats.peak_capacity) vec->stats.peak_capacity = vec->capacity);
+
+	if(free_func == NULL || free_func == free_buffer)
+	{
+		vec->realloc_func = realloc_buffer;
+		vec->free_func = free_buffer;
+	}
+	else
+	{
+		vec->realloc_func = NULL;
+		vec->free_func = free_func;
+	}
+}
+
+void* vec_release(vector* vec, uint* count)
+{
+	assert(vec != NULL);
+
+	vec_own(vec);
+
+	void* buffer = vec->buffer;
+
+	if(count != NULL)
+	{
+		*count = vec->size;
+	}
+
+	vec->buffer = NULL;
+	vec->size = 0;
+	vec->capacity = 0;
+
+	return buffer;
+}
+
+void vec_swap(vector* v1, vector* v2)
+{
+	assert(v1 != NULL);
+	assert(v2 != NULL);
+
+	const vector tmp = *v1;
+	*v1 = *v2;
+	*v2 = tmp;
+
+#ifdef VEC_REGISTRY
+	// Each vector keeps its place in the registry and its tag
+	copy_registry(v2, v1);
+	copy_registry(v1, &tmp);
+#endif
+}
+
+void vec_move(vector* dst, vector* src)
+{
+	assert(dst != NULL);
+	assert(src != NULL);
+
+	if(dst == src)
+		return;
+
+	vec_release_buffer(dst);
+
+#ifdef VEC_REGISTRY
+	const vector registered = *dst;
+	*dst = *src;
+	copy_registry(dst, &registered);
+#else
+	*dst = *src;
+#endif
+
+	src->buffer = NULL;
+	src->size = 0;
+	src->capacity = 0;
+	src->storage = NULL;
+}
+
+vec_stats vec_get_stats(vector* vec)
+{
+	assert(vec != NULL);
+
+	vec_stats stats;
+#ifdef VEC_STATS
+	stats = vec->stats;
+#else
+	memset(&stats, 0, sizeof(vec_stats));
+#endif
+	stats.slack = vec->capacity - vec->size* vec->data_size;
+
+	return stats;
+}
+
+void vec_reset_stats(vector* vec)
+{
+	assert(vec != NULL);
+
+	VEC_STAT(memset(&vec->stats, 0, sizeof(vec_stats)));
+	VEC_STAT(vec->stats.peak_capacity = vec->capacity);
+}
+
+void vec_set_realloc_hook(const vec_realloc_hook* hook)
+{
+	assert(hook == NULL || hook->func != NULL);
+
+	atomic_store_explicit(&realloc_hook, hook, memory_order_release);
+}
+
+static _Atomic(vec_check_handler) check_handler = vec_check_print;
+
+void vec_set_check_handler(vec_check_handler handler)
+{
+	atomic_store_explicit(&check_handler, handler, memory_order_relaxed);
+}
+
+void vec_check_print(const char* condition, const char* function)
+{
+	fprintf(stderr, "vector: check failed in %s: %s\n", function, condition);
+}
+
+void vec_check_failed(const char* condition, const char* function)
+{
+	const vec_check_handler handler = atomic_load_explicit(&check_handler, memory_order_relaxed);
+
+	if(handler != NULL)
+		handler(condition, function);
+}
+
+// =========================== VECTOR VIEWS ===================================
+
+vec_view vec_slice(vector* vec, uint offset, uint count)
+{
+	assert(vec != NULL);
+	assert(offset <= vec->size);
+	assert(count <= vec->size - offset);
+
+	vec_view view;
+	view.buffer = (const char*)vec->buffer + offset* vec->data_size;
+	view.data_size = vec->data_size;
+	view.size = count;
+	view.equal_func = vec->equal_func;
+
+	return view;
+}
+
+vec_view vec_view_from(const void* buffer, uint count, uint data_size)
+{
+	assert(buffer != NULL || count == 0);
+
+	vec_view view;
+	view.buffer = buffer;
+	view.data_size = data_size;
+	view.size = count;
+	view.equal_func = equal_func;
+
+	return view;
+}
+
+vec_view vec_view_slice(vec_view view, uint offset, uint count)
+{
+	assert(offset <= view.size);
+	assert(count <= view.size - offset);
+
+	view.buffer = (const char*)view.buffer + offset* view.data_size;
+	view.size = count;
+
+	return view;
+}
+
+uint vec_view_find(vec_view view, const void* element, uint offset)
+{
+	assert(offset < view.size);
+
+	if(element == NULL)
+		return VEC_NPOS;
+
+	const uint data_size = view.data_size;
+	const uint limit = view.size* data_size;
+	const equal_function equal_func = view.equal_func;
+	const char* buffer = view.buffer;
+
+	for(uint i = offset*data_size;i < limit;i += data_size)
+	{
+		if(equal_func((void*)(buffer+i), (void*)element, data_size))
+		{
+			return i / data_size;
+		}
+	}
+
+	return VEC_NPOS;
+}
+
+uint vec_view_find_last(vec_view view, const void* element, uint offset)
+{
+	assert(offset < view.size);
+
+	if(element == NULL)
+		return VEC_NPOS;
+
+	const uint data_size = view.data_size;
+	const equal_function equal_func = view.equal_func;
+	const char* buffer = view.buffer;
+
+	for(uint i = view.size-offset;i-- > 0;)
+	{
+		if(equal_func((void*)(buffer+i*data_size), (void*)element, data_size))
+		{
+			return i;
+		}
+	}
+
+	return VEC_NPOS;
+}
+
+uint vec_view_has(vec_view view, const void* element)
+{
+	return view.size > 0 && vec_view_find(view, element, 0) != VEC_NPOS;
+}
+
+const void* vec_view_at(vec_view view, uint pos)
+{
+	assert(pos < view.size);
+
+	return (const char*)view.buffer + pos* view.data_size;
+}
+
+void* vec_view_at_cp(vec_view view, uint pos, void* element)
+{
+	assert(pos < view.size);
+	assert(element != NULL);
+
+	return memcpy(element, (const char*)view.buffer + pos* view.data_size, view.data_size);
+}
+
+int vec_view_cmp(vec_view v1, vec_view v2)
+{
+	if(v1.size != v2.size) 
+	{
+		return v1.size - v2.size;
+	}
+	
+	if(v1.data_size != v2.data_size)
+	{
+		return v1.data_size - v2.data_size;
+	}
+
+	const uint data_size = v1.data_size;
+	const uint limit = v1.size* data_size;
+	const equal_function equal_func = v1.equal_func;
+	const char* v1_buf = v1.buffer;
+	const char* v2_buf = v2.buffer;
+
+	for(uint i = 0;i < limit;i += data_size)
+	{
+		if(!equal_func((void*)(v1_buf+i), (void*)(v2_buf+i), data_size))
+			return 1;
+	}
+	
+	return 0;
+}
+
+vector* vec_view_dup(vec_view view)
+{
+	vector* vec = vec_create(view.data_size);
+	vec->equal_func = view.equal_func;
+	vec_resize(vec, view.size);
+
+	if(view.size > 0)
+	{
+		memcpy(vec->buffer, view.buffer, view.size* view.data_size);
+	}
+
+	return vec;
+}
+
 // =========================== VECTOR VALUE-TYPE SPECIALIZATIONS ===================================
 // 
 // Function name types:
@@ -420,7 +886,7 @@ uint vecc_find(vector* vec, char element, uint offset)
 
 uint vecc_find_last(vector* vec, char element, uint offset)
 {
-	return vec_find_last(vec, element, offset);
+	return vec_find_last(vec, &element, offset);
 }
 
 uint vecc_has(vector* vec, char element)
@@ -428,14 +894,9 @@ uint vecc_has(vector* vec, char element)
 	return vec_has(vec, &element);
 }
 
-char* vecc_at(vector* vec, uint pos)
-{
-	return (char*)vec_at(vec, pos);
-}
-
 char vecc_at_cp(vector* vec, uint pos)
 {
-	return *vecc_at(vec, pos);
+	return *(const char*)vec_get(vec, pos);
 }
 
 char* vecc_front(vector* vec)
@@ -445,7 +906,7 @@ char* vecc_front(vector* vec)
 
 char vecc_front_cp(vector* vec)
 {
-	return *vecc_front(vec);
+	return *(const char*)vec_get(vec, 0);
 }
 
 char* vecc_back(vector* vec)
@@ -455,7 +916,7 @@ char* vecc_back(vector* vec)
 
 char vecc_back_cp(vector* vec)
 {
-	return *vecc_back(vec);
+	return *(const char*)vec_get(vec, vec->size-1);
 }
 
 void vecc_push_back(vector* vec, char element)
@@ -504,7 +965,7 @@ uint vecuc_find(vector* vec, unsigned char element, uint offset)
 
 uint vecuc_find_last(vector* vec, unsigned char element, uint offset)
 {
-	return vec_find_last(vec, element, offset);
+	return vec_find_last(vec, &element, offset);
 }
 
 uint vecuc_has(vector* vec, unsigned char element)
@@ -512,14 +973,9 @@ uint vecuc_has(vector* vec, unsigned char element)
 	return vec_has(vec, &element);
 }
 
-unsigned char* vecuc_at(vector* vec, uint pos)
-{
-	return (unsigned char*)vec_at(vec, pos);
-}
-
 unsigned char vecuc_at_cp(vector* vec, uint pos)
 {
-	return *vecuc_at(vec, pos);
+	return *(const unsigned char*)vec_get(vec, pos);
 }
 
 unsigned char* vecuc_front(vector* vec)
@@ -529,7 +985,7 @@ unsigned char* vecuc_front(vector* vec)
 
 unsigned char vecuc_front_cp(vector* vec)
 {
-	return *vecuc_front(vec);
+	return *(const unsigned char*)vec_get(vec, 0);
 }
 
 unsigned char* vecuc_back(vector* vec)
@@ -539,7 +995,7 @@ unsigned char* vecuc_back(vector* vec)
 
 unsigned char vecuc_back_cp(vector* vec)
 {
-	return *vecuc_back(vec);
+	return *(const unsigned char*)vec_get(vec, vec->size-1);
 }
 
 void vecuc_push_back(vector* vec, unsigned char element)
@@ -588,7 +1044,7 @@ uint vecs_find(vector* vec, short element, uint offset)
 
 uint vecs_find_last(vector* vec, short element, uint offset)
 {
-	return vec_find_last(vec, element, offset);
+	return vec_find_last(vec, &element, offset);
 }
 
 uint vecs_has(vector* vec, short element)
@@ -596,14 +1052,9 @@ uint vecs_has(vector* vec, short element)
 	return vec_has(vec, &element);
 }
 
-short* vecs_at(vector* vec, uint pos)
-{
-	return (short*)vec_at(vec, pos);
-}
-
 short vecs_at_cp(vector* vec, uint pos)
 {
-	return *vecs_at(vec, pos);
+	return *(const short*)vec_get(vec, pos);
 }
 
 short* vecs_front(vector* vec)
@@ -613,7 +1064,7 @@ short* vecs_front(vector* vec)
 
 short vecs_front_cp(vector* vec)
 {
-	return *vecs_front(vec);
+	return *(const short*)vec_get(vec, 0);
 }
 
 short* vecs_back(vector* vec)
@@ -623,7 +1074,7 @@ short* vecs_back(vector* vec)
 
 short vecs_back_cp(vector* vec)
 {
-	return *vecs_back(vec);
+	return *(const short*)vec_get(vec, vec->size-1);
 }
 
 void vecs_push_back(vector* vec, short element)
@@ -672,7 +1123,7 @@ uint vecus_find(vector* vec, unsigned short element, uint offset)
 
 uint vecus_find_last(vector* vec, unsigned short element, uint offset)
 {
-	return vec_find_last(vec, element, offset);
+	return vec_find_last(vec, &element, offset);
 }
 
 uint vecus_has(vector* vec, unsigned short element)
@@ -680,14 +1131,9 @@ uint vecus_has(vector* vec, unsigned short element)
 	return vec_has(vec, &element);
 }
 
-unsigned short* vecus_at(vector* vec, uint pos)
-{
-	return (unsigned short*)vec_at(vec, pos);
-}
-
 unsigned short vecus_at_cp(vector* vec, uint pos)
 {
-	return *vecus_at(vec, pos);
+	return *(const unsigned short*)vec_get(vec, pos);
 }
 
 unsigned short* vecus_front(vector* vec)
@@ -697,7 +1143,7 @@ unsigned short* vecus_front(vector* vec)
 
 unsigned short vecus_front_cp(vector* vec)
 {
-	return *vecus_front(vec);
+	return *(const unsigned short*)vec_get(vec, 0);
 }
 
 unsigned short* vecus_back(vector* vec)
@@ -707,7 +1153,7 @@ unsigned short* vecus_back(vector* vec)
 
 unsigned short vecus_back_cp(vector* vec)
 {
-	return *vecus_back(vec);
+	return *(const unsigned short*)vec_get(vec, vec->size-1);
 }
 
 void vecus_push_back(vector* vec, unsigned short element)
@@ -756,7 +1202,7 @@ uint veci_find(vector* vec, int element, uint offset)
 
 uint veci_find_last(vector* vec, int element, uint offset)
 {
-	return vec_find_last(vec, element, offset);
+	return vec_find_last(vec, &element, offset);
 }
 
 uint veci_has(vector* vec, int element)
@@ -764,14 +1210,9 @@ uint veci_has(vector* vec, int element)
 	return vec_has(vec, &element);
 }
 
-int* veci_at(vector* vec, uint pos)
-{
-	return (int*)vec_at(vec, pos);
-}
-
 int veci_at_cp(vector* vec, uint pos)
 {
-	return *veci_at(vec, pos);
+	return *(const int*)vec_get(vec, pos);
 }
 
 int* veci_front(vector* vec)
@@ -781,7 +1222,7 @@ int* veci_front(vector* vec)
 
 int veci_front_cp(vector* vec)
 {
-	return *veci_front(vec);
+	return *(const int*)vec_get(vec, 0);
 }
 
 int* veci_back(vector* vec)
@@ -791,7 +1232,7 @@ int* veci_back(vector* vec)
 
 int veci_back_cp(vector* vec)
 {
-	return *veci_back(vec);
+	return *(const int*)vec_get(vec, vec->size-1);
 }
 
 void veci_push_back(vector* vec, int element)
@@ -840,7 +1281,7 @@ uint vecui_find(vector* vec, unsigned int element, uint offset)
 
 uint vecui_find_last(vector* vec, unsigned int element, uint offset)
 {
-	return vec_find_last(vec, element, offset);
+	return vec_find_last(vec, &element, offset);
 }
 
 uint vecui_has(vector* vec, unsigned int element)
@@ -848,14 +1289,9 @@ uint vecui_has(vector* vec, unsigned int element)
 	return vec_has(vec, &element);
 }
 
-unsigned int* vecui_at(vector* vec, uint pos)
-{
-	return (unsigned int*)vec_at(vec, pos);
-}
-
 unsigned int vecui_at_cp(vector* vec, uint pos)
 {
-	return *vecui_at(vec, pos);
+	return *(const unsigned int*)vec_get(vec, pos);
 }
 
 unsigned int* vecui_front(vector* vec)
@@ -865,7 +1301,7 @@ unsigned int* vecui_front(vector* vec)
 
 unsigned int vecui_front_cp(vector* vec)
 {
-	return *vecui_front(vec);
+	return *(const unsigned int*)vec_get(vec, 0);
 }
 
 unsigned int* vecui_back(vector* vec)
@@ -875,7 +1311,7 @@ unsigned int* vecui_back(vector* vec)
 
 unsigned int vecui_back_cp(vector* vec)
 {
-	return *vecui_back(vec);
+	return *(const unsigned int*)vec_get(vec, vec->size-1);
 }
 
 void vecui_push_back(vector* vec, unsigned int element)
@@ -924,7 +1360,7 @@ uint vecl_find(vector* vec, long element, uint offset)
 
 uint vecl_find_last(vector* vec, long element, uint offset)
 {
-	return vec_find_last(vec, element, offset);
+	return vec_find_last(vec, &element, offset);
 }
 
 uint vecl_has(vector* vec, long element)
@@ -932,14 +1368,9 @@ uint vecl_has(vector* vec, long element)
 	return vec_has(vec, &element);
 }
 
-long* vecl_at(vector* vec, uint pos)
-{
-	return (long*)vec_at(vec, pos);
-}
-
 long vecl_at_cp(vector* vec, uint pos)
 {
-	return *vecl_at(vec, pos);
+	return *(const long*)vec_get(vec, pos);
 }
 
 long* vecl_front(vector* vec)
@@ -949,7 +1380,7 @@ long* vecl_front(vector* vec)
 
 long vecl_front_cp(vector* vec)
 {
-	return *vecl_front(vec);
+	return *(const long*)vec_get(vec, 0);
 }
 
 long* vecl_back(vector* vec)
@@ -959,7 +1390,7 @@ long* vecl_back(vector* vec)
 
 long vecl_back_cp(vector* vec)
 {
-	return *vecl_back(vec);
+	return *(const long*)vec_get(vec, vec->size-1);
 }
 
 void vecl_push_back(vector* vec, long element)
@@ -1008,7 +1439,7 @@ uint vecul_find(vector* vec, unsigned long element, uint offset)
 
 uint vecul_find_last(vector* vec, unsigned long element, uint offset)
 {
-	return vec_find_last(vec, element, offset);
+	return vec_find_last(vec, &element, offset);
 }
 
 uint vecul_has(vector* vec, unsigned long element)
@@ -1016,14 +1447,9 @@ uint vecul_has(vector* vec, unsigned long element)
 	return vec_has(vec, &element);
 }
 
-unsigned long* vecul_at(vector* vec, uint pos)
-{
-	return (unsigned long*)vec_at(vec, pos);
-}
-
 unsigned long vecul_at_cp(vector* vec, uint pos)
 {
-	return *vecul_at(vec, pos);
+	return *(const unsigned long*)vec_get(vec, pos);
 }
 
 unsigned long* vecul_front(vector* vec)
@@ -1033,7 +1459,7 @@ unsigned long* vecul_front(vector* vec)
 
 unsigned long vecul_front_cp(vector* vec)
 {
-	return *vecul_front(vec);
+	return *(const unsigned long*)vec_get(vec, 0);
 }
 
 unsigned long* vecul_back(vector* vec)
@@ -1043,7 +1469,7 @@ unsigned long* vecul_back(vector* vec)
 
 unsigned long vecul_back_cp(vector* vec)
 {
-	return *vecul_back(vec);
+	return *(const unsigned long*)vec_get(vec, vec->size-1);
 }
 
 void vecul_push_back(vector* vec, unsigned long element)
@@ -1100,14 +1526,9 @@ uint vecf_has(vector* vec, float element)
 	return vec_has(vec, &element);
 }
 
-float* vecf_at(vector* vec, uint pos)
-{
-	return (float*)vec_at(vec, pos);
-}
-
 float vecf_at_cp(vector* vec, uint pos)
 {
-	return *vecf_at(vec, pos);
+	return *(const float*)vec_get(vec, pos);
 }
 
 float* vecf_front(vector* vec)
@@ -1117,7 +1538,7 @@ float* vecf_front(vector* vec)
 
 float vecf_front_cp(vector* vec)
 {
-	return *vecf_front(vec);
+	return *(const float*)vec_get(vec, 0);
 }
 
 float* vecf_back(vector* vec)
@@ -1127,7 +1548,7 @@ float* vecf_back(vector* vec)
 
 float vecf_back_cp(vector* vec)
 {
-	return *vecf_back(vec);
+	return *(const float*)vec_get(vec, vec->size-1);
 }
 
 void vecf_push_back(vector* vec, float element)
@@ -1184,14 +1605,9 @@ uint vecd_has(vector* vec, double element)
 	return vec_has(vec, &element);
 }
 
-double* vecd_at(vector* vec, uint pos)
-{
-	return (double*)vec_at(vec, pos);
-}
-
 double vecd_at_cp(vector* vec, uint pos)
 {
-	return *vecd_at(vec, pos);
+	return *(const double*)vec_get(vec, pos);
 }
 
 double* vecd_front(vector* vec)
@@ -1201,7 +1617,7 @@ double* vecd_front(vector* vec)
 
 double vecd_front_cp(vector* vec)
 {
-	return *vecd_front(vec);
+	return *(const double*)vec_get(vec, 0);
 }
 
 double* vecd_back(vector* vec)
@@ -1211,7 +1627,7 @@ double* vecd_back(vector* vec)
 
 double vecd_back_cp(vector* vec)
 {
-	return *vecd_back(vec);
+	return *(const double*)vec_get(vec, vec->size-1);
 }
 
 void vecd_push_back(vector* vec, double element)
@@ -0,0 +1,406 @@
+#include "vector/zvector.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+
+typedef unsigned long long u64;
+
+#define SIGN_BIT 0x8000000000000000ULL
+
+// Converts an element to its unsigned key. Keys keep the order of the elements
+static u64 to_key(zvector* zv, const void* element)
+{
+	switch(zv->data_size)
+	{
+		case 1: return zv->is_signed ? (u64)(long long)*(const signed char*)element ^ SIGN_BIT : *(const unsigned char*)element;
+		case 2: return zv->is_signed ? (u64)(long long)*(const short*)element ^ SIGN_BIT : *(const unsigned short*)element;
+		case 4: return zv->is_signed ? (u64)(long long)*(const int*)element ^ SIGN_BIT : *(const unsigned int*)element;
+		default: return zv->is_signed ? *(const u64*)element ^ SIGN_BIT : *(const u64*)element;
+	}
+}
+
+// Converts count keys back to elements
+static void from_keys(zvector* zv, const u64* keys, uint count, void* elements)
+{
+	const u64 sign = zv->is_signed ? SIGN_BIT : 0;
+
+	switch(zv->data_size)
+	{
+		case 1:
+			for(uint i = 0;i < count;++i) ((unsigned char*)elements)[i] = (unsigned char)(keys[i] ^ sign);
+			break;
+		case 2:
+			for(uint i = 0;i < count;++i) ((unsigned short*)elements)[i] = (unsigned short)(keys[i] ^ sign);
+			break;
+		case 4:
+			for(uint i = 0;i < count;++i) ((unsigned int*)elements)[i] = (unsigned int)(keys[i] ^ sign);
+			break;
+		default:
+			for(uint i = 0;i < count;++i) ((u64*)elements)[i] = keys[i] ^ sign;
+			break;
+	}
+}
+
+static u64 bit_mask(uint bits)
+{
+	return bits == 64 ? ~0ULL : (1ULL << bits) - 1;
+}
+
+// Returns the packed value i of the block, relative to the block min.
+// Reading words[w+1] is always safe thanks to the padding word
+static u64 unpack(const u64* words, uint bits, uint i)
+{
+	const uint pos = i* bits;
+	const uint w = pos >> 6;
+	const uint shift = pos & 63;
+
+	// (x << 1) << (63-shift) is 0 when shift is 0, avoiding an undefined shift by 64
+	return ((words[w] >> shift) | ((words[w+1] << 1) << (63-shift))) & bit_mask(bits);
+}
+
+// Decodes all the keys of a block. Iterations are independent, so the compiler can vectorize the loop
+static void unpack_block(zvector* zv, const zvec_block* block, u64* keys)
+{
+	const u64* words = (const u64*)zv->words.buffer + block->offset;
+	const uint bits = block->bits;
+	const u64 min = block->min;
+
+	if(bits == 0)
+	{
+		for(uint i = 0;i < ZVEC_BLOCK_SIZE;++i) keys[i] = min;
+		return;
+	}
+
+	for(uint i = 0;i < ZVEC_BLOCK_SIZE;++i)
+	{
+		keys[i] = min + unpack(words, bits, i);
+	}
+}
+
+// Bit-packs the tail into a new block
+static void pack_tail(zvector* zv)
+{
+	zvec_block block;
+	block.min = zv->tail[0];
+	block.max = zv->tail[0];
+
+	for(uint i = 1;i < ZVEC_BLOCK_SIZE;++i)
+	{
+		if(zv->tail[i] < block.min) block.min = zv->tail[i];
+		if(zv->tail[i] > block.max) block.max = zv->tail[i];
+	}
+
+	u64 range = block.max - block.min;
+	block.bits = 0;
+	while(range != 0)
+	{
+		++block.bits;
+		range >>= 1;
+	}
+
+	// The padding word becomes the first word of the block
+	block.offset = zv->words.size - 1;
+
+	// ZVEC_BLOCK_SIZE * bits / 64 words, plus the new padding word
+	const uint nwords = block.bits* (ZVEC_BLOCK_SIZE / 64);
+	vec_resize(&zv->words, zv->words.size + nwords);
+
+	u64* words = (u64*)zv->words.buffer + block.offset;
+	memset(words, 0, (nwords+1)* sizeof(u64));
+
+	if(block.bits > 0)
+	{
+		for(uint i = 0;i < ZVEC_BLOCK_SIZE;++i)
+		{
+			const u64 value = zv->tail[i] - block.min;
+			const uint pos = i* block.bits;
+			const uint shift = pos & 63;
+
+			words[pos >> 6] |= value << shift;
+
+			if(shift + block.bits > 64)
+			{
+				words[(pos >> 6) + 1] |= value >> (64-shift);
+			}
+		}
+	}
+
+	vec_push_back(&zv->blocks, &block);
+}
+
+zvector* zvec_create(uint data_size, uint is_signed)
+{
+	zvector* zv = (zvector*)malloc(sizeof(zvector));
+
+	zvec_init(zv, data_size, is_signed);
+
+	return zv;
+}
+
+void zvec_free(zvector* zv)
+{
+	assert(zv != NULL);
+
+	zvec_destroy(zv);
+	free(zv);
+}
+
+void zvec_init(zvector* zv, uint data_size, uint is_signed)
+{
+	assert(zv != NULL);
+	assert(data_size == 1 || data_size == 2 || data_size == 4 || data_size == 8);
+
+	const u64 padding = 0;
+
+	vec_init(&zv->blocks, sizeof(zvec_block));
+	vec_init(&zv->words, sizeof(u64));
+	vec_push_back(&zv->words, (void*)&padding);
+	zv->size = 0;
+	zv->data_size = data_size;
+	zv->is_signed = is_signed;
+}
+
+void zvec_destroy(zvector* zv)
+{
+	assert(zv != NULL);
+
+	vec_destroy(&zv->blocks);
+	vec_destroy(&zv->words);
+	zv->size = 0;
+}
+
+uint zvec_size(zvector* zv)
+{
+	assert(zv != NULL);
+
+	return zv->size;
+}
+
+uint zvec_memory(zvector* zv)
+{
+	assert(zv != NULL);
+
+	return sizeof(zvector) + zv->blocks.capacity + zv->words.capacity;
+}
+
+void zvec_push_back(zvector* zv, const void* element)
+{
+	assert(zv != NULL);
+	assert(element != NULL);
+
+	zv->tail[zv->size % ZVEC_BLOCK_SIZE] = to_key(zv, element);
+
+	if(++zv->size % ZVEC_BLOCK_SIZE == 0)
+	{
+		pack_tail(zv);
+	}
+}
+
+void* zvec_at_cp(zvector* zv, uint pos, void* element)
+{
+	assert(zv != NULL);
+	assert(pos < zv->size);
+	assert(element != NULL);
+
+	const uint b = pos / ZVEC_BLOCK_SIZE;
+	u64 key;
+
+	if(b < zv->blocks.size)
+	{
+		const zvec_block* block = (const zvec_block*)vec_get(&zv->blocks, b);
+		const u64* words = (const u64*)zv->words.buffer + block->offset;
+		key = block->min + (block->bits > 0 ? unpack(words, block->bits, pos % ZVEC_BLOCK_SIZE) : 0);
+	}
+	else
+	{
+		key = zv->tail[pos % ZVEC_BLOCK_SIZE];
+	}
+
+	from_keys(zv, &key, 1, element);
+
+	return element;
+}
+
+uint zvec_find(zvector* zv, const void* element, uint offset)
+{
+	assert(zv != NULL);
+
+	if(element == NULL || offset >= zv->size)
+		return VEC_NPOS;
+
+	const u64 key = to_key(zv, element);
+	const uint nblocks = zv->blocks.size;
+
+	for(uint b = offset / ZVEC_BLOCK_SIZE;b < nblocks;++b)
+	{
+		const zvec_block* block = (const zvec_block*)vec_get(&zv->blocks, b);
+
+		if(key < block->min || key > block->max)
+			continue;
+
+		// Compare packed values directly, there is no need to add the min back
+		const u64* words = (const u64*)zv->words.buffer + block->offset;
+		const u64 packed = key - block->min;
+		const uint first = b* ZVEC_BLOCK_SIZE;
+
+		for(uint i = offset > first ? offset - first : 0;i < ZVEC_BLOCK_SIZE;++i)
+		{
+			if(block->bits == 0 || unpack(words, block->bits, i) == packed)
+			{
+				return first + i;
+			}
+		}
+	}
+
+	const uint first = nblocks* ZVEC_BLOCK_SIZE;
+
+	for(uint i = offset > first ? offset : first;i < zv->size;++i)
+	{
+		if(zv->tail[i - first] == key)
+		{
+			return i;
+		}
+	}
+
+	return VEC_NPOS;
+}
+
+uint zvec_has(zvector* zv, const void* element)
+{
+	return zvec_find(zv, element, 0) != VEC_NPOS;
+}
+
+uint zvec_decode(zvector* zv, uint pos, void* elements)
+{
+	assert(zv != NULL);
+	assert(pos % ZVEC_BLOCK_SIZE == 0);
+	assert(pos < zv->size);
+	assert(elements != NULL);
+
+	const uint b = pos / ZVEC_BLOCK_SIZE;
+
+	if(b == zv->blocks.size)
+	{
+		const uint count = zv->size - pos;
+		from_keys(zv, zv->tail, count, elements);
+		return count;
+	}
+
+	u64 keys[ZVEC_BLOCK_SIZE];
+	unpack_block(zv, (const zvec_block*)vec_get(&zv->blocks, b), keys);
+	from_keys(zv, keys, ZVEC_BLOCK_SIZE, elements);
+
+	return ZVEC_BLOCK_SIZE;
+}
+
+void zvec_append(zvector* zv, vector* vec)
+{
+	assert(zv != NULL);
+	assert(vec != NULL);
+	assert(vec->data_size == zv->data_size);
+
+	const char* buffer = vec->buffer;
+
+	for(uint i = 0;i < vec->size;++i)
+	{
+		zvec_push_back(zv, buffer + i* vec->data_size);
+	}
+}
+
+vector* zvec_to_vec(zvector* zv, vector* vec)
+{
+	assert(zv != NULL);
+	assert(vec != NULL);
+	assert(vec->data_size == zv->data_size);
+
+	vec_resize(vec, zv->size);
+
+	char* buffer = vec->buffer;
+
+	for(uint pos = 0;pos < zv->size;pos += ZVEC_BLOCK_SIZE)
+	{
+		zvec_decode(zv, pos, buffer + pos* zv->data_size);
+	}
+
+	return vec;
+}
+
+// =========================== VALUE-TYPE SPECIALIZATIONS ===================================
+
+zvector* zveci_create()
+{
+	return zvec_create(sizeof(int), 1);
+}
+
+void zveci_init(zvector* zv)
+{
+	zvec_init(zv, sizeof(int), 1);
+}
+
+void zveci_push_back(zvector* zv, int element)
+{
+	zvec_push_back(zv, &element);
+}
+
+int zveci_at(zvector* zv, uint pos)
+{
+	int element;
+	return *(int*)zvec_at_cp(zv, pos, &element);
+}
+
+uint zveci_find(zvector* zv, int element, uint offset)
+{
+	return zvec_find(zv, &element, offset);
+}
+
+zvector* zvecui_create()
+{
+	return zvec_create(sizeof(unsigned int), 0);
+}
+
+void zvecui_init(zvector* zv)
+{
+	zvec_init(zv, sizeof(unsigned int), 0);
+}
+
+void zvecui_push_back(zvector* zv, unsigned int element)
+{
+	zvec_push_back(zv, &element);
+}
+
+unsigned int zvecui_at(zvector* zv, uint pos)
+{
+	unsigned int element;
+	return *(unsigned int*)zvec_at_cp(zv, pos, &element);
+}
+
+uint zvecui_find(zvector* zv, unsigned int element, uint offset)
+{
+	return zvec_find(zv, &element, offset);
+}
+
+zvector* zvecul_create()
+{
+	return zvec_create(sizeof(unsigned long), 0);
+}
+
+void zvecul_init(zvector* zv)
+{
+	zvec_init(zv, sizeof(unsigned long), 0);
+}
+
+void zvecul_push_back(zvector* zv, unsigned long element)
+{
+	zvec_push_back(zv, &element);
+}
+
+unsigned long zvecul_at(zvector* zv, uint pos)
+{
+	unsigned long element;
+	return *(unsigned long*)zvec_at_cp(zv, pos, &element);
+}
+
+uint zvecul_find(zvector* zv, unsigned long element, uint offset)
+{
+	return zvec_find(zv, &element, offset);
+}
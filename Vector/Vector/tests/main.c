@@ -1,8 +1,37 @@
+// For fileno, pipe and setrlimit, hidden by -std=c11
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <vector/vector.h>
+#include <vector/zvector.h>
+#include <vector/svector.h>
+#include <vector/pvector.h>
+#include <vector/mpvector.h>
+#include <vector/cvector.h>
+#include <vector/queue.h>
+#include <vector/parallel.h>
+#include <vector/sharded.h>
+#include <vector/numa.h>
+#include <vector/io.h>
+#include <vector/mapped.h>
+#include <vector/loader.h>
+#include <vector/snapshot.h>
+#include <vector/parse.h>
+#include <vector/registry.h>
+#include <vector/histogram.h>
 #include <assert.h>
 #include <time.h>
+#include <threads.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
 
 // Simple tests and benchmarks
 
@@ -76,110 +105,1817 @@ void simple_test()
 	vec_free(vec);
 }
 
-void time_push_back(vector* vec, int n)
+int dup_task(void* arg)
 {
-	vec_clear(vec);
+	vector* dup = (vector*)arg;
+	int sum = 0;
+
+	for(uint i = 0;i < dup->size;++i)
+	{
+		sum += veci_at_cp(dup, i);
+	}
+
+	if(sum % 2 == 0)
+	{
+		veci_push_back(dup, 0);
+	}
+
+	vec_free(dup);
+
+	return sum;
+}
 
-	clock_t start = clock();
+void dup_test()
+{
+	int n = 100;
+
+	vector* vec = veci_create();
 
 	for(int i = 0;i < n;++i)
 	{
-		vecf_push_back(vec, i);
+		veci_push_back(vec, i);
 	}
 
-	clock_t end = clock();
+	vector* copy = vec_dup(vec, 0, vec->size);
+	vector* range = vec_dup(vec, 10, 20);
+
+	// Copies share the storage until they are modified
+	assert(copy->buffer == vec->buffer);
+	assert(range->size == 20);
+	assert(veci_at_cp(range, 0) == 10);
+	assert(veci_at_cp(range, 19) == 29);
+
+	veci_replace(copy, 0, -1);
+	assert(copy->buffer != vec->buffer);
+	assert(veci_at_cp(copy, 0) == -1);
+	assert(veci_at_cp(vec, 0) == 0);
 
-	printf("Push Back time: %f ms\n", (end-start) / (CLOCKS_PER_SEC / 1000.0));
+	// The shared range is copied once, straight to its grown capacity
+	veci_push_back(range, -2);
+	assert(range->size == 21 && range->capacity == 40* sizeof(int));
+#ifdef VEC_STATS
+	assert(vec_get_stats(range).reallocs == 0);
+#endif
+	assert(veci_at_cp(vec, 30) == 30);
+
+	vec_free(vec);
+	assert(veci_at_cp(copy, 1) == 1);
+	assert(veci_at_cp(range, 20) == -2);
+
+	vec_free(copy);
+	vec_free(range);
+
+	// Duplicates read, modified and freed by other threads while the source is freed
+	vec = veci_create();
+	veci_resize_val(vec, 10000, 1);
+	thrd_t threads[4];
+	for(int i = 0;i < 4;++i)
+	{
+		thrd_create(&threads[i], dup_task, vec_dup(vec, 0, vec->size));
+	}
+	vec_free(vec);
+	for(int i = 0;i < 4;++i)
+	{
+		int sum;
+		thrd_join(threads[i], &sum);
+		assert(sum == 10000);
+	}
 }
 
-void time_push(vector* vec, int n)
+void view_test()
 {
-	vec_clear(vec);
+	int n = 100;
 
-	clock_t start = clock();
+	vector* vec = veci_create();
 
 	for(int i = 0;i < n;++i)
 	{
-		vecf_insert(vec, 0, i);
+		veci_push_back(vec, i % 50);
 	}
 
-	clock_t end = clock();
+	vec_view view = vec_slice(vec, 25, 50);
+	int value = 30;
+
+	assert(view.size == 50);
+	assert(*(const int*)vec_view_at(view, 0) == 25);
+	assert(vec_view_find(view, &value, 0) == 5);
+	assert(vec_view_find_last(view, &value, 0) == 5);
+	value = 10;
+	assert(vec_view_find(view, &value, 0) == 35);
+	value = 24;
+	assert(vec_view_find_last(view, &value, 0) == 49);
+	assert(vec_view_has(view, &value));
+	value = 25;
+	assert(vec_view_find(vec_view_slice(view, 1, 49), &value, 0) == VEC_NPOS);
+
+	vector* copy = vec_view_dup(view);
+	assert(copy->size == 50);
+	assert(vec_view_cmp(vec_slice(copy, 0, copy->size), view) == 0);
+	assert(vec_cmp(copy, vec) != 0);
 
-	printf("Push time: %f ms\n", (end-start) / (CLOCKS_PER_SEC / 1000.0));
+	vec_free(copy);
+	vec_free(vec);
 }
 
-void time_find(vector* vec, int n)
+void zvector_test()
 {
-	clock_t start = clock();
+	int n = 10000;
+
+	zvector* zv = zveci_create();
 
 	for(int i = 0;i < n;++i)
 	{
-		if(vecf_find(vec, n/2, 0) == VEC_NPOS)
-		{
-			puts("ERROR");
-		}
+		zveci_push_back(zv, i % 3 == 0 ? -i : i* 7);
 	}
 
-	clock_t end = clock();
+	assert(zvec_size(zv) == n);
 
-	printf("Find time: %f ms\n", (end-start) / (CLOCKS_PER_SEC / 1000.0));
+	for(int i = 0;i < n;++i)
+	{
+		assert(zveci_at(zv, i) == (i % 3 == 0 ? -i : i* 7));
+	}
+
+	assert(zveci_find(zv, 70, 0) == 10);
+	assert(zveci_find(zv, -9999, 0) == 9999);
+	assert(zveci_find(zv, 5, 0) == VEC_NPOS);
+
+	vector vec;
+	veci_init(&vec);
+	zvec_to_vec(zv, &vec);
+	assert(vec.size == n);
+	assert(veci_at_cp(&vec, n-1) == -(n-1));
+	assert(veci_at_cp(&vec, 200) == 1400);
+
+	zvector* copy = zveci_create();
+	zvec_append(copy, &vec);
+	assert(zveci_at(copy, n-1) == -(n-1));
+	zvec_free(copy);
+
+	zvector* ids = zvecul_create();
+	zvecul_push_back(ids, 1UL << 31);
+	zvecul_push_back(ids, 0);
+	assert(zvecul_at(ids, 0) == 1UL << 31);
+	zvec_free(ids);
+
+	zvector* counters = zvecui_create();
+
+	for(int i = 0;i < n;++i)
+	{
+		zvecui_push_back(counters, 1000000 + i);
+	}
+
+	// Sorted values take a few bits each
+	assert(zvec_memory(counters) < n* sizeof(unsigned int) / 2);
+	assert(zvecui_find(counters, 1000000 + 5000, 0) == 5000);
+
+	vec_destroy(&vec);
+	zvec_free(counters);
+	zvec_free(zv);
 }
 
-void time_pop_back(vector* vec, int n)
+void svector_test()
 {
-	clock_t start = clock();
+	int n = 1000;
 
+	svector* sv = svecd_create();
+	svec_resize(sv, n);
+
+	for(int i = 0;i < n;i += 100)
+	{
+		svecd_replace(sv, i, i* 0.5);
+	}
+
+	assert(!sv->dense);
+	assert(sv->nnz == 9);
+	assert(svecd_at(sv, 200) == 100.0);
+	assert(svecd_at(sv, 201) == 0.0);
+	assert(svec_next(sv, 1) == 100);
+	assert(svec_next(sv, 901) == VEC_NPOS);
+
+	svecd_replace(sv, 200, 0.0);
+	assert(sv->nnz == 8);
+
+	vector y;
+	vecd_init(&y);
+	vecd_resize_val(&y, n, 2.0);
+
+	assert(svecd_dot(sv, &y) == 2.0* (2250-100));
+	svecd_axpy(2.0, sv, &y);
+	assert(vecd_at_cp(&y, 100) == 2.0 + 100.0);
+	assert(vecd_at_cp(&y, 101) == 2.0);
+
+	// Filling the vector switches it to dense mode
 	for(int i = 0;i < n;++i)
 	{
-		vec_pop_back(vec);
+		svecd_replace(sv, i, 1.0);
 	}
 
-	clock_t end = clock();
+	assert(sv->dense);
+	assert(sv->nnz == n);
+	assert(svecd_dot(sv, &y) == 2.0* n + 2.0* (2250-100));
 
-	printf("Pop Back time: %f ms\n", (end-start) / (CLOCKS_PER_SEC / 1000.0));
+	svec_from_vec(sv, &y);
+	assert(sv->dense);
+	svec_to_vec(sv, &y);
+	assert(y.size == n);
+
+	vec_destroy(&y);
+	svec_free(sv);
 }
 
-void time_pop(vector* vec, int n)
+void pvector_test()
 {
-	clock_t start = clock();
+	int n = 5000;
+
+	pvector* empty = pvec_create(sizeof(int));
+	pvector* builder = pvec_transient(empty);
+
+	for(int i = 0;i < n;++i)
+	{
+		pvec_tpush_back(builder, &i);
+	}
+
+	pvector* v1 = pvec_persistent(builder);
+	assert(pvec_size(v1) == n);
+
+	int value = -1;
+	pvector* v2 = pvec_replace(v1, 1234, &value);
+	pvector* v3 = pvec_push_back(v2, &value);
 
+	// Every version keeps its own elements
 	for(int i = 0;i < n;++i)
 	{
-		vec_erase(vec, 0);
+		assert(*(const int*)pvec_at(v1, i) == i);
+		assert(*(const int*)pvec_at(v2, i) == (i == 1234 ? -1 : i));
 	}
 
-	clock_t end = clock();
+	assert(pvec_size(v2) == n);
+	assert(pvec_size(v3) == n+1);
+	assert(pvec_find(v3, &value, 0) == 1234);
+	assert(pvec_find(v3, &value, 1235) == n);
+	assert(pvec_find(v1, &value, 0) == VEC_NPOS);
 
-	printf("Pop time: %f ms\n", (end-start) / (CLOCKS_PER_SEC / 1000.0));
+	pvec_free(v1);
+	pvec_free(v2);
+
+	vector vec;
+	veci_init(&vec);
+	pvec_to_vec(v3, &vec);
+	assert(vec.size == n+1);
+	assert(veci_at_cp(&vec, 1234) == -1);
+	assert(veci_at_cp(&vec, n-1) == n-1);
+
+	pvector* v4 = pvec_from_vec(&vec);
+	assert(pvec_size(v4) == n+1);
+	assert(*(const int*)pvec_at(v4, n) == -1);
+
+	vec_destroy(&vec);
+	pvec_free(v3);
+	pvec_free(v4);
+	pvec_free(empty);
 }
 
-int cmp_float(void* a, void* b, uint data_size)
+typedef struct push_task
 {
-	return *(float*)a == *(float*)b;
+	mpvector* mpv;
+	vector* vec;
+	mtx_t* mutex;
+	int first;
+	int count;
+} push_task;
+
+int mpvec_push_task(void* arg)
+{
+	push_task* task = arg;
+
+	for(int i = task->first;i < task->first + task->count;++i)
+	{
+		mpvec_push_back(task->mpv, &i);
+	}
+
+	return 0;
 }
 
-int main()
+int locked_push_task(void* arg)
 {
-	simple_test();
+	push_task* task = arg;
 
-	const int n = 100000;
+	for(int i = task->first;i < task->first + task->count;++i)
+	{
+		mtx_lock(task->mutex);
+		vec_push_back(task->vec, &i);
+		mtx_unlock(task->mutex);
+	}
+
+	return 0;
+}
+
+// Runs fn on nthreads threads, each one pushing n/nthreads elements. Returns the wall time in ms
+double run_push_tasks(thrd_start_t fn, mpvector* mpv, vector* vec, int nthreads, int n)
+{
+	thrd_t threads[64];
+	push_task tasks[64];
+	mtx_t mutex;
+	struct timespec start, end;
+
+	mtx_init(&mutex, mtx_plain);
+	timespec_get(&start, TIME_UTC);
+
+	for(int i = 0;i < nthreads;++i)
+	{
+		push_task task = { mpv, vec, &mutex, i* (n/nthreads), n/nthreads };
+		tasks[i] = task;
+		thrd_create(&threads[i], fn, &tasks[i]);
+	}
+
+	for(int i = 0;i < nthreads;++i)
+	{
+		thrd_join(threads[i], NULL);
+	}
+
+	timespec_get(&end, TIME_UTC);
+	mtx_destroy(&mutex);
+
+	return (end.tv_sec - start.tv_sec)* 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+}
+
+int mpvec_frees = 0;
+
+void count_mpvec_free(void* buffer)
+{
+	++mpvec_frees;
+	free(buffer);
+}
+
+void mpvector_test()
+{
+	int n = 64000;
+
+	mpvector* mpv = mpvec_create(sizeof(int));
+	run_push_tasks(mpvec_push_task, mpv, NULL, 8, n);
+
+	const uint committed = mpvec_commit(mpv);
+	assert(committed == n);
+	assert(mpvec_size(mpv) == n);
 
 	vector vec;
-	vecf_init(&vec);
+	veci_init(&vec);
+	mpvec_to_vec(mpv, &vec);
+
+	// Every pushed element is stored exactly once
+	int* seen = calloc(n, sizeof(int));
+	for(int i = 0;i < n;++i)
+	{
+		assert(*(const int*)mpvec_at(mpv, i) == veci_at_cp(&vec, i));
+		++seen[veci_at_cp(&vec, i)];
+	}
+	for(int i = 0;i < n;++i)
+	{
+		assert(seen[i] == 1);
+	}
+
+	free(seen);
+	vec_destroy(&vec);
+	mpvec_free(mpv);
+
+	// Segments are released with free_func, one per segment of 64, 128, 256, 512 and 1024 elements
+	mpv = mpvec_create(sizeof(int));
+	mpv->free_func = count_mpvec_free;
+	for(int i = 0;i < 1000;++i)
+	{
+		const uint pos = mpvec_push_back(mpv, &i);
+		assert(pos == i);
+	}
+	// Segments of 2^30 ints and flags are too big for a uint
+	atomic_store(&mpv->reserved, MPVEC_FIRST_SEGMENT* ((1U << 24) - 1));
+	const uint failed = mpvec_push_back(mpv, &n);
+	const uint published = mpvec_commit(mpv);
+	assert(failed == VEC_NPOS && published == 1000);
+	mpvec_free(mpv);
+	assert(mpvec_frees == 5);
+}
+
+typedef struct read_task
+{
+	cvector* cv;
+	uint reader;
+	atomic_int* done;
+} read_task;
+
+int cvec_read_task(void* arg)
+{
+	read_task* task = arg;
+
+	while(!atomic_load(task->done))
+	{
+		cvec_read_begin(task->cv, task->reader);
+
+		const uint size = cvec_size(task->cv);
+		for(uint i = 0;i < size;i += 7)
+		{
+			int value;
+			if(cvec_at_cp(task->cv, i, &value))
+			{
+				assert(value == i);
+			}
+		}
+
+		cvec_read_end(task->cv, task->reader);
+	}
+
+	return 0;
+}
+
+int cvec_frees = 0;
+
+void count_cvec_free(void* buffer)
+{
+	++cvec_frees;
+	free(buffer);
+}
+
+void cvector_test()
+{
+	int n = 100000;
+
+	cvector* cv = cvec_create(sizeof(int));
+	cv->free_func = count_cvec_free;
+	atomic_int done;
+	atomic_init(&done, 0);
 
-	time_push(&vec, n);
-	time_push_back(&vec, n);
-	time_find(&vec, n);
-	time_pop_back(&vec, n);
-	// We need to fill the vector again
+	thrd_t readers[4];
+	read_task tasks[4];
+
+	for(int i = 0;i < 4;++i)
+	{
+		read_task task = { cv, i, &done };
+		tasks[i] = task;
+		thrd_create(&readers[i], cvec_read_task, &tasks[i]);
+	}
+
+	// Reallocations and in-place writes happen while the readers scan
 	for(int i = 0;i < n;++i)
 	{
-		vecf_push_back(&vec, i);
+		cvec_push_back(cv, &i);
+		cvec_replace(cv, i / 2, &(int){ i / 2 });
+	}
+
+	atomic_store(&done, 1);
+
+	for(int i = 0;i < 4;++i)
+	{
+		thrd_join(readers[i], NULL);
+	}
+
+	int value = -1;
+	cvec_read_begin(cv, 0);
+	assert(cvec_size(cv) == n);
+	cvec_insert(cv, 10, &value);
+	assert(cvec_find(cv, &value, 0) == 10);
+	cvec_erase(cv, 10);
+	assert(cvec_at_cp(cv, 10, &value) && value == 10);
+	assert(!cvec_at_cp(cv, n, &value));
+	cvec_read_end(cv, 0);
+
+	// Inserting and erasing in the middle replaced the buffer twice
+	const int frees = cvec_frees;
+	cvec_reclaim(cv);
+	assert(cv->retired == NULL && cvec_frees == frees + 2);
+
+	cvec_free(cv);
+	assert(cvec_frees == frees + 3);
+}
+
+double elapsed_ms(struct timespec* start)
+{
+	struct timespec end;
+	timespec_get(&end, TIME_UTC);
+
+	return (end.tv_sec - start->tv_sec)* 1000.0 + (end.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+typedef struct queue_task
+{
+	void* queue;
+	void* reply;
+	int count;
+	atomic_llong* sum;
+} queue_task;
+
+int spsc_produce_task(void* arg)
+{
+	queue_task* task = arg;
+
+	for(int i = 0;i < task->count;++i)
+	{
+		while(!spsc_enqueue(task->queue, &i))
+			thrd_yield();
+	}
+
+	return 0;
+}
+
+int mpmc_produce_task(void* arg)
+{
+	queue_task* task = arg;
+
+	for(int i = 0;i < task->count;)
+	{
+		int batch[16];
+		int n = task->count - i < 16 ? task->count - i : 16;
+
+		for(int j = 0;j < n;++j)
+		{
+			batch[j] = i+j;
+		}
+
+		uint done = 0;
+		while(done < n)
+		{
+			done += mpmc_enqueue_batch(task->queue, batch + done, n - done);
+			if(done < n) thrd_yield();
+		}
+
+		i += n;
+	}
+
+	return 0;
+}
+
+int mpmc_consume_task(void* arg)
+{
+	queue_task* task = arg;
+	long long sum = 0;
+
+	for(int i = 0;i < task->count;)
+	{
+		int batch[16];
+		uint n = mpmc_dequeue_batch(task->queue, batch, task->count - i < 16 ? task->count - i : 16);
+
+		for(uint j = 0;j < n;++j)
+		{
+			sum += batch[j];
+		}
+
+		if(n == 0) thrd_yield();
+		i += n;
+	}
+
+	atomic_fetch_add(task->sum, sum);
+
+	return 0;
+}
+
+// Sends every message back through the reply queue
+int spsc_echo_task(void* arg)
+{
+	queue_task* task = arg;
+
+	for(int i = 0;i < task->count;++i)
+	{
+		int value;
+		while(!spsc_dequeue(task->queue, &value))
+			;
+		while(!spsc_enqueue(task->reply, &value))
+			;
+	}
+
+	return 0;
+}
+
+int queue_allocs = 0;
+
+void* count_queue_alloc(uint size, uint count)
+{
+	++queue_allocs;
+	return malloc(size* count);
+}
+
+void count_queue_free(void* buffer)
+{
+	--queue_allocs;
+	free(buffer);
+}
+
+void queue_test()
+{
+	spsc_queue* spsc = spsc_create(sizeof(int), 5);
+	int values[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+	int out[8];
+
+	uint count = spsc_enqueue_batch(spsc, values, 8);
+	assert(count == 8);
+	int done = spsc_enqueue(spsc, values);
+	assert(!done);
+	count = spsc_dequeue_batch(spsc, out, 5);
+	assert(count == 5 && out[4] == 4);
+	// Wraps around the end of the buffer
+	count = spsc_enqueue_batch(spsc, values, 4);
+	assert(count == 4);
+	assert(spsc_size(spsc) == 7);
+	count = spsc_dequeue_batch(spsc, out, 8);
+	assert(count == 7);
+	assert(out[2] == 7 && out[6] == 3);
+	done = spsc_dequeue(spsc, out);
+	assert(!done);
+	spsc_free(spsc);
+
+	// 2 producers and 2 consumers
+	const int n = 100000;
+	mpmc_queue* mpmc = mpmc_create(sizeof(int), 64);
+	atomic_llong sum;
+	atomic_init(&sum, 0);
+
+	thrd_t threads[4];
+	queue_task tasks[4];
+
+	for(int i = 0;i < 4;++i)
+	{
+		queue_task task = { mpmc, NULL, n, &sum };
+		tasks[i] = task;
+		thrd_create(&threads[i], i < 2 ? mpmc_produce_task : mpmc_consume_task, &tasks[i]);
+	}
+
+	for(int i = 0;i < 4;++i)
+	{
+		thrd_join(threads[i], NULL);
+	}
+
+	assert(atomic_load(&sum) == 2* (long long)n* (n-1) / 2);
+	done = mpmc_dequeue(mpmc, out);
+	assert(!done);
+	mpmc_free(mpmc);
+
+	// Buffers from the allocator hooks
+	spsc_queue local_spsc;
+	mpmc_queue local_mpmc;
+	spsc_init_alloc(&local_spsc, sizeof(int), 4, count_queue_alloc, count_queue_free);
+	mpmc_init_alloc(&local_mpmc, sizeof(int), 4, count_queue_alloc, count_queue_free);
+	done = spsc_enqueue(&local_spsc, values) && mpmc_enqueue(&local_mpmc, values);
+	assert(done && queue_allocs == 2);
+	spsc_destroy(&local_spsc);
+	mpmc_destroy(&local_mpmc);
+	assert(queue_allocs == 0);
+}
+
+// Squares of pos wrapped at 40000, which fit in an int
+void square_element(void* element, uint pos, void* ctx)
+{
+	const int value = (int)(pos % 40000);
+	*(int*)element = value* value;
+}
+
+// Copies ctx, 2 buffers of VEC_PARALLEL_COPY_MIN* 2 bytes, from inside a job of the default pool
+void copy_in_job(void* element, uint pos, void* ctx)
+{
+	char** buffers = (char**)ctx;
+
+	if(pos == 0)
+	{
+		vec_bulk_copy(buffers[1], buffers[0], VEC_PARALLEL_COPY_MIN* 2, 0);
+	}
+}
+
+void half_element(const void* src, void* dst, void* ctx)
+{
+	*(float*)dst = *(const int*)src / 2.0f;
+}
+
+void sum_element(void* acc, const void* element, void* ctx)
+{
+	*(long long*)acc += *(const int*)element;
+}
+
+void sum_partial(void* acc, const void* other, void* ctx)
+{
+	*(long long*)acc += *(const long long*)other;
+}
+
+typedef struct range_check
+{
+	atomic_uint* counts;
+	uint align;
+} range_check;
+
+void count_range(uint first, uint last, uint worker, void* ctx)
+{
+	range_check* check = ctx;
+
+	assert(first % check->align == 0);
+
+	for(uint i = first;i < last;++i)
+	{
+		atomic_fetch_add(&check->counts[i], 1);
+	}
+}
+
+void parallel_test()
+{
+	// Every element is visited exactly once, in aligned tasks
+	const uint count = 10007;
+	vec_pool* pool = vec_pool_create(4, 100);
+	atomic_uint* counts = malloc(count* sizeof(atomic_uint));
+	range_check check = { counts, 16 };
+
+	for(uint i = 0;i < count;++i)
+	{
+		atomic_init(&counts[i], 0);
+	}
+
+	vec_pool_run(pool, count, check.align, count_range, &check);
+	vec_pool_run(pool, count, check.align, count_range, &check);
+
+	for(uint i = 0;i < count;++i)
+	{
+		assert(atomic_load(&counts[i]) == 2);
 	}
-	time_pop(&vec, n);
 
-	free(vec.buffer);
+	free(counts);
+	vec_pool_free(pool);
+
+	vector* vec = veci_create();
+	veci_resize_val(vec, 100000, 0);
+	vector* shared = vec_dup(vec, 0, vec->size);
+
+	vec_parallel_for(vec, square_element, NULL);
+	assert(veci_at_cp(vec, 300) == 90000 && veci_at_cp(vec, 40300) == 90000);
+	// The copy is not modified
+	assert(veci_at_cp(shared, 300) == 0);
+
+	vector* halves = vecf_create();
+	vec_parallel_map(vec, halves, half_element, NULL);
+	assert(halves->size == 100000);
+	assert(vecf_at_cp(halves, 3) == 4.5f);
+
+	vec_resize(vec, 1000);
+	for(int i = 0;i < 1000;++i)
+	{
+		veci_replace(vec, i, i);
+	}
+
+	long long sum = 0;
+	vec_parallel_reduce(vec, &sum, sizeof(sum), sum_element, sum_partial, NULL);
+	assert(sum == 1000* 999 / 2);
+
+	vec_free(halves);
+	vec_free(shared);
+	vec_free(vec);
+
+	// Bulk fill with a pattern that is not a power of 2, and unaligned streaming copy
+	const uint bytes = 3* VEC_PARALLEL_COPY_MIN + 3;
+	char* src = malloc(bytes);
+	char* dst = malloc(bytes + 1);
+
+	memcpy(src, "abc", 3);
+	vec_bulk_fill(src, 3, bytes);
+	assert(src[bytes - 1] == 'c' && src[bytes / 2] == "abc"[(bytes / 2) % 3]);
+
+	vec_bulk_copy(dst + 1, src, bytes, 1);
+	assert(memcmp(dst + 1, src, bytes) == 0);
+
+	free(dst);
+	free(src);
+
+	// Bulk copies inside a job of the default pool run in the calling thread
+	char* buffers[2] = { calloc(VEC_PARALLEL_COPY_MIN* 2, 1), malloc(VEC_PARALLEL_COPY_MIN* 2) };
+	buffers[0][VEC_PARALLEL_COPY_MIN] = 1;
+	vector* one = veci_create();
+	veci_push_back(one, 0);
+	vec_parallel_for(one, copy_in_job, buffers);
+	assert(buffers[1][VEC_PARALLEL_COPY_MIN] == 1 && buffers[1][0] == 0);
+	vec_free(one);
+	free(buffers[1]);
+	free(buffers[0]);
+
+	vector* filled = veci_create();
+	veci_resize_val(filled, 1000000, 7);
+	veci_resize_val(filled, 1000005, 9);
+	assert(veci_at_cp(filled, 999999) == 7);
+	assert(veci_at_cp(filled, 1000004) == 9);
+	vec_free(filled);
+}
+
+typedef struct shard_task
+{
+	vec_sharded* sv;
+	uint shard;
+	int count;
+} shard_task;
+
+int shard_push_task(void* arg)
+{
+	shard_task* task = arg;
+
+	for(int i = 0;i < task->count;++i)
+	{
+		int value = task->shard* task->count + i;
+		vec_shard_push_back(task->sv, task->shard, &value);
+	}
+
+	return 0;
+}
+
+void sharded_test()
+{
+	const int n = 20000;
+	vec_sharded* sv = vec_shard_create(sizeof(int), 4);
+	vector* vec = veci_create();
+	thrd_t threads[4];
+	shard_task tasks[4];
+
+	// Each shard starts a cache line
+	assert((size_t)sv->shards % VEC_CACHE_LINE == 0 && sizeof(vec_shard) % VEC_CACHE_LINE == 0);
+
+	for(int round = 0;round < 2;++round)
+	{
+		for(uint i = 0;i < 4;++i)
+		{
+			shard_task task = { sv, i, n };
+			tasks[i] = task;
+			thrd_create(&threads[i], shard_push_task, &tasks[i]);
+		}
+
+		for(int i = 0;i < 4;++i)
+		{
+			thrd_join(threads[i], NULL);
+		}
+
+		assert(vec_shard_size(sv) == 4* n);
+
+		if(round == 0)
+		{
+			// Shard 0 elements, then shard 1 elements...
+			vec_shard_merge(sv, vec, 1);
+
+			for(int i = 0;i < 4* n;++i)
+			{
+				assert(veci_at_cp(vec, i) == i);
+			}
+		}
+		else
+		{
+			vec_shard_merge(sv, vec, 0);
+
+			long long sum = 0;
+			for(int i = 0;i < 4* n;++i)
+			{
+				sum += veci_at_cp(vec, i);
+			}
+
+			assert(sum == 4LL* n* (4* n - 1) / 2);
+		}
+
+		assert(vec->size == 4* n);
+		assert(vec_shard_size(sv) == 0);
+	}
+
+	vec_free(vec);
+	vec_shard_free(sv);
+}
+
+void numa_test()
+{
+	vector* vec = vecd_create();
+	vec_numa_use(vec);
+	vec_numa_set_policy(VEC_NUMA_INTERLEAVE, 0);
+
+	vecd_push_back(vec, 1.5);
+	// Big enough to use huge pages
+	vec_numa_resize(vec, VEC_HUGE_PAGE_SIZE);
+	assert(((size_t)vec->buffer & (VEC_HUGE_PAGE_SIZE - 1)) == 0);
+	assert(vecd_at_cp(vec, 0) == 1.5);
+	assert(vecd_at_cp(vec, VEC_HUGE_PAGE_SIZE - 1) == 0.0);
+
+	vec_shrink_to_fit(vec);
+	vec_resize(vec, 10);
+	vec_shrink_to_fit(vec);
+	assert(vecd_at_cp(vec, 0) == 1.5);
+
+	vec_numa_set_policy(VEC_NUMA_FIRST_TOUCH, 0);
+	vec_free(vec);
+}
+
+void io_test()
+{
+	vector* vec = veci_create();
+	vector* read = veci_create();
+
+	for(int i = 0;i < 1000;++i)
+	{
+		veci_push_back(vec, i* 3);
+	}
+
+	FILE* file = tmpfile();
+	vec_io_result result = vec_write(vec, file);
+	assert(result == VEC_IO_OK);
+	rewind(file);
+	result = vec_read(read, file);
+	assert(result == VEC_IO_OK);
+	assert(vec_cmp(vec, read) == 0);
+	assert(read->capacity == 1000* sizeof(int));
+
+	// Written with the other endianness: every field and element is a 4 bytes word
+	const long bytes = sizeof(vec_io_header) + 1000* sizeof(int);
+	unsigned char* data = malloc(bytes);
+	rewind(file);
+	const size_t blocks = fread(data, bytes, 1, file);
+	assert(blocks == 1);
+	for(long i = 0;i < bytes;i += 4)
+	{
+		unsigned char tmp = data[i];
+		data[i] = data[i+3];
+		data[i+3] = tmp;
+		tmp = data[i+1];
+		data[i+1] = data[i+2];
+		data[i+2] = tmp;
+	}
+	rewind(file);
+	fwrite(data, bytes, 1, file);
+	rewind(file);
+	result = vec_read(read, file);
+	assert(result == VEC_IO_OK);
+	assert(vec_cmp(vec, read) == 0);
+
+	// Corrupted element
+	data[sizeof(vec_io_header)] ^= 1;
+	rewind(file);
+	fwrite(data, bytes, 1, file);
+	rewind(file);
+	result = vec_read(read, file);
+	assert(result == VEC_IO_BAD_CHECKSUM);
+	free(data);
+	fclose(file);
+
+	// A count whose size in bytes overflows is rejected before anything is allocated
+	vec_io_header header = { VEC_IO_MAGIC, VEC_IO_VERSION, VEC_IO_ENDIANNESS, sizeof(int), 0x40000001, 0 };
+	file = tmpfile();
+	fwrite(&header, sizeof(header), 1, file);
+	rewind(file);
+	result = vec_read(read, file);
+	assert(result == VEC_IO_BAD_HEADER);
+	fclose(file);
+
+	// A count bigger than the data is not reserved
+	header.count = 0x3FFFFFFF;
+	file = tmpfile();
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(vec->buffer, sizeof(int), 10, file);
+	rewind(file);
+	result = vec_read(read, file);
+	assert(result == VEC_IO_EOF && read->size == 0 && read->capacity < 0x3FFFFFFF);
+	fclose(file);
+#ifndef _WIN32
+	// Pipes can not tell their size, so the vector only grows with the elements that arrive
+	int pipe_fds[2];
+	const int piped = pipe(pipe_fds);
+	assert(piped == 0);
+	long long written = write(pipe_fds[1], &header, sizeof(header));
+	written += write(pipe_fds[1], vec->buffer, 10* sizeof(int));
+	assert(written == sizeof(header) + 10* sizeof(int));
+	close(pipe_fds[1]);
+	result = vec_read_fd(read, pipe_fds[0]);
+	assert(result == VEC_IO_EOF && read->size == 0 && read->capacity <= (64U << 10));
+	close(pipe_fds[0]);
+#endif
+
+	// Stream of chunks through a file descriptor
+	file = tmpfile();
+	const int fd = fileno(file);
+	result = vec_write_fd(vec, fd);
+	assert(result == VEC_IO_OK);
+	result = vec_stream_begin(fd, sizeof(int));
+	assert(result == VEC_IO_OK);
+	for(uint i = 0;i < 1000;i += 300)
+	{
+		result = vec_stream_write(fd, vec, i, i + 300 <= 1000 ? 300 : 1000 - i);
+		assert(result == VEC_IO_OK);
+	}
+	result = vec_stream_end(fd);
+	assert(result == VEC_IO_OK);
+
+	rewind(file);
+	result = vec_read(read, file);
+	assert(result == VEC_IO_OK);
+	assert(vec_cmp(vec, read) == 0);
+	result = vec_read(read, file);
+	assert(result == VEC_IO_OK);
+	assert(vec_cmp(vec, read) == 0);
+	result = vec_read(read, file);
+	assert(result == VEC_IO_EOF);
+	fclose(file);
+
+	vec_free(read);
+	vec_free(vec);
+}
+
+void mapped_test()
+{
+	const char* path = "mapped_test.vec";
+	remove(path);
+
+	vector* vec = vec_open_mapped(path, sizeof(int), VEC_MAP_WRITE);
+#ifdef _WIN32
+	assert(vec == NULL);
+#else
+	assert(vec != NULL && vec->size == 0);
+	for(int i = 0;i < 10000;++i)
+	{
+		veci_push_back(vec, i);
+	}
+	vec_io_result result = vec_sync(vec);
+	assert(result == VEC_IO_OK);
+	result = vec_close_mapped(vec);
+	assert(result == VEC_IO_OK);
+
+	// The file can be read like any serialized vector
+	vector* read = veci_create();
+	FILE* file = fopen(path, "rb");
+	result = vec_read(read, file);
+	assert(result == VEC_IO_OK);
+	assert(read->size == 10000 && veci_at_cp(read, 9999) == 9999);
+	fclose(file);
+
+	vec = vec_open_mapped(path, sizeof(int), VEC_MAP_READ);
+	assert(vec_cmp(vec, read) == 0);
+	// Private modification, then the vector grows into memory
+	veci_replace(vec, 0, -1);
+	veci_push_back(vec, 10000);
+	assert(veci_at_cp(vec, 0) == -1 && veci_at_cp(vec, 10000) == 10000);
+	result = vec_close_mapped(vec);
+	assert(result == VEC_IO_OK);
+
+	vec = vec_open_mapped(path, sizeof(int), VEC_MAP_READ);
+	assert(vec_cmp(vec, read) == 0);
+	// Wrong element size
+	vector* wrong = vec_open_mapped(path, sizeof(double), VEC_MAP_READ);
+	assert(wrong == NULL);
+	result = vec_close_mapped(vec);
+	assert(result == VEC_IO_OK);
+
+	// The file can not grow past the limit, so the elements are moved to memory and the sync fails
+	struct rlimit limit, small;
+	getrlimit(RLIMIT_FSIZE, &limit);
+	small = limit;
+	small.rlim_cur = 1 << 16;
+	signal(SIGXFSZ, SIG_IGN);
+	setrlimit(RLIMIT_FSIZE, &small);
+	vec = vec_open_mapped(path, sizeof(int), VEC_MAP_WRITE);
+	assert(vec != NULL && vec_cmp(vec, read) == 0);
+	vec_reserve(vec, 1 << 16);
+	for(int i = 10000;i < 1 << 16;++i)
+	{
+		veci_push_back(vec, i);
+	}
+	assert(veci_at_cp(vec, 9999) == 9999 && veci_at_cp(vec, (1 << 16) - 1) == (1 << 16) - 1);
+	result = vec_sync(vec);
+	assert(result == VEC_IO_ERROR);
+	result = vec_close_mapped(vec);
+	assert(result == VEC_IO_ERROR);
+	setrlimit(RLIMIT_FSIZE, &limit);
+	signal(SIGXFSZ, SIG_DFL);
+
+	// The file still has the elements of the last sync
+	vec = vec_open_mapped(path, sizeof(int), VEC_MAP_READ);
+	assert(vec_cmp(vec, read) == 0);
+	result = vec_close_mapped(vec);
+	assert(result == VEC_IO_OK);
+
+	vec_free(read);
+	remove(path);
+#endif
+}
+
+int adopted_frees = 0;
+
+void free_adopted(void* buffer)
+{
+	++adopted_frees;
+	free(buffer);
+}
+
+int adopted_allocs = 0;
+
+void* count_adopted_alloc(uint size, uint count)
+{
+	++adopted_allocs;
+	return malloc(size* count);
+}
+
+void adopt_test()
+{
+	int* array = malloc(4* sizeof(int));
+	for(int i = 0;i < 3;++i)
+	{
+		array[i] = i;
+	}
+
+	vector* vec = veci_create();
+	vec_adopt(vec, array, 3, 4, NULL);
+	assert(vec->buffer == array);
+	veci_push_back(vec, 3);
+	assert(vec->buffer == array);
+	veci_push_back(vec, 4);
+	assert(veci_at_cp(vec, 4) == 4);
+
+	uint count;
+	int* released = vec_release(vec, &count);
+	assert(count == 5 && released[2] == 2 && vec->size == 0 && vec->buffer == NULL);
+
+	// Adopted buffer with its own free function, moved to a buffer of the default allocator when it grows
+	vec->alloc_func = count_adopted_alloc;
+	vec_adopt(vec, released, 5, 5, free_adopted);
+	veci_push_back(vec, 5);
+	assert(adopted_frees == 1 && adopted_allocs == 0);
+	assert(vec->realloc_func == realloc_buffer && vec->free_func == free_buffer);
+	assert(veci_at_cp(vec, 5) == 5 && veci_at_cp(vec, 0) == 0);
+
+	// Released from a shared storage
+	vector* dup = vec_dup(vec, 1, 2);
+	released = vec_release(dup, &count);
+	assert(count == 2 && released[0] == 1);
+	free(released);
+	vec_free(dup);
+
+	vector* other = veci_create();
+	veci_push_back(other, 42);
+	vec_swap(vec, other);
+	assert(vec->size == 1 && other->size == 6);
+	vec_move(vec, other);
+	assert(vec->size == 6 && other->size == 0 && other->buffer == NULL);
+	veci_push_back(other, 7);
+	assert(veci_at_cp(other, 0) == 7);
+
+	vec_free(other);
+	vec_free(vec);
+}
+
+void sum_chunk(vector* vec, const void* elements, uint count, void* ctx)
+{
+	for(uint i = 0;i < count;++i)
+	{
+		*(long long*)ctx += ((const int*)elements)[i];
+	}
+}
+
+void loader_test()
+{
+	const char* path = "loader_test.vec";
+	vector* vec = veci_create();
+
+	for(int i = 0;i < 100000;++i)
+	{
+		veci_push_back(vec, i);
+	}
+
+	FILE* file = fopen(path, "wb");
+	vec_io_result result = vec_write(vec, file);
+	assert(result == VEC_IO_OK);
+	fclose(file);
+
+	// Chunks that are not a multiple of the element size
+	vector* loaded = veci_create();
+	veci_push_back(loaded, -1);
+	result = vec_load(loaded, path, 1001, NULL, NULL);
+	assert(result == VEC_IO_OK);
+	assert(loaded->size == 100001 && veci_at_cp(loaded, 0) == -1 && veci_at_cp(loaded, 100000) == 99999);
+
+	long long sum = 0;
+	result = vec_load(loaded, path, 4096, sum_chunk, &sum);
+	assert(result == VEC_IO_OK);
+	assert(sum == 100000LL* 99999 / 2);
+
+	vector* doubles = vecd_create();
+	result = vec_load(doubles, path, 0, NULL, NULL);
+	assert(result == VEC_IO_BAD_HEADER);
+
+#ifndef _WIN32
+	// More elements than a vector can hold are rejected before reading
+	file = fopen(path, "rb");
+	result = vec_load_fd(loaded, fileno(file), 0, 8LL << 32, 0, NULL, NULL);
+	assert(result == VEC_IO_BAD_HEADER && loaded->size == 100001);
+	fclose(file);
+#endif
+
+	vec_free(doubles);
+	vec_free(loaded);
+	vec_free(vec);
+	remove(path);
+}
+
+void snapshot_test()
+{
+	vector* vec = vecf_create();
+	vector* read = vecf_create();
+
+	for(int i = 0;i < 100000;++i)
+	{
+		vecf_push_back(vec, i* 0.25f);
+	}
+
+	FILE* file = tmpfile();
+	vec_io_result result = vec_snapshot_write(vec, file);
+	assert(result == VEC_IO_OK);
+	// Shuffled floats compress well
+	assert(ftell(file) < (long)(vec->size* sizeof(float)) / 2);
+
+	rewind(file);
+	result = vec_snapshot_read(read, file);
+	assert(result == VEC_IO_OK);
+	assert(vec_cmp(vec, read) == 0);
+
+	// Range across 2 blocks
+	rewind(file);
+	result = vec_snapshot_read_range(read, file, 16000, 1000);
+	assert(result == VEC_IO_OK);
+	assert(read->size == 1000 && vecf_at_cp(read, 0) == 4000.0f && vecf_at_cp(read, 999) == 16999* 0.25f);
+
+	// Corrupted block
+	fseek(file, -100, SEEK_END);
+	fputc(fgetc(file) ^ 0x55, file);
+	rewind(file);
+	result = vec_snapshot_read(read, file);
+	assert(result == VEC_IO_BAD_CHECKSUM);
+
+	// Range out of the snapshot, and a block table that points out of the blocks
+	rewind(file);
+	result = vec_snapshot_read_range(read, file, 99000, 2000);
+	assert(result == VEC_IO_EOF);
+	const unsigned long long bad_offset = 1ULL << 40;
+	fseek(file, sizeof(vec_snapshot_header) + sizeof(vec_snapshot_block), SEEK_SET);
+	fwrite(&bad_offset, sizeof(bad_offset), 1, file);
+	rewind(file);
+	result = vec_snapshot_read(read, file);
+	assert(result == VEC_IO_BAD_HEADER);
+	fclose(file);
+
+	// Blocks much bigger than the elements, which only need buffers for the elements
+	const float single = 1.5f;
+	const vec_snapshot_header big_blocks = { VEC_SNAPSHOT_MAGIC, VEC_SNAPSHOT_VERSION, VEC_IO_ENDIANNESS, sizeof(float),
+		1, 1U << 29, 1 };
+	const vec_snapshot_block single_block = { 0, sizeof(float), vec_io_checksum(&single, sizeof(float), 0) };
+	file = tmpfile();
+	fwrite(&big_blocks, sizeof(big_blocks), 1, file);
+	fwrite(&single_block, sizeof(single_block), 1, file);
+	fwrite(&single, sizeof(single), 1, file);
+	rewind(file);
+	result = vec_snapshot_read(read, file);
+	assert(result == VEC_IO_OK && read->size == 1 && vecf_at_cp(read, 0) == single);
+	rewind(file);
+	result = vec_snapshot_read_range(read, file, 0, 1);
+	assert(result == VEC_IO_OK && read->size == 1 && vecf_at_cp(read, 0) == single);
+	fclose(file);
+
+	// Data that does not compress, and elements that are not a power of 2
+	vector* objects = vec_create(sizeof(object));
+	srand(1);
+	for(int i = 0;i < 5000;++i)
+	{
+		object obj = { rand(), rand() / 3.0, rand() };
+		vec_push_back(objects, &obj);
+	}
+	vector* read_objects = vec_create(sizeof(object));
+	file = tmpfile();
+	result = vec_snapshot_write(objects, file);
+	assert(result == VEC_IO_OK);
+	rewind(file);
+	result = vec_snapshot_read(read_objects, file);
+	assert(result == VEC_IO_OK);
+	assert(vec_cmp(objects, read_objects) == 0);
+	fclose(file);
+
+	vec_free(read_objects);
+	vec_free(objects);
+	vec_free(read);
+	vec_free(vec);
+}
+
+void shm_test()
+{
+#ifndef _WIN32
+	vector* producer = vec_shm_create(NULL, sizeof(int));
+	assert(producer != NULL);
+
+	for(int i = 0;i < 10;++i)
+	{
+		veci_push_back(producer, i);
+	}
+	vec_sync(producer);
+
+	vector* consumer = vec_shm_attach_fd(vec_shm_fd(producer), sizeof(int));
+	assert(consumer != NULL && consumer->size == 10 && veci_at_cp(consumer, 9) == 9);
+
+	// Growth is signaled through the generation counter
+	for(int i = 10;i < 10000;++i)
+	{
+		veci_push_back(producer, i);
+	}
+	assert(consumer->size == 10);
+	vec_sync(producer);
+	int changed = vec_shm_refresh(consumer);
+	assert(changed == 1);
+	assert(consumer->size == 10000 && veci_at_cp(consumer, 9999) == 9999);
+	changed = vec_shm_refresh(consumer);
+	assert(changed == 0);
+
+	// Shrinking keeps the storage consumers may be reading
+	vec_resize(producer, 100);
+	vec_shrink_to_fit(producer);
+	vec_sync(producer);
+	changed = vec_shm_refresh(consumer);
+	assert(changed == 0 && consumer->size == 100);
+
+	vec_close_mapped(consumer);
+	vec_close_mapped(producer);
+
+	// Named object
+	const char* name = "/vector_shm_test";
+	producer = vec_shm_create(name, sizeof(double));
+	if(producer != NULL)
+	{
+		vecd_push_back(producer, 2.5);
+		vec_sync(producer);
+		consumer = vec_shm_attach(name, sizeof(double));
+		assert(consumer != NULL && vecd_at_cp(consumer, 0) == 2.5);
+		vector* wrong = vec_shm_attach(name, sizeof(int));
+		assert(wrong == NULL);
+		vec_close_mapped(consumer);
+		vec_close_mapped(producer);
+		vec_shm_unlink(name);
+	}
+#endif
+}
+
+void parse_test()
+{
+	const char text[] = "1, -2,3\n 40;\t5\r\n2147483647 -2147483648";
+	vector* vec = veci_create();
+	uint parsed = veci_parse(vec, text, sizeof(text) - 1, 0);
+	assert(parsed == sizeof(text) - 1);
+	assert(vec->size == 7 && veci_at_cp(vec, 1) == -2 && veci_at_cp(vec, 3) == 40);
+	assert(veci_at_cp(vec, 5) == 2147483647 && veci_at_cp(vec, 6) == -2147483647 - 1);
+
+	// Overflows and invalid tokens stop parsing, and values are appended
+	parsed = veci_parse(vec, "8 2147483648 9", 14, 0);
+	assert(parsed == 2 && vec->size == 8);
+	parsed = veci_parse(vec, "7 x", 3, 0);
+	assert(parsed == 2 && vec->size == 9);
+	vec_free(vec);
+
+	vec = vec_create(sizeof(unsigned long));
+	parsed = vecul_parse(vec, "18446744073709551615 0", 22, 0);
+	assert(parsed == 22 || sizeof(unsigned long) < 8);
+	parsed = vecul_parse(vec, "-1", 2, 0);
+	assert(parsed == 0);
+	vec_free(vec);
+
+	// Fast path and strtod fallback give the same values as strtod
+	const char* numbers[] = { "0.1", "-3.25", "1e22", "1e23", "12345678901234567890", "2.2250738585072014e-308", "inf", "0.30000000000000004" };
+	vector* doubles = vecd_create();
+	vector* floats = vecf_create();
+	for(uint i = 0;i < sizeof(numbers) / sizeof(numbers[0]);++i)
+	{
+		const uint length = (uint)strlen(numbers[i]);
+		parsed = vecd_parse(doubles, numbers[i], length, 0);
+		assert(parsed == length);
+		parsed = vecf_parse(floats, numbers[i], length, 0);
+		assert(parsed == length);
+		assert(vecd_at_cp(doubles, i) == strtod(numbers[i], NULL));
+		assert(vecf_at_cp(floats, i) == strtof(numbers[i], NULL));
+	}
+	parsed = vecd_parse(doubles, "1.5.2", 5, 0);
+	assert(parsed == 0);
+	// A text ending with the exponent marker is not read past its end
+	char* exponent_end = malloc(4);
+	memcpy(exponent_end, "1.5e", 4);
+	parsed = vecd_parse(doubles, exponent_end, 4, 0);
+	assert(parsed == 0);
+	free(exponent_end);
+	vec_free(floats);
+	vec_free(doubles);
+
+	// Parallel parsing keeps the order, also with tokens split by chunk boundaries
+	const uint count = 1000000;
+	vector* text_vec = vec_create(1);
+	for(uint i = 0;i < count;++i)
+	{
+		char number[16];
+		const int length = sprintf(number, i % 10 == 9 ? "%u\n" : "%u,", i);
+		for(int j = 0;j < length;++j)
+		{
+			vec_push_back(text_vec, &number[j]);
+		}
+	}
+	const char* big = (const char*)text_vec->buffer;
+	vec = veci_create();
+	veci_push_back(vec, -1);
+	parsed = veci_parse(vec, big, text_vec->size, 1);
+	assert(parsed == text_vec->size);
+	assert(vec->size == count + 1);
+	for(uint i = 0;i < count;++i)
+	{
+		assert(veci_at_cp(vec, i + 1) == (int)i);
+	}
+
+	// Only the values before the first invalid token are kept
+	vec_clear(vec);
+	char* bad = (char*)vec_at(text_vec, text_vec->size / 2);
+	while(*bad != ',' && *bad != '\n')
+		++bad;
+	*(bad + 1) = 'x';
+	const uint error = (uint)(bad + 1 - big);
+	parsed = veci_parse(vec, big, text_vec->size, 1);
+	assert(parsed == error);
+	assert(vec->size < count && veci_at_cp(vec, vec->size - 1) == vec->size - 1);
+	vec_free(vec);
+	vec_free(text_vec);
+}
+
+void stats_test()
+{
+	vector* vec = veci_create();
+	veci_resize_val(vec, 10, 1);
+	vec_reserve(vec, 16);
+
+	vec_stats stats = vec_get_stats(vec);
+	assert(stats.slack == 6* sizeof(int));
+
+#ifdef VEC_STATS
+	assert(stats.reallocs == 2 && stats.realloc_bytes == 26* sizeof(int));
+	assert(stats.peak_capacity == 16* sizeof(int) && stats.moved_bytes == 0);
+
+	veci_insert(vec, 0, 0);
+	vec_erase(vec, 10);
+	vec_erase_range(vec, 0, 2);
+	stats = vec_get_stats(vec);
+	assert(stats.moved_bytes == (10 + 0 + 8)* sizeof(int));
+
+	vec_shrink_to_fit(vec);
+	stats = vec_get_stats(vec);
+	assert(stats.reallocs == 3 && stats.peak_capacity == 16* sizeof(int) && stats.slack == 0);
+
+	vec_reset_stats(vec);
+	stats = vec_get_stats(vec);
+	assert(stats.reallocs == 0 && stats.moved_bytes == 0 && stats.peak_capacity == 8* sizeof(int));
+#else
+	assert(stats.reallocs == 0 && stats.peak_capacity == 0);
+#endif
+
+	vec_free(vec);
+}
+
+void registry_test()
+{
+	const uint count = vec_registry_count();
+	vector* a = veci_create();
+	vector* b = veci_create();
+	vec_set_tag(a, "registry_test");
+	vec_set_tag(b, "registry_test");
+	veci_resize_val(a, 1000, 1);
+	vec_reserve(b, 4000);
+	veci_push_back(b, 1);
+
+	char text[4096];
+	FILE* file = tmpfile();
+	vec_report(file, VEC_REPORT_JSON, 4);
+	rewind(file);
+	text[fread(text, 1, sizeof(text) - 1, file)] = '\0';
+	fclose(file);
+
+#ifdef VEC_REGISTRY
+	assert(vec_registry_count() == count + 2);
+	assert(strstr(text, "{\"tag\": \"registry_test\", \"vectors\": 2, \"size_bytes\": 4004, \"capacity_bytes\": 20000") != NULL);
+
+	// Swapping and moving keep each vector in the registry with its tag
+	vector c;
+	veci_init(&c);
+	vec_swap(a, &c);
+	assert(vec_get_tag(a) != NULL && vec_get_tag(&c) == NULL && c.size == 1000);
+	vec_move(a, &c);
+	vec_destroy(&c);
+	assert(vec_registry_count() == count + 2 && a->size == 1000);
+
+	// Only the vectors of tags over their budget are shrunk
+	vec_set_budget("registry_test", 30000);
+	unsigned long long released = vec_registry_enforce();
+	assert(released == 0);
+	vec_set_budget("registry_test", 8000);
+	released = vec_registry_enforce();
+	assert(released == 16000 - sizeof(int));
+	assert(b->capacity == sizeof(int) && a->size == 1000);
+	vec_set_budget("registry_test", 0);
+#else
+	assert(vec_registry_count() == 0 && strstr(text, "\"vectors\": 0") != NULL);
+#endif
+
+	vec_free(b);
+	vec_free(a);
+	assert(vec_registry_count() == count);
+
+	// Typed sparse vectors register their vectors once
+	svector* sv = svecf_create();
+	svec_free(sv);
+	assert(vec_registry_count() == count);
+}
+
+typedef struct last_realloc
+{
+	uint count;
+	uint old_capacity;
+	uint new_capacity;
+} last_realloc;
+
+void record_realloc(vector* vec, uint old_capacity, uint new_capacity, unsigned long long ns, void* ctx)
+{
+	last_realloc* last = (last_realloc*)ctx;
+	++last->count;
+	last->old_capacity = old_capacity;
+	last->new_capacity = new_capacity;
+}
+
+void hist_test()
+{
+	vec_histogram* h = vec_histogram_create();
+	assert(vec_histogram_count(h) == 0 && vec_histogram_percentile(h, 50) == 0);
+
+	for(uint i = 1;i <= 1000;++i)
+	{
+		vec_histogram_record(h, i);
+	}
+
+	// Buckets are at most 1/32 wide
+	const unsigned long long p50 = vec_histogram_percentile(h, 50);
+	assert(vec_histogram_count(h) == 1000 && vec_histogram_mean(h) == 500.5);
+	assert(p50 >= 500 && p50 <= 500 + 500 / 32);
+	assert(vec_histogram_percentile(h, 100) == 1000 && vec_histogram_max(h) == 1000);
+	assert(vec_histogram_percentile(h, 1) == 10);
+	vec_histogram_record(h, ~0ULL);
+	assert(vec_histogram_percentile(h, 100) == ~0ULL);
+	vec_histogram_reset(h);
+	assert(vec_histogram_count(h) == 0 && vec_histogram_max(h) == 0);
+	vec_histogram_free(h);
+
+	last_realloc last = {0};
+	vec_realloc_hook hook = { record_realloc, &last };
+	vector* vec = veci_create();
+	const uint capacity = vec->capacity;
+	vec_set_realloc_hook(&hook);
+	vec_reserve(vec, 100);
+	assert(last.count == 1 && last.old_capacity == capacity && last.new_capacity == 100* sizeof(int));
+	vec_shrink_to_fit(vec);
+	assert(last.count == 2 && last.new_capacity == 0);
+
+	h = vec_track_reallocs();
+	const unsigned long long count = vec_histogram_count(h);
+	vec_reserve(vec, 1000);
+	assert(last.count == 2 && vec_histogram_count(h) == count + 1);
+	vec_set_realloc_hook(NULL);
+	vec_reserve(vec, 2000);
+	assert(vec_histogram_count(h) == count + 1);
+	vec_free(vec);
+}
+
+int failed_checks = 0;
+
+void count_failed_check(const char* condition, const char* function)
+{
+	++failed_checks;
+}
+
+void accessors_test()
+{
+	vector* vec = veci_create();
+	vec_reserve(vec, 4);
+
+	for(int i = 0;i < 5;++i)
+	{
+		veci_push_back(vec, i);
+	}
+
+	assert(vec->size == 5 && *veci_at(vec, 4) == 4 && *(int*)vec_front(vec) == 0 && *(int*)vec_back(vec) == 4);
+
+	// Pushing to and writing a shared storage copies it first
+	vector* dup = vec_dup(vec, 0, vec->size);
+	int value = 5;
+	vec_push_back(dup, &value);
+	*veci_at(dup, 0) = 10;
+	assert(dup->size == 6 && veci_at_cp(vec, 0) == 0 && vec->size == 5);
+
+#if VEC_BOUNDS_CHECK == VEC_CHECK_ALWAYS
+	vec_set_check_handler(count_failed_check);
+	assert(vec_at(vec, 5) == NULL && veci_at(vec, VEC_NPOS) == NULL);
+	vec_push_back(vec, NULL);
+	assert(failed_checks == 3 && vec->size == 5);
+	vec_clear(vec);
+	assert(vec_front(vec) == NULL && vec_back(vec) == NULL && vec->size == 0);
+	assert(failed_checks == 5);
+	vec_set_check_handler(vec_check_print);
+#endif
+
+	vec_free(dup);
+	vec_free(vec);
+}
+
+void time_queues(int n)
+{
+	struct timespec start;
+	thrd_t producer, consumer;
+	atomic_llong sum;
+	atomic_init(&sum, 0);
+
+	// SPSC throughput
+	spsc_queue* spsc = spsc_create(sizeof(int), 1024);
+	queue_task task = { spsc, NULL, n, &sum };
+
+	timespec_get(&start, TIME_UTC);
+	thrd_create(&producer, spsc_produce_task, &task);
+	for(int i = 0;i < n;++i)
+	{
+		int value;
+		while(!spsc_dequeue(spsc, &value))
+			thrd_yield();
+	}
+	thrd_join(producer, NULL);
+	double ms = elapsed_ms(&start);
+
+	printf("SPSC queue throughput: %f Mops/s\n", n / ms / 1000.0);
+
+	// SPSC round-trip latency
+	const int round_trips = n / 1000;
+	spsc_queue* reply = spsc_create(sizeof(int), 16);
+	queue_task echo = { spsc, reply, round_trips, &sum };
+
+	thrd_create(&consumer, spsc_echo_task, &echo);
+	timespec_get(&start, TIME_UTC);
+	for(int i = 0;i < round_trips;++i)
+	{
+		int value;
+		while(!spsc_enqueue(spsc, &i))
+			;
+		while(!spsc_dequeue(reply, &value))
+			;
+	}
+	ms = elapsed_ms(&start);
+	thrd_join(consumer, NULL);
+
+	printf("SPSC queue round-trip latency: %f ns\n", ms* 1000000.0 / round_trips);
+
+	spsc_free(reply);
+	spsc_free(spsc);
+
+	// MPMC throughput, batches of 16 elements
+	mpmc_queue* mpmc = mpmc_create(sizeof(int), 1024);
+	queue_task mpmc_task = { mpmc, NULL, n, &sum };
+
+	timespec_get(&start, TIME_UTC);
+	thrd_create(&producer, mpmc_produce_task, &mpmc_task);
+	thrd_create(&consumer, mpmc_consume_task, &mpmc_task);
+	thrd_join(producer, NULL);
+	thrd_join(consumer, NULL);
+	ms = elapsed_ms(&start);
+
+	printf("MPMC queue throughput: %f Mops/s\n", n / ms / 1000.0);
+
+	mpmc_free(mpmc);
+}
+
+void time_parallel_map(int n)
+{
+	vector* src = veci_create();
+	vector* dst = vecf_create();
+	struct timespec start;
+
+	vec_resize(src, n);
+	for(int i = 0;i < n;++i)
+	{
+		*veci_at(src, i) = i;
+	}
+
+	timespec_get(&start, TIME_UTC);
+	vec_resize(dst, n);
+	for(int i = 0;i < n;++i)
+	{
+		half_element(vec_get(src, i), vec_at(dst, i), NULL);
+	}
+	const double serial_time = elapsed_ms(&start);
+
+	timespec_get(&start, TIME_UTC);
+	vec_parallel_map(src, dst, half_element, NULL);
+	const double parallel_time = elapsed_ms(&start);
+
+	printf("Map time: %f ms, in parallel (%u threads): %f ms\n", serial_time, vec_pool_default()->size, parallel_time);
+
+	vec_free(dst);
+	vec_free(src);
+}
+
+void time_bulk_copy(int n)
+{
+	vector* src = veci_create();
+	vector* dst = veci_create();
+	struct timespec start;
+
+	veci_resize_val(dst, n, 0);
+
+	timespec_get(&start, TIME_UTC);
+	veci_resize_val(src, n, 1);
+	const double fill_time = elapsed_ms(&start);
+
+	timespec_get(&start, TIME_UTC);
+	memcpy(dst->buffer, src->buffer, n* sizeof(int));
+	const double memcpy_time = elapsed_ms(&start);
+
+	timespec_get(&start, TIME_UTC);
+	vec_cpy(src, dst, 0, n, 0);
+	const double cpy_time = elapsed_ms(&start);
+
+	printf("Resize val time: %f ms, memcpy: %f ms, vec_cpy: %f ms\n", fill_time, memcpy_time, cpy_time);
+
+	vec_free(dst);
+	vec_free(src);
+}
+
+void time_snapshot(int n)
+{
+	vector* vec = vecd_create();
+	vector* read = vecd_create();
+	struct timespec start;
+
+	for(int i = 0;i < n;++i)
+	{
+		vecd_push_back(vec, i / 16.0);
+	}
+
+	FILE* file = tmpfile();
+
+	timespec_get(&start, TIME_UTC);
+	vec_snapshot_write(vec, file);
+	const double write_time = elapsed_ms(&start);
+	const long bytes = ftell(file);
+
+	rewind(file);
+	timespec_get(&start, TIME_UTC);
+	vec_snapshot_read(read, file);
+	const double read_time = elapsed_ms(&start);
+
+	printf("Snapshot write time: %f ms, read time: %f ms, ratio: %f\n", write_time, read_time,
+		(double)(n* sizeof(double)) / bytes);
+
+	fclose(file);
+	vec_free(read);
+	vec_free(vec);
+}
+
+void time_mpvec_push_back(int n)
+{
+	for(int nthreads = 1;nthreads <= 64;nthreads *= 2)
+	{
+		mpvector* mpv = mpvec_create(sizeof(int));
+		vector* vec = veci_create();
+
+		const double mp_time = run_push_tasks(mpvec_push_task, mpv, NULL, nthreads, n);
+		const double locked_time = run_push_tasks(locked_push_task, NULL, vec, nthreads, n);
+
+		printf("Concurrent Push Back time (%i threads): %f ms, with mutex: %f ms\n", nthreads, mp_time, locked_time);
+
+		vec_free(vec);
+		mpvec_free(mpv);
+	}
+}
+
+int main()
+{
+	simple_test();
+	dup_test();
+	view_test();
+	zvector_test();
+	svector_test();
+	pvector_test();
+	mpvector_test();
+	cvector_test();
+	queue_test();
+	parallel_test();
+	sharded_test();
+	numa_test();
+	io_test();
+	mapped_test();
+	adopt_test();
+	loader_test();
+	snapshot_test();
+	shm_test();
+	parse_test();
+	stats_test();
+	registry_test();
+	hist_test();
+	accessors_test();
+
+	// Vector operations are measured by the benchmarks of the bench directory
+	const int n = 100000;
+
+	time_mpvec_push_back(n* 10);
+	time_queues(n* 10);
+	time_parallel_map(n* 10);
+	time_bulk_copy(n* 100);
+	time_snapshot(n* 10);
 
-	system("pause");
 	return 0;
 }